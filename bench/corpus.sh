@@ -0,0 +1,68 @@
+#!/bin/bash
+
+# Print a generated Lisp program of the given shape and size, used by
+# bench/scaling.sh to measure how the compiler scales
+#   forms <n>  n top-level forms
+#   defuns <n> n functions, each calling the one before it
+#   list <n>   a quoted list of n elements
+#   let <n>    n nested let forms, each binding one more variable
+#   nest <n>   an arithmetic expression nested n deep
+usage="Usage: bench/corpus.sh forms|defuns|list|let|nest <size>"
+
+kind="$1"
+size="$2"
+if [[ ! "$size" =~ ^[0-9]+$ ]]; then
+    echo "$usage" >&2
+    exit 1
+fi
+
+case "$kind" in
+    "forms")
+        awk -v n="$size" 'BEGIN {
+            for (i = 0; i < n; i++)
+                printf "(print (+ %d (* %d 2)))\n", i, i
+        }'
+        ;;
+    "defuns")
+        awk -v n="$size" 'BEGIN {
+            print "(defun f0 (x) x)"
+            for (i = 1; i < n; i++)
+                printf "(defun f%d (x) (+ (f%d x) %d))\n", i, i - 1, i
+            printf "(print (f%d 1))\n", n - 1
+        }'
+        ;;
+    "list")
+        awk -v n="$size" 'BEGIN {
+            printf "(print (length \047(0"
+            for (i = 1; i < n; i++)
+                printf (i % 20 == 0 ? "\n%d" : " %d"), i
+            print ")))"
+        }'
+        ;;
+    "let")
+        awk -v n="$size" 'BEGIN {
+            print "(let ((v0 0))"
+            for (i = 1; i < n; i++)
+                printf "(let ((v%d (+ v%d 1)))\n", i, i - 1
+            printf "(print v%d)", n - 1
+            for (i = 0; i < n; i++)
+                printf ")"
+            print ""
+        }'
+        ;;
+    "nest")
+        awk -v n="$size" 'BEGIN {
+            printf "(print "
+            for (i = 0; i < n; i++)
+                printf (i % 20 == 19 ? "(+ 1\n" : "(+ 1 ")
+            printf "0"
+            for (i = 0; i < n; i++)
+                printf ")"
+            print ")"
+        }'
+        ;;
+    *)
+        echo "$usage" >&2
+        exit 1
+        ;;
+esac
@@ -0,0 +1,29 @@
+; deriv : symbolic differentiation
+; expressions : (0) is x, (1 c) is a constant, (2 a b) is a + b, (3 a b) is a * b
+(defun tag (e) (car e))
+(defun arg1 (e) (car (cdr e)))
+(defun arg2 (e) (car (cdr (cdr e))))
+
+(defun deriv (e)
+  (if (= (tag e) 0)
+      (list 1 1)
+      (if (= (tag e) 1)
+          (list 1 0)
+          (if (= (tag e) 2)
+              (list 2 (deriv (arg1 e)) (deriv (arg2 e)))
+              (list 2
+                    (list 3 (deriv (arg1 e)) (arg2 e))
+                    (list 3 (arg1 e) (deriv (arg2 e))))))))
+
+(defun size (e)
+  (if (< (tag e) 2)
+      1
+      (+ 1 (+ (size (arg1 e)) (size (arg2 e))))))
+
+; x * (x * (... * 5 + 1) + 2) + n
+(defun poly (n)
+  (if (= n 0)
+      (list 1 5)
+      (list 2 (list 3 (list 0) (poly (- n 1))) (list 1 n))))
+
+(print (size (deriv (poly 8))))
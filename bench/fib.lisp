@@ -0,0 +1,7 @@
+; fib : doubly recursive fibonacci
+(defun fib (n)
+  (if (< n 2)
+      n
+      (+ (fib (- n 1)) (fib (- n 2)))))
+
+(print (fib 26))
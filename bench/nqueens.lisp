@@ -0,0 +1,23 @@
+; nqueens : count the solutions of the 8 queens problem
+; placed holds the rows of the queens in the previous columns
+(defun safe (row dist placed)
+  (if (null placed)
+      t
+      (if (= (car placed) (+ row dist))
+          nil
+          (if (= (car placed) (- row dist))
+              nil
+              (if (= (car placed) row)
+                  nil
+                  (safe row (+ dist 1) (cdr placed)))))))
+
+; try every row from row to n - 1 in column col
+(defun queens (n col placed row)
+  (if (= col n)
+      1
+      (if (= row n)
+          0
+          (+ (if (safe row 1 placed) (queens n (+ col 1) (cons row placed) 0) 0)
+             (queens n col placed (+ row 1))))))
+
+(print (queens 8 0 nil 0))
@@ -0,0 +1,7 @@
+; numeric_loop : accumulate the first 4000 odd numbers
+(defun oddsum (i n acc)
+  (if (= i n)
+      acc
+      (oddsum (+ i 1) n (+ acc (- (* 2 i) 1)))))
+
+(print (oddsum 1 4001 0))
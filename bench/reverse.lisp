@@ -0,0 +1,22 @@
+; reverse : list construction with append and reverse
+(defun app (a b)
+  (if (null a)
+      b
+      (cons (car a) (app (cdr a) b))))
+
+(defun rev (l acc)
+  (if (null l)
+      acc
+      (rev (cdr l) (cons (car l) acc))))
+
+(defun iota (n)
+  (if (= n 0)
+      nil
+      (cons n (iota (- n 1)))))
+
+(defun sum (l)
+  (if (null l)
+      0
+      (+ (car l) (sum (cdr l)))))
+
+(print (sum (app (rev (iota 15) nil) (iota 15))))
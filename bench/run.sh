@@ -0,0 +1,97 @@
+#!/bin/bash
+
+# Directories
+BENCH_DIR="bench"
+COMPILER="./lisp-compiler"
+COMMON_LISP_COMPILER="sbcl --script"
+
+# Number of runs per benchmark, the median is reported
+RUNS="${1:-5}"
+
+# Run a command with its output redirected to $1 and print "<wall ms> <peak rss kb>"
+measure() {
+    local output_file="$1"
+    shift
+    if [[ -x /usr/bin/time ]]; then
+        local start end
+        start=$(date +%s%N)
+        /usr/bin/time -f "%M" -o "$output_file.rss" "$@" >"$output_file" 2>/dev/null || return 1
+        end=$(date +%s%N)
+        echo "$(((end - start) / 1000000)) $(tail -n 1 "$output_file.rss")"
+        rm -f "$output_file.rss"
+    else
+        python3 - "$output_file" "$@" <<'EOF' || return 1
+import resource, subprocess, sys, time
+with open(sys.argv[1], "w") as out:
+    start = time.perf_counter()
+    status = subprocess.call(sys.argv[2:], stdout=out, stderr=subprocess.DEVNULL)
+    elapsed = time.perf_counter() - start
+if status != 0:
+    sys.exit(1)
+print(int(elapsed * 1000), resource.getrusage(resource.RUSAGE_CHILDREN).ru_maxrss)
+EOF
+    fi
+}
+
+# Median of the numbers given as arguments
+median() {
+    printf "%s\n" "$@" | sort -n | sed -n "$((($# + 1) / 2))p"
+}
+
+# Run a command $RUNS times and print "<median wall ms> <peak rss kb>"
+bench() {
+    local output_file="$1"
+    shift
+    local times=() peak=0 result
+    for ((i = 0; i < RUNS; i++)); do
+        result=$(measure "$output_file" "$@") || return 1
+        times+=("${result% *}")
+        ((${result#* } > peak)) && peak=${result#* }
+    done
+    echo "$(median "${times[@]}") $peak"
+}
+
+use_sbcl=false
+command -v sbcl &>/dev/null && use_sbcl=true
+
+if $use_sbcl; then
+    printf "%-16s %12s %12s %12s %12s %8s\n" "benchmark" "time (ms)" "rss (kb)" "sbcl (ms)" "sbcl (kb)" "output"
+else
+    printf "%-16s %12s %12s\n" "benchmark" "time (ms)" "rss (kb)"
+fi
+
+for file in "$BENCH_DIR"/*.lisp; do
+    [[ -f "$file" ]] || continue
+    name=$(basename "$file" .lisp)
+    output_file="$file.out"
+    rm -f "$output_file"
+
+    if ! "$COMPILER" "$file" &>/dev/null; then
+        echo "[FAIL] Compilation failed: $file"
+        continue
+    fi
+
+    if ! result=$(bench "$output_file.actual" "$output_file"); then
+        echo "[FAIL] Execution failed: $file"
+        rm -f "$output_file" "$output_file.actual"
+        continue
+    fi
+
+    if $use_sbcl; then
+        # shellcheck disable=SC2086
+        sbcl_result=$(bench "$output_file.expected" $COMMON_LISP_COMPILER "$file") || sbcl_result="- -"
+        if diff -wB "$output_file.expected" "$output_file.actual" &>/dev/null; then
+            match="ok"
+        else
+            match="mismatch"
+        fi
+        printf "%-16s %12s %12s %12s %12s %8s\n" "$name" ${result} ${sbcl_result} "$match"
+    else
+        printf "%-16s %12s %12s\n" "$name" ${result}
+    fi
+
+    # Clean up
+    rm -f "$output_file" "$output_file.actual" "$output_file.expected"
+done
+
+rm -f "$BENCH_DIR/output.s"
@@ -0,0 +1,97 @@
+#!/bin/bash
+
+# Compile generated programs of increasing size and check that every phase of
+# the compiler grows about linearly with it, in time and in memory
+#   bench/scaling.sh [largest size]
+# The sizes go from 100 to the largest size (default 100000) by factors of 10,
+# the nesting depths from 250 to at most 4000 by factors of 2. Only the
+# compiler itself is measured, g++ is not run.
+
+COMPILER="./lisp-compiler"
+CORPUS="bench/corpus.sh"
+
+# The largest growth exponent accepted, 1 is linear and 2 quadratic
+LIMIT="${LIMIT:-1.4}"
+# Shorter phases (ms) and smaller memory growth (kb) are only noise
+MIN_MS=5
+MIN_KB=1024
+
+max="${1:-100000}"
+work=$(mktemp -d)
+status=0
+
+# Print "<phase> <wall ms>" for each phase, and "memory <peak rss kb>"
+measure() {
+    "$COMPILER" --time-passes --emit-cpp "$1" 2>&1 >/dev/null |
+        awk '$1 ~ /^(preprocess|tokenize|parse|generate)$/ { print $1, $2 }
+             $1 == "peak" { print "memory", $4 }'
+}
+
+# Print the least squares slope of log(y) against log(x), "x y" per line,
+# over the lines where y is at least $1, nothing if there are less than two
+exponent() {
+    awk -v min="$1" '$2 >= min { x = log($1); y = log($2); n++
+                                 sx += x; sy += y; sxx += x * x; sxy += x * y }
+         END { if (n >= 2) printf "%.2f", (n * sxy - sx * sy) / (n * sxx - sx * sx) }'
+}
+
+# Check a kind of program over the sizes given as arguments
+check() {
+    local kind="$1"
+    shift
+    local file="$work/$kind.lisp" size base=0 failed=""
+    rm -f "$work"/*.txt
+    for size in "$@"; do
+        "$CORPUS" "$kind" "$size" >"$file"
+        if ! measure "$file" >"$work/result" || [[ ! -s "$work/result" ]]; then
+            echo "[FAIL] Compilation failed: $kind $size"
+            status=1
+            return
+        fi
+        while read -r phase value; do
+            # the memory of the compiler without a program is not growth
+            if [[ "$phase" == "memory" ]]; then
+                ((base == 0)) && base=$value
+                value=$((value - base + 1))
+            fi
+            echo "$size $value" >>"$work/$phase.txt"
+        done <"$work/result"
+    done
+    local phase slope
+    for phase in preprocess tokenize parse generate memory; do
+        if [[ "$phase" == "memory" ]]; then
+            slope=$(exponent "$MIN_KB" <"$work/$phase.txt")
+        else
+            slope=$(exponent "$MIN_MS" <"$work/$phase.txt")
+        fi
+        if [[ -n "$slope" ]] &&
+            awk -v slope="$slope" -v limit="$LIMIT" 'BEGIN { exit !(slope > limit) }'; then
+            failed+=" $phase n^$slope"
+        fi
+    done
+    if [[ -z "$failed" ]]; then
+        echo "[PASS] Linear growth: $kind up to ${*: -1}"
+    else
+        echo "[FAIL] Superlinear growth: $kind$failed"
+        status=1
+    fi
+}
+
+sizes=()
+for ((size = 100; size <= max; size *= 10)); do
+    sizes+=("$size")
+done
+depths=()
+for ((depth = 250; depth <= max && depth <= 4000; depth *= 2)); do
+    depths+=("$depth")
+done
+
+for kind in forms defuns list; do
+    check "$kind" "${sizes[@]}"
+done
+for kind in let nest; do
+    check "$kind" "${depths[@]}"
+done
+
+rm -rf "$work"
+exit $status
@@ -0,0 +1,9 @@
+; tak : takeuchi function, dominated by function calls
+(defun tak (x y z)
+  (if (not (< y x))
+      z
+      (tak (tak (- x 1) y z)
+           (tak (- y 1) z x)
+           (tak (- z 1) x y))))
+
+(print (tak 9 6 2))
@@ -61,3 +61,26 @@ void parser::ast::printAST(const std::shared_ptr<ASTNode> &node, int indent) {
   }
   }
 }
+
+std::size_t parser::ast::countAST(const std::shared_ptr<ASTNode> &node) {
+  std::size_t count = 1;
+  switch (node->getType()) {
+  case NodeType::Program:
+    for (const auto &expression :
+         std::static_pointer_cast<ProgramNode>(node)->getExpressions())
+      count += countAST(expression);
+    break;
+  case NodeType::List:
+    for (const auto &expression :
+         std::static_pointer_cast<ListNode>(node)->getExpressions())
+      count += countAST(expression);
+    break;
+  case NodeType::Quoted:
+    count += countAST(
+        std::static_pointer_cast<QuotedNode>(node)->getExpression());
+    break;
+  default:
+    break;
+  }
+  return count;
+}
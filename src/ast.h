@@ -1,5 +1,6 @@
 #ifndef AST_H
 #define AST_H
+#include <cstddef>
 #include <memory>
 #include <string>
 #include <utility>
@@ -22,9 +23,19 @@ class ASTNode {
 public:
   explicit ASTNode(const NodeType type) : _type(type) {}
   [[nodiscard]] NodeType getType() const { return _type; }
+  // where the node starts in the source, from 1, 0 for a node made by the
+  // compiler
+  void setPosition(const std::size_t line, const std::size_t column) {
+    _line = line;
+    _column = column;
+  }
+  [[nodiscard]] std::size_t getLine() const { return _line; }
+  [[nodiscard]] std::size_t getColumn() const { return _column; }
 
 private:
   NodeType _type;
+  std::size_t _line = 0;
+  std::size_t _column = 0;
 };
 
 class ProgramNode final : public ASTNode {
@@ -47,13 +58,15 @@ public:
   explicit ExpressionNode(const NodeType type) : ASTNode(type) {}
 };
 
+// integers are kept as decimal text since they may not fit in a fixnum
 class IntegerNode final : public ExpressionNode {
 public:
-  explicit IntegerNode(const int value)
-      : ExpressionNode(NodeType::Integer), _value(value) {}
-  [[nodiscard]] int getValue() const { return _value; }
+  explicit IntegerNode(std::string value)
+      : ExpressionNode(NodeType::Integer), _value(std::move(value)) {}
+  [[nodiscard]] const std::string &getValue() const { return _value; }
+
 private:
-  int _value;
+  std::string _value;
 };
 
 class FloatingNode final : public ExpressionNode {
@@ -124,6 +137,7 @@ private:
 };
 
 void printAST(const std::shared_ptr<ASTNode> &node, int indent = 0);
+std::size_t countAST(const std::shared_ptr<ASTNode> &node);
 
 } // namespace parser::ast
 
@@ -0,0 +1,192 @@
+#include "build.h"
+#include "cache.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+
+bool driver::runAll(const std::vector<std::string> &commands,
+                    const unsigned jobs) {
+  std::atomic<std::size_t> next = 0;
+  std::atomic<bool> succeeded = true;
+  const auto work = [&] {
+    for (std::size_t i = next++; i < commands.size(); i = next++)
+      if (std::system(commands[i].c_str()) != 0)
+        succeeded = false;
+  };
+  std::vector<std::thread> threads;
+  const std::size_t count =
+      std::min<std::size_t>(std::max(jobs, 1u), commands.size());
+  for (std::size_t i = 1; i < count; i++)
+    threads.emplace_back(work);
+  work();
+  for (auto &thread : threads)
+    thread.join();
+  return succeeded;
+}
+
+void driver::update(const std::filesystem::path &path, std::string content) {
+  // a resume line becomes the directive numbering the line after it as its
+  // own line of the file
+  std::size_t line = 1, counted = 0;
+  for (std::size_t pos = 0;
+       (pos = content.find(generator::resume_line, pos)) != std::string::npos;) {
+    line += std::count(content.begin() + counted, content.begin() + pos, '\n');
+    const std::string directive =
+        generator::lineDirective(line + 1, path.string());
+    content.replace(pos, generator::resume_line.size(), directive);
+    pos += directive.size();
+    counted = pos;
+    line++;
+  }
+  if (std::ifstream file(path); file.is_open()) {
+    const std::string old((std::istreambuf_iterator<char>(file)),
+                          std::istreambuf_iterator<char>());
+    if (old == content)
+      return;
+  }
+  std::ofstream out(path);
+  if (!out)
+    throw std::ios_base::failure("Failed to open output file: " +
+                                 path.string());
+  out << content;
+}
+
+std::string driver::optimizationFlags(const Optimization optimization) {
+  // the fat objects keep the machine code, for the assembly and for linking
+  // without link time optimization
+  if (optimization == Optimization::Release)
+    return "-O3 -march=native -flto=auto -ffat-lto-objects";
+  return "-O2";
+}
+
+// g++ compiles each file once, to the assembly that is both kept and
+// assembled for the link
+void driver::buildProgram(const std::vector<std::filesystem::path> &sources,
+                          const std::string &executable,
+                          const std::vector<modules::Interface> &units,
+                          const std::filesystem::path &assembly,
+                          const std::string &flags,
+                          const std::optional<std::string> &training,
+                          const unsigned jobs, report::Report &report) {
+  std::vector<std::filesystem::path> assemblies;
+  for (const auto &source : sources) {
+    auto path = source;
+    path.replace_extension(".s");
+    assemblies.push_back(path);
+  }
+  const auto remove = [&](const std::string &extension) {
+    for (auto path : assemblies)
+      std::filesystem::remove(path.replace_extension(extension));
+  };
+  // compile and link with the flags of the build and extra ones, false if g++
+  // failed
+  const auto build = [&](const std::string &extra) {
+    std::vector<std::string> compile_commands;
+    std::string link_command =
+        "g++ " + flags + extra + " -pthread -o " + executable;
+    for (std::size_t i = 0; i < sources.size(); i++) {
+      compile_commands.push_back("g++ " + flags + extra +
+                                 " -pthread -masm=att -S -o " +
+                                 assemblies[i].string() + " " +
+                                 sources[i].string());
+      link_command += " " + assemblies[i].string();
+    }
+    for (const auto &unit : units)
+      link_command += " " + unit.object;
+    return report.time("compile",
+                       [&] { return runAll(compile_commands, jobs); }) &&
+           report.time("link", [&] {
+             return std::system(link_command.c_str());
+           }) == 0;
+  };
+
+  const auto fail = [&](const std::string &message) {
+    remove(".s");
+    remove(".gcda");
+    throw std::runtime_error(message);
+  };
+
+  // profile guided optimization: the instrumented build writes the counters
+  // of the training run, one .gcda file next to each assembly, that guide the
+  // final build
+  std::string extra;
+  if (training) {
+    if (!build(" -fprofile-generate"))
+      fail("Compilation failed");
+    const std::string command =
+        training->empty()
+            ? std::filesystem::absolute(executable).string() + " >/dev/null"
+            : *training;
+    if (report.time("train",
+                    [&] { return std::system(command.c_str()); }) != 0)
+      fail("Training run failed: " + command);
+    extra = " -fprofile-use -fprofile-correction -Wno-missing-profile";
+  }
+  if (!build(extra))
+    fail("Compilation failed");
+  remove(".gcda");
+
+  std::ofstream out(assembly);
+  if (!out)
+    throw std::ios_base::failure("Failed to open output file: " +
+                                 assembly.string());
+  for (const auto &path : assemblies)
+    out << std::ifstream(path).rdbuf();
+  remove(".s");
+}
+
+std::vector<std::string>
+driver::buildIncremental(const generator::Split &split,
+                         const std::filesystem::path &directory,
+                         const std::string &executable,
+                         const std::vector<modules::Interface> &units,
+                         const std::string &flags, const unsigned jobs,
+                         report::Report &report) {
+  std::filesystem::create_directories(directory);
+  const std::string graph_path = (directory / "graph").string();
+  const auto previous = cache::readGraph(graph_path);
+  const auto current = cache::makeGraph(split, flags);
+  const auto stale = cache::stale(previous, current, directory.string());
+
+  report.time("write", [&] {
+    update(directory / "lisp.h", split.header);
+    for (const auto &unit : split.units)
+      if (std::find(stale.begin(), stale.end(), unit.name) != stale.end())
+        update(directory / (unit.name + ".cpp"),
+               "#include \"lisp.h\"\n\n" + unit.code);
+    for (const auto &[name, entry] : previous.units)
+      if (!current.units.contains(name)) {
+        std::filesystem::remove(directory / (name + ".cpp"));
+        std::filesystem::remove(directory / (name + ".o"));
+      }
+  });
+
+  // until they are compiled, the stale units are left out of the graph, so
+  // that a failed build does not keep their old objects
+  cache::Graph valid = current;
+  for (const auto &name : stale)
+    valid.units.erase(name);
+  cache::writeGraph(graph_path, valid);
+
+  std::vector<std::string> compile_commands;
+  for (const auto &name : stale)
+    compile_commands.push_back("g++ " + flags + " -pthread -c -o " +
+                               (directory / (name + ".o")).string() + " " +
+                               (directory / (name + ".cpp")).string());
+  std::string link_command = "g++ " + flags + " -pthread -o " + executable;
+  for (const auto &unit : split.units)
+    link_command += " " + (directory / (unit.name + ".o")).string();
+  for (const auto &unit : units)
+    link_command += " " + unit.object;
+  if (!report.time("compile",
+                   [&] { return runAll(compile_commands, jobs); }) ||
+      report.time("link", [&] { return std::system(link_command.c_str()); }) !=
+          0)
+    throw std::runtime_error("Compilation failed");
+  cache::writeGraph(graph_path, current);
+  return stale;
+}
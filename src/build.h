@@ -0,0 +1,51 @@
+#ifndef BUILD_H
+#define BUILD_H
+#include "generator.h"
+#include "module.h"
+#include "options.h"
+#include "report.h"
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace driver {
+
+// run the shell commands, at most jobs of them at a time, returns true if
+// all of them succeeded
+bool runAll(const std::vector<std::string> &commands, unsigned jobs);
+
+// write a file unless it already has this content, the resume lines of
+// generated code become #line directives pointing back to the file
+void update(const std::filesystem::path &path, std::string content);
+
+// the g++ flags of an optimization profile, for compiling and linking
+std::string optimizationFlags(Optimization optimization);
+
+// compile the files of a program to assembly, then assemble and link them
+// with the object files of its modules, the assembly of all the files is
+// written to assembly; with a training command, an instrumented build is run
+// by it first (the executable itself if it is empty) and its profile guides
+// the build; throws std::runtime_error if g++ or the training run fails
+void buildProgram(const std::vector<std::filesystem::path> &sources,
+                  const std::string &executable,
+                  const std::vector<modules::Interface> &units,
+                  const std::filesystem::path &assembly,
+                  const std::string &flags,
+                  const std::optional<std::string> &training, unsigned jobs,
+                  report::Report &report);
+
+// compile the units of the program that changed since the last build, each
+// to an object file next to its code in the cache directory, then link them
+// all, returns the names of the units compiled
+std::vector<std::string>
+buildIncremental(const generator::Split &split,
+                 const std::filesystem::path &directory,
+                 const std::string &executable,
+                 const std::vector<modules::Interface> &units,
+                 const std::string &flags, unsigned jobs,
+                 report::Report &report);
+
+} // namespace driver
+
+#endif // BUILD_H
@@ -0,0 +1,107 @@
+#include "cache.h"
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+std::string cache::hash(const std::string &text) {
+  std::uint64_t value = 14695981039346656037ull;
+  for (const auto c : text) {
+    value ^= static_cast<unsigned char>(c);
+    value *= 1099511628211ull;
+  }
+  std::ostringstream out;
+  out << std::hex << value;
+  return out.str();
+}
+
+cache::Graph cache::makeGraph(const generator::Split &split,
+                              const std::string &flags) {
+  Graph graph;
+  graph.prelude = hash(split.prelude + flags);
+  for (const auto &[name, declaration] : split.declarations)
+    graph.declarations[name] = hash(declaration);
+  for (const auto &unit : split.units)
+    graph.units[unit.name] = {hash(unit.code), unit.calls};
+  return graph;
+}
+
+// format, one entry per line:
+//   lisp-cache 1
+//   prelude <hash>
+//   declaration <generated name> <hash>
+//   unit <name> <hash> <called function>...
+cache::Graph cache::readGraph(const std::string &path) {
+  Graph graph;
+  std::ifstream file(path);
+  if (!file.is_open())
+    return graph;
+  std::string line;
+  if (!std::getline(file, line) || line != "lisp-cache 1")
+    throw std::runtime_error("Invalid cache: " + path);
+  while (std::getline(file, line)) {
+    std::istringstream in(line);
+    std::string kind, name;
+    in >> kind;
+    if (kind == "prelude") {
+      in >> graph.prelude;
+    } else if (kind == "declaration") {
+      in >> name;
+      in >> graph.declarations[name];
+    } else if (kind == "unit") {
+      in >> name;
+      auto &entry = graph.units[name];
+      in >> entry.hash;
+      for (std::string call; in >> call;)
+        entry.calls.push_back(call);
+      in.clear();
+    } else if (!kind.empty()) {
+      throw std::runtime_error("Invalid cache: " + path);
+    }
+    if (in.fail())
+      throw std::runtime_error("Invalid cache: " + path);
+  }
+  return graph;
+}
+
+void cache::writeGraph(const std::string &path, const Graph &graph) {
+  std::ofstream out(path);
+  if (!out)
+    throw std::ios_base::failure("Failed to open output file: " + path);
+  out << "lisp-cache 1\n";
+  out << "prelude " << graph.prelude << "\n";
+  for (const auto &[name, hash] : graph.declarations)
+    out << "declaration " << name << " " << hash << "\n";
+  for (const auto &[name, entry] : graph.units) {
+    out << "unit " << name << " " << entry.hash;
+    for (const auto &call : entry.calls)
+      out << " " << call;
+    out << "\n";
+  }
+}
+
+// a unit only sees the functions it calls through their declarations, whose
+// member functions are inlined into it, so editing the body of a function
+// leaves its callers alone
+std::vector<std::string> cache::stale(const Graph &previous,
+                                      const Graph &current,
+                                      const std::string &directory) {
+  std::vector<std::string> result;
+  for (const auto &[name, entry] : current.units) {
+    const auto before = previous.units.find(name);
+    bool changed = previous.prelude != current.prelude ||
+                   before == previous.units.end() ||
+                   before->second.hash != entry.hash ||
+                   !std::filesystem::exists(std::filesystem::path(directory) /
+                                            (name + ".o"));
+    for (const auto &call : entry.calls) {
+      const auto declaration = previous.declarations.find(call);
+      changed = changed || declaration == previous.declarations.end() ||
+                declaration->second != current.declarations.at(call);
+    }
+    if (changed)
+      result.push_back(name);
+  }
+  return result;
+}
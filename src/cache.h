@@ -0,0 +1,41 @@
+#ifndef CACHE_H
+#define CACHE_H
+#include "generator.h"
+#include <map>
+#include <string>
+#include <vector>
+
+namespace cache {
+
+// the units of a split program with what they depend on, kept in the cache
+// directory between builds
+struct Graph {
+  // hash of the header without the declarations and of the g++ flags
+  std::string prelude;
+  // hash of the declaration of every function by generated name
+  std::map<std::string, std::string> declarations;
+  struct Entry {
+    std::string hash;               // hash of the code of the unit
+    std::vector<std::string> calls; // generated names of the functions called
+  };
+  std::map<std::string, Entry> units; // by name
+};
+
+// 64 bit FNV-1a in hexadecimal, stable between runs of the compiler
+std::string hash(const std::string &text);
+
+Graph makeGraph(const generator::Split &split, const std::string &flags);
+// an empty graph if the file is missing, throw std::runtime_error if it is
+// malformed
+Graph readGraph(const std::string &path);
+void writeGraph(const std::string &path, const Graph &graph);
+
+// the units to compile again: the new and edited ones, the ones calling a
+// function whose declaration changed, and every unit if the runtime or the
+// flags changed
+std::vector<std::string> stale(const Graph &previous, const Graph &current,
+                               const std::string &directory);
+
+} // namespace cache
+
+#endif // CACHE_H
@@ -1,15 +1,29 @@
 #include "generator.h"
+#include "cache.h"
 #include "template.h"
+#include <algorithm>
 #include <cassert>
+#include <charconv>
+#include <climits>
 #include <fstream>
 #include <iostream>
 
 generator::Value generator::Scope::get(const std::string &name) {
   if (_symbols.contains(name))
     return _symbols[name];
-  if (_parent)
-    return _parent->get(name);
-  throw std::runtime_error("Symbol not found: " + name);
+  if (!_parent)
+    throw std::runtime_error("Symbol not found: " + name);
+  Value value = _parent->get(name);
+  // a lambda copies the variables it refers to into its environment
+  if (_closure && value._type == ValueType::Expression) {
+    _captures.emplace_back(name, value);
+    const NativeType native = value._native;
+    value = Value(ValueType::Expression,
+                  "CAPTURED(" + std::to_string(_captures.size() - 1) + ")");
+    value._native = native;
+    _symbols[name] = value;
+  }
+  return value;
 }
 
 void generator::Scope::set(const std::string &name, const Value &value,
@@ -24,11 +38,133 @@ void generator::Scope::set(const std::string &name, const Value &value,
 
 std::string generator::Generator::generate() {
   _scope = std::make_shared<Scope>(nullptr);
-  generateProgram(_ast);
-  auto content = code_template;
+  _global = _scope;
+  // the functions of the imported modules are called through the symbols
+  // of their apply functions
+  for (const auto &unit : _config.imports)
+    for (const auto &function : unit.exports) {
+      const std::string generated_name = "I_" + function.symbol;
+      Value value(ValueType::Function, generated_name);
+      value._arity = function.arity;
+      value._kinds = function.kinds;
+      _global->set(function.name, value);
+      if (function.effects.find('p') != std::string::npos)
+        _printing.insert(generated_name);
+      else if (function.effects.find('s') != std::string::npos)
+        _impure.insert(generated_name);
+      _linkage += "IMPORT_FUNCTION(" + function.symbol + ")\n";
+      _declarations.emplace_back(
+          generated_name, "IMPORT(" + generated_name + "," + function.symbol +
+                              ",\"" + function.name + "\"," +
+                              std::to_string(function.arity) + ");\n");
+    }
+  // an error starts with the file and line of the innermost form being
+  // generated, left in _current by the unwinding
+  try {
+    generateProgram(_ast);
+  } catch (const std::runtime_error &e) {
+    throw std::runtime_error(location() + e.what());
+  }
+  // a module exports its functions and an initializer running its forms,
+  // a program initializes every module before running its own forms
+  if (!_config.module.empty()) {
+    for (const auto &[generated_name, function] : _defined)
+      _entry += "EXPORT(" + generated_name + "," + function.symbol + ")\n";
+    _entry += "MODULE_INIT(" + modules::initializer(_config.module) + ")\n";
+  } else {
+    _entry += "INITIALIZE(";
+    for (const auto &unit : _config.modules) {
+      _linkage += "IMPORT_MODULE(" + modules::initializer(unit.name) + ")\n";
+      _entry += modules::initializer(unit.name) + "();";
+    }
+    _entry += ")\n";
+  }
+  // every function is declared before the definitions, which may call any
+  std::string definitions;
+  for (const auto &[generated_name, declaration] : _declarations)
+    definitions += declaration;
+  for (const auto &unit : _units)
+    definitions += unit.code;
+  definitions += _wrappers;
+  definitions += _definitions;
+  return defines() + fill(code_template, _linkage, definitions);
+}
+
+// the header holds the runtime and the declarations, the code of the program
+// after them in the template goes to the unit of the top-level forms
+generator::Split generator::Generator::getSplit() const {
+  const std::string code = code_template;
+  const std::size_t program = code.find("#pragma region Program");
+  Split split;
+  split.prelude = defines() + "#define LISP_NAMESPACE lisp_program\n" +
+                  code.substr(0, program) + _linkage;
+  split.header = split.prelude + "\ninline namespace LISP_NAMESPACE {\n\n";
+  for (const auto &[generated_name, declaration] : _declarations)
+    split.header += declaration;
+  split.header += "\n} // namespace\n";
+  split.declarations = _declarations;
+  for (const auto &unit : _units)
+    split.units.push_back({unit.name,
+                           "inline namespace LISP_NAMESPACE {\n\n" + unit.code +
+                               "\n} // namespace\n",
+                           unit.calls});
+  split.units.push_back(
+      {"program",
+       fill(code.substr(program), "", _wrappers + _definitions),
+       std::vector(_calls.begin(), _calls.end())});
+  return split;
+}
+
+// the largest units first, each in the smallest file so far
+std::vector<std::string> generator::partition(const Split &split,
+                                              const std::size_t count) {
+  std::vector<const Unit *> units;
+  for (const auto &unit : split.units)
+    units.push_back(&unit);
+  std::stable_sort(units.begin(), units.end(),
+                   [](const Unit *a, const Unit *b) {
+                     return a->code.size() > b->code.size();
+                   });
+  std::vector<std::string> files(std::max<std::size_t>(count, 1));
+  for (const auto *unit : units)
+    std::min_element(files.begin(), files.end(),
+                     [](const std::string &a, const std::string &b) {
+                       return a.size() < b.size();
+                     })
+        ->append(unit->code);
+  return files;
+}
+
+// the flags of the runtime
+std::string generator::Generator::defines() const {
+  std::string defines;
+  if (!_config.module.empty())
+    defines += "#define LISP_MODULE\n";
+  if (_config.safety == 0)
+    defines += "#define LISP_UNSAFE\n";
+  if (_config.profile)
+    defines += "#define LISP_PROFILE\n";
+  return defines;
+}
+
+std::string generator::Generator::fill(std::string content,
+                                       const std::string &linkage,
+                                       const std::string &definitions) const {
   size_t pos;
+  while ((pos = content.find("$3")) != std::string::npos) {
+    content.replace(pos, 2, std::to_string(_max_locals));
+  }
+  while ((pos = content.find("$4")) != std::string::npos) {
+    content.replace(pos, 2, std::to_string(_max_natives));
+  }
+  while ((pos = content.find("$5")) != std::string::npos) {
+    content.replace(pos, 2, linkage);
+  }
+  while ((pos = content.find("$6")) != std::string::npos) {
+    content.replace(pos, 2, _entry);
+  }
   while ((pos = content.find("$1")) != std::string::npos) {
-    content.replace(pos, 2, _header);
+    content.replace(pos, 2, definitions);
   }
   while ((pos = content.find("$2")) != std::string::npos) {
     content.replace(pos, 2, _body);
@@ -36,13 +172,342 @@ std::string generator::Generator::generate() {
   return content;
 }
 
+std::string generator::lineDirective(const std::size_t line,
+                                     const std::string &file) {
+  std::string directive = "#line " + std::to_string(line) + " \"";
+  for (const auto c : file) {
+    if (c == '"' || c == '\\')
+      directive += '\\';
+    directive += c;
+  }
+  return directive + "\"\n";
+}
+
+// the lines of code, ending with a newline, attributed to the line of the
+// form in the lisp source, for debuggers and profilers
+std::string
+generator::Generator::mapped(const std::shared_ptr<parser::ast::ASTNode> &ast,
+                             const std::string &code) const {
+  if (!_config.line_directives || ast->getLine() == 0)
+    return code;
+  return lineDirective(ast->getLine(), _config.source) + code + resume_line;
+}
+
+// file:line of a node, or else of the form being generated, before an error
+// message
+std::string
+generator::Generator::location(const parser::ast::ASTNode *ast) const {
+  if (!ast || ast->getLine() == 0)
+    ast = _current;
+  if (!ast || ast->getLine() == 0)
+    return "";
+  const std::string line = std::to_string(ast->getLine());
+  return _config.source.empty() ? "line " + line + ": "
+                                : _config.source + ":" + line + ": ";
+}
+
+std::vector<modules::Export> generator::Generator::getExports() const {
+  std::vector<modules::Export> exports;
+  for (const auto &[generated_name, function] : _defined)
+    exports.push_back(function);
+  return exports;
+}
+
+namespace {
+
+// the keyword at the head of a list, or an empty string
+std::string headKeyword(const std::shared_ptr<parser::ast::ASTNode> &ast) {
+  if (ast->getType() != parser::ast::NodeType::List)
+    return "";
+  const auto &expressions =
+      std::static_pointer_cast<parser::ast::ListNode>(ast)->getExpressions();
+  if (expressions.empty() ||
+      expressions.front()->getType() != parser::ast::NodeType::Keyword)
+    return "";
+  return std::static_pointer_cast<parser::ast::KeywordNode>(
+             expressions.front())
+      ->getValue();
+}
+
+// the type named in a declaration, or None for the types kept boxed
+generator::NativeType declaredType(const std::string &name) {
+  if (name == "fixnum")
+    return generator::NativeType::Fixnum;
+  if (name == "double-float")
+    return generator::NativeType::Double;
+  return generator::NativeType::None;
+}
+
+// the slot of a variable of the given type
+std::string nativeSlot(const generator::NativeType type,
+                       const std::size_t index) {
+  switch (type) {
+  case generator::NativeType::Fixnum:
+    return "FIXNUM_SLOT(" + std::to_string(index) + ")";
+  case generator::NativeType::Double:
+    return "DOUBLE_SLOT(" + std::to_string(index) + ")";
+  default:
+    return "LOCAL(" + std::to_string(index) + ")";
+  }
+}
+
+// check if a form contains a setq of a variable, not counting the forms
+// where a let, lambda, dotimes or dolist rebinds it
+bool assigns(const std::shared_ptr<parser::ast::ASTNode> &ast,
+             const std::string &name) {
+  if (ast->getType() != parser::ast::NodeType::List)
+    return false;
+  const auto &expressions =
+      std::static_pointer_cast<parser::ast::ListNode>(ast)->getExpressions();
+  const auto isName = [&](const std::shared_ptr<parser::ast::ASTNode> &node) {
+    return node->getType() == parser::ast::NodeType::Identifier &&
+           std::static_pointer_cast<parser::ast::IdentifierNode>(node)
+                   ->getValue() == name;
+  };
+  const auto head = headKeyword(ast);
+  if ((head == "let" || head == "lambda" || head == "dotimes" ||
+       head == "dolist") &&
+      expressions.size() > 1 &&
+      expressions[1]->getType() == parser::ast::NodeType::List) {
+    const auto &bindings =
+        std::static_pointer_cast<parser::ast::ListNode>(expressions[1])
+            ->getExpressions();
+    if (head == "lambda") {
+      if (std::any_of(bindings.begin(), bindings.end(), isName))
+        return false;
+    } else if (head == "let") {
+      // the values are evaluated before the names are bound
+      bool rebinds = false;
+      for (const auto &binding : bindings)
+        if (binding->getType() == parser::ast::NodeType::List) {
+          const auto &pair =
+              std::static_pointer_cast<parser::ast::ListNode>(binding)
+                  ->getExpressions();
+          rebinds = rebinds || (!pair.empty() && isName(pair.front()));
+          if (pair.size() > 1 && assigns(pair.back(), name))
+            return true;
+        }
+      if (rebinds)
+        return false;
+    } else if (!bindings.empty() && isName(bindings.front())) {
+      // the list or count of dotimes and dolist is evaluated outside
+      return bindings.size() > 1 && assigns(bindings[1], name);
+    }
+  }
+  if (head == "setq")
+    for (std::size_t i = 1; i < expressions.size(); i += 2)
+      if (isName(expressions[i]))
+        return true;
+  return std::any_of(expressions.begin(), expressions.end(),
+                     [&](const auto &expression) {
+                       return assigns(expression, name);
+                     });
+}
+
+// the body forms of a lambda as a single form
+std::shared_ptr<parser::ast::ASTNode>
+implicitProgn(const std::vector<std::shared_ptr<parser::ast::ASTNode>> &forms) {
+  if (forms.size() == 1)
+    return forms.front();
+  auto progn = std::make_shared<parser::ast::ListNode>();
+  progn->addExpression(std::make_shared<parser::ast::KeywordNode>("progn"));
+  for (const auto &form : forms)
+    progn->addExpression(form);
+  return progn;
+}
+
+// collect every identifier, a superset of the functions the form may call
+void collectIdentifiers(const std::shared_ptr<parser::ast::ASTNode> &ast,
+                        std::unordered_set<std::string> &names) {
+  switch (ast->getType()) {
+  case parser::ast::NodeType::Identifier:
+    names.insert(
+        std::static_pointer_cast<parser::ast::IdentifierNode>(ast)->getValue());
+    break;
+  case parser::ast::NodeType::Quoted:
+    collectIdentifiers(
+        std::static_pointer_cast<parser::ast::QuotedNode>(ast)->getExpression(),
+        names);
+    break;
+  case parser::ast::NodeType::List:
+    for (const auto &expression :
+         std::static_pointer_cast<parser::ast::ListNode>(ast)->getExpressions())
+      collectIdentifiers(expression, names);
+    break;
+  default:
+    break;
+  }
+}
+
+// check if a form defines a function anywhere inside it
+bool containsDefun(const std::shared_ptr<parser::ast::ASTNode> &ast) {
+  if (const auto head = headKeyword(ast);
+      head == "defun" || head == "defun-memo")
+    return true;
+  if (ast->getType() != parser::ast::NodeType::List)
+    return false;
+  const auto &expressions =
+      std::static_pointer_cast<parser::ast::ListNode>(ast)->getExpressions();
+  return std::any_of(expressions.begin(), expressions.end(), containsDefun);
+}
+
+// check if evaluating a form can neither have a side effect nor fail, so
+// its value can be dropped along with the form
+bool isPure(const std::shared_ptr<parser::ast::ASTNode> &ast) {
+  switch (ast->getType()) {
+  case parser::ast::NodeType::Integer:
+  case parser::ast::NodeType::Floating:
+  case parser::ast::NodeType::String:
+  case parser::ast::NodeType::Identifier:
+  case parser::ast::NodeType::Quoted:
+    return true;
+  case parser::ast::NodeType::Keyword: {
+    const auto &value =
+        std::static_pointer_cast<parser::ast::KeywordNode>(ast)->getValue();
+    return value == "t" || value == "nil";
+  }
+  case parser::ast::NodeType::List:
+    break;
+  default:
+    return false;
+  }
+  // builtins that can not fail whatever their arguments, cons is not one of
+  // them since dotted pairs are not supported
+  static const std::unordered_set<std::string> total = {
+      "list", "not", "null", "eq", "progn", "if", "function"};
+  const auto head = headKeyword(ast);
+  const auto &expressions =
+      std::static_pointer_cast<parser::ast::ListNode>(ast)->getExpressions();
+  if (head == "let" && expressions.size() == 3 &&
+      expressions[1]->getType() == parser::ast::NodeType::List) {
+    for (const auto &assignment :
+         std::static_pointer_cast<parser::ast::ListNode>(expressions[1])
+             ->getExpressions()) {
+      if (assignment->getType() != parser::ast::NodeType::List)
+        return false;
+      const auto &pair =
+          std::static_pointer_cast<parser::ast::ListNode>(assignment)
+              ->getExpressions();
+      if (pair.size() != 2 || !isPure(pair[1]))
+        return false;
+    }
+    return isPure(expressions[2]);
+  }
+  if (!total.contains(head))
+    return false;
+  return std::all_of(expressions.begin() + 1, expressions.end(), isPure);
+}
+
+} // namespace
+
+// find the top-level forms that can be removed: pure forms whose value is
+// discarded, and functions not reachable from the remaining forms
+void generator::Generator::findDeadCode(
+    const std::vector<std::shared_ptr<parser::ast::ASTNode>> &forms) {
+  std::unordered_map<std::string, std::size_t> functions;
+  std::vector<std::string> pending;
+  std::unordered_set<std::string> reached;
+  for (std::size_t i = 0; i < forms.size(); i++) {
+    const auto head = headKeyword(forms[i]);
+    const auto &expressions =
+        forms[i]->getType() == parser::ast::NodeType::List
+            ? std::static_pointer_cast<parser::ast::ListNode>(forms[i])
+                  ->getExpressions()
+            : std::vector<std::shared_ptr<parser::ast::ASTNode>>();
+    // nested defuns define functions of their own, so keep them
+    if ((head == "defun" || head == "defun-memo") && expressions.size() >= 4 &&
+        expressions[1]->getType() == parser::ast::NodeType::Identifier &&
+        !std::any_of(expressions.begin() + 2, expressions.end(),
+                     containsDefun)) {
+      functions.emplace(
+          std::static_pointer_cast<parser::ast::IdentifierNode>(expressions[1])
+              ->getValue(),
+          i);
+      _dead.insert(forms[i].get());
+    } else if (isPure(forms[i])) {
+      _dead.insert(forms[i].get());
+    } else {
+      std::unordered_set<std::string> names;
+      collectIdentifiers(forms[i], names);
+      pending.insert(pending.end(), names.begin(), names.end());
+    }
+  }
+  // every function of a module may be called by the modules importing it
+  if (!_config.module.empty())
+    for (const auto &[name, form] : functions)
+      pending.push_back(name);
+  while (!pending.empty()) {
+    const auto name = pending.back();
+    pending.pop_back();
+    const auto function = functions.find(name);
+    if (function == functions.end() || !reached.insert(name).second)
+      continue;
+    _dead.erase(forms[function->second].get());
+    std::unordered_set<std::string> names;
+    collectIdentifiers(forms[function->second], names);
+    pending.insert(pending.end(), names.begin(), names.end());
+  }
+  for (std::size_t i = 0; i < forms.size(); i++) {
+    if (!_dead.contains(forms[i].get()))
+      continue;
+    const auto head = headKeyword(forms[i]);
+    if (head == "defun" || head == "defun-memo")
+      _eliminated.push_back(
+          head + " " +
+          std::static_pointer_cast<parser::ast::IdentifierNode>(
+              std::static_pointer_cast<parser::ast::ListNode>(forms[i])
+                  ->getExpressions()[1])
+              ->getValue());
+    else
+      _eliminated.push_back("form " + std::to_string(i + 1) +
+                            (head.empty() ? "" : " (" + head + ")"));
+  }
+}
+
 void generator::Generator::generateProgram(
     const std::shared_ptr<parser::ast::ASTNode> &ast) {
   assert(_ast->getType() == parser::ast::NodeType::Program);
   auto program = std::static_pointer_cast<parser::ast::ProgramNode>(ast);
+  if (_config.eliminate_dead_code)
+    findDeadCode(program->getExpressions());
   for (const auto &expression : program->getExpressions()) {
+    _current = expression.get();
+    if (headKeyword(expression) != "declaim")
+      _started = true;
+    if (!_dead.contains(expression.get())) {
+      if (!_config.line_directives) {
+        generateExpression(expression, false);
+        _body += ",";
+        continue;
+      }
+      // each form on lines of its own
+      const std::size_t start = _body.size();
+      generateExpression(expression, false);
+      const std::string form = _body.substr(start) + ",\n";
+      _body.resize(start);
+      _body += "\n";
+      _body += mapped(expression, form);
+      continue;
+    }
+    // dead forms are still generated for their errors, then discarded
+    const std::size_t declarations = _declarations.size(), body = _body.size();
+    const std::size_t units = _units.size(), defined = _defined.size();
+    const std::size_t definitions = _definitions.size();
+    const std::size_t wrappers = _wrappers.size(), closures = _closures;
+    const auto wrapped = _wrapped;
+    const auto constants = _constants;
+    const auto calls = _calls;
     generateExpression(expression, false);
-    _body += ",";
+    _declarations.resize(declarations);
+    _body.resize(body);
+    _units.resize(units);
+    _defined.resize(defined);
+    _definitions.resize(definitions);
+    _wrappers.resize(wrappers);
+    _closures = closures;
+    _wrapped = wrapped;
+    _constants = constants;
+    _calls = calls;
   }
 }
 
@@ -53,9 +518,14 @@ void generator::Generator::generateExpression(
           expression->getType()) {
   case parser::ast::NodeType::Integer:
   case parser::ast::NodeType::Floating:
-  case parser::ast::NodeType::String:
     generateLiteral(ast);
     break;
+  case parser::ast::NodeType::String:
+    if (quoted)
+      generateLiteral(ast);
+    else
+      generateConstant(ast);
+    break;
   case parser::ast::NodeType::Identifier:
     generateIdentifier(ast, quoted);
     break;
@@ -65,9 +535,14 @@ void generator::Generator::generateExpression(
   case parser::ast::NodeType::Keyword:
     generateKeyword(ast, quoted);
     break;
-  case parser::ast::NodeType::List:
+  case parser::ast::NodeType::List: {
+    const auto *outer = _current;
+    if (ast->getLine() != 0)
+      _current = ast.get();
     generateList(ast, quoted);
+    _current = outer;
     break;
+  }
   default:
     throw std::runtime_error("Unexpected node type");
   }
@@ -80,10 +555,21 @@ void generator::Generator::generateLiteral(
          ast->getType() == parser::ast::NodeType::String);
   switch (ast->getType()) {
   case parser::ast::NodeType::Integer: {
-    _body += "INT(";
     const auto node = std::static_pointer_cast<parser::ast::IntegerNode>(ast);
-    _body += std::to_string(node->getValue());
-    _body += ")";
+    const auto &value = node->getValue();
+    long long fixnum;
+    // the most negative fixnum can not be written as a C++ literal
+    if (const auto [ptr, error] = std::from_chars(
+            value.data(), value.data() + value.size(), fixnum);
+        error == std::errc() && fixnum != LLONG_MIN) {
+      _body += "INT(";
+      _body += value;
+      _body += ")";
+    } else {
+      _body += "BIGINT(\"";
+      _body += value;
+      _body += "\")";
+    }
     break;
   }
   case parser::ast::NodeType::Floating: {
@@ -110,14 +596,40 @@ void generator::Generator::generateLiteral(
   }
 }
 
+// a quoted list or a string is built once, at its first use, and equal ones
+// share the same constant
+void generator::Generator::generateConstant(
+    const std::shared_ptr<parser::ast::ASTNode> &ast) {
+  const std::size_t start = _body.size();
+  generateExpression(ast, true);
+  const std::string value = _body.substr(start);
+  _body.resize(start);
+  // named after the value, so that the constants of the other units keep
+  // their names and the incremental build does not recompile them
+  std::string name = "K" + cache::hash(value);
+  if (!_constants.contains(value))
+    while (std::any_of(_constants.begin(), _constants.end(),
+                       [&](const auto &entry) { return entry.second == name; }))
+      name += "_";
+  const auto [constant, added] = _constants.try_emplace(value, name);
+  const std::string &generated_name = constant->second;
+  if (added)
+    _declarations.emplace_back(generated_name, "DEFCONSTANT(" +
+                                                   generated_name + "," +
+                                                   value + ")\n");
+  markCall(generated_name, generated_name);
+  _body += "CONSTANT(";
+  _body += generated_name;
+  _body += ")";
+}
+
 void generator::Generator::generateIdentifier(
     const std::shared_ptr<parser::ast::ASTNode> &ast, const bool quoted) {
   assert(ast->getType() == parser::ast::NodeType::Identifier);
   const auto node = std::static_pointer_cast<parser::ast::IdentifierNode>(ast);
-  if (quoted) {
-    _body += "SYMBOL(\"";
-    _body += node->getValue();
-    _body += "\")";
+  // keywords such as :element-type evaluate to themselves
+  if (quoted || node->getValue().starts_with(':')) {
+    generateSymbol(node->getValue());
   } else {
     Value value = _scope->get(node->getValue());
     if (value._type == ValueType::Function)
@@ -126,14 +638,22 @@ void generator::Generator::generateIdentifier(
   }
 }
 
+// symbols are interned under their upper case print name when the
+// expression is built, so evaluating one does not allocate and eq compares
+// pointers
+void generator::Generator::generateSymbol(const std::string &name) {
+  _body += "SYMBOL(\"";
+  for (const auto c : name)
+    _body += static_cast<char>(toupper(c));
+  _body += "\")";
+}
+
 void generator::Generator::generateKeyword(
     const std::shared_ptr<parser::ast::ASTNode> &ast, const bool quoted) {
   assert(ast->getType() == parser::ast::NodeType::Keyword);
   const auto node = std::static_pointer_cast<parser::ast::KeywordNode>(ast);
   if (quoted) {
-    _body += "SYMBOL(\"";
-    _body += node->getValue();
-    _body += "\")";
+    generateSymbol(node->getValue());
   } else {
     if (node->getValue() == "nil") {
       _body += "NIL()";
@@ -153,11 +673,84 @@ void generator::Generator::generateQuoted(
     _body += "QUOTED(";
     generateExpression(node->getExpression(), true);
     _body += ")";
+  } else if (node->getExpression()->getType() ==
+             parser::ast::NodeType::List) {
+    generateConstant(node->getExpression());
   } else {
     generateExpression(node->getExpression(), true);
   }
 }
 
+namespace {
+
+// builtins compiled to a runtime struct of the same arguments
+const std::unordered_map<std::string, std::string> predefined = {
+    {"null", "Null"},       {"not", "Not"},      {"if", "If"},
+    {"eq", "Eq"},
+    {"car", "Car"},         {"cdr", "Cdr"},      {"cons", "Cons"},
+    {"list", "List_"},      {"progn", "Progn"},  {"print", "Print"},
+    {">=", "GreaterEqual"}, {"<=", "LessEqual"}, {">", "Greater"},
+    {"<", "Less"},          {"=", "Equal"},      {"/=", "NotEqual"},
+    {"+", "Add"},           {"-", "Subtract"},   {"*", "Multiply"},
+    {"/", "Divide"},        {"aref", "Aref"},    {"length", "Length"},
+    {"vector-add", "VectorAdd"}, {"vector-mul", "VectorMul"},
+    {"vector-dot", "VectorDot"}, {"vector-sum", "VectorSum"},
+    {"vector-min", "VectorMin"}, {"vector-max", "VectorMax"},
+    {"mapcar", "Mapcar"},   {"append", "Append"}, {"reverse", "Reverse"},
+    {"nth", "Nth"},         {"member", "Member"}, {"assoc", "Assoc"},
+    {"gethash", "Gethash"}, {"remhash", "Remhash"},
+    {"hash-table-count", "HashTableCount"},
+};
+
+// least and most number of arguments of the builtins
+constexpr std::size_t variadic = SIZE_MAX;
+const std::unordered_map<std::string, std::pair<std::size_t, std::size_t>>
+    builtin_arity = {
+        {"null", {1, 1}},        {"not", {1, 1}},
+        {"if", {3, 3}},          {"eq", {2, 2}},
+        {"car", {1, 1}},         {"cdr", {1, 1}},
+        {"cons", {2, 2}},        {"list", {0, variadic}},
+        {"progn", {0, variadic}}, {"print", {1, 1}},
+        {">=", {2, 2}},          {"<=", {2, 2}},
+        {">", {2, 2}},           {"<", {2, 2}},
+        {"=", {2, 2}},           {"/=", {2, 2}},
+        {"+", {2, 2}},           {"-", {2, 2}},
+        {"*", {2, 2}},           {"/", {2, 2}},
+        {"aref", {2, 2}},        {"length", {1, 1}},
+        {"vector-add", {2, 2}},  {"vector-mul", {2, 2}},
+        {"vector-dot", {2, 2}},  {"vector-sum", {1, 1}},
+        {"vector-min", {1, 1}},  {"vector-max", {1, 1}},
+        {"mapcar", {2, variadic}}, {"append", {0, variadic}},
+        {"reverse", {1, 1}},     {"nth", {2, 2}},
+        {"member", {2, 2}},      {"assoc", {2, 2}},
+        {"gethash", {2, 3}},     {"remhash", {2, 2}},
+        {"hash-table-count", {1, 1}},
+};
+
+// arithmetic and comparisons with a runtime struct for declared operands,
+// prefixed by Fixnum or Double
+const std::unordered_map<std::string, std::string> typed_builtins = {
+    {"+", "Add"},        {"-", "Subtract"},      {"*", "Multiply"},
+    {"/", "Divide"},     {"<", "Less"},          {">", "Greater"},
+    {"<=", "LessEqual"}, {">=", "GreaterEqual"}, {"=", "Equal"},
+    {"/=", "NotEqual"},
+};
+
+// number of arguments of the builtins that can be passed with #'
+const std::unordered_map<std::string, int> predefined_arity = {
+    {"null", 1},       {"not", 1},        {"car", 1},        {"cdr", 1},
+    {"eq", 2},
+    {"cons", 2},       {"print", 1},      {">=", 2},         {"<=", 2},
+    {">", 2},          {"<", 2},          {"=", 2},          {"/=", 2},
+    {"+", 2},          {"-", 2},          {"*", 2},          {"/", 2},
+    {"aref", 2},       {"length", 1},     {"vector-add", 2}, {"vector-mul", 2},
+    {"vector-dot", 2}, {"vector-sum", 1}, {"vector-min", 1}, {"vector-max", 1},
+    {"reverse", 1},    {"nth", 2},        {"member", 2},     {"assoc", 2},
+    {"gethash", 2},    {"remhash", 2},    {"hash-table-count", 1},
+};
+
+} // namespace
+
 void generator::Generator::generateList(
     const std::shared_ptr<parser::ast::ASTNode> &ast, const bool quoted) {
   assert(ast->getType() == parser::ast::NodeType::List);
@@ -171,15 +764,6 @@ void generator::Generator::generateList(
     _body += ")";
   } else {
     // TODO : function call
-    const std::unordered_map<std::string, std::string> predefined = {
-        {"null", "Null"},       {"not", "Not"},      {"if", "If"},
-        {"car", "Car"},         {"cdr", "Cdr"},      {"cons", "Cons"},
-        {"list", "List_"},      {"progn", "Progn"},  {"print", "Print"},
-        {">=", "GreaterEqual"}, {"<=", "LessEqual"}, {">", "Greater"},
-        {"<", "Less"},          {"=", "Equal"},      {"/=", "NotEqual"},
-        {"+", "Add"},           {"-", "Subtract"},   {"*", "Multiply"},
-        {"/", "Divide"},
-    };
     const auto first = node->getExpressions().front();
     const auto rest = std::vector(node->getExpressions().begin() + 1,
                                   node->getExpressions().end());
@@ -188,6 +772,15 @@ void generator::Generator::generateList(
           std::static_pointer_cast<parser::ast::IdentifierNode>(first);
       if (const Value value = _scope->get(ident->getValue());
           value._type == ValueType::Function) {
+        checkArity(ident->getValue(), rest.size(), value._arity, value._arity);
+        for (std::size_t i = 0; i < value._kinds.size(); i++)
+          checkDeclared("argument " + std::to_string(i + 1) + " of " +
+                            ident->getValue(),
+                        value._kinds[i] == 'f'   ? NativeType::Fixnum
+                        : value._kinds[i] == 'd' ? NativeType::Double
+                                                 : NativeType::None,
+                        rest[i]);
+        markCall(ident->getValue(), value._value);
         generateFunctionCall(value._value, rest);
       } else {
         throw std::runtime_error("Unexpected function");
@@ -196,14 +789,97 @@ void generator::Generator::generateList(
       if (const auto keyword =
               std::static_pointer_cast<parser::ast::KeywordNode>(first);
           predefined.contains(keyword->getValue())) {
+        const auto [min, max] = builtin_arity.at(keyword->getValue());
+        checkArity(keyword->getValue(), rest.size(), min, max);
+        // the function passed to mapcar takes one argument per list, one
+        // only known at run time may have any side effect
+        if (keyword->getValue() == "mapcar") {
+          if (const long arity = knownArity(rest[0]); arity >= 0)
+            checkArity("the function of mapcar", rest.size() - 1, arity,
+                       arity);
+          if (!knownFunction(rest[0]))
+            markSideEffect("mapcar", false);
+        }
+        if (keyword->getValue() == "print")
+          markSideEffect("print", true);
+        else if (keyword->getValue() == "remhash")
+          markSideEffect("remhash", false);
+        if (typed_builtins.contains(keyword->getValue()))
+          if (const NativeType type = operandType(keyword->getValue(), rest);
+              type != NativeType::None) {
+            generateTypedCall(keyword->getValue(), type, rest);
+            return;
+          }
         generateFunctionCall(predefined.at(keyword->getValue()), rest);
-      } else if (keyword->getValue() == "defun" && rest.size() == 3) {
-        generateDefun(rest[0], rest[1], rest[2]);
-      } else if (keyword->getValue() == "let" && rest.size() == 2) {
-        generateLet(rest[0], rest[1]);
+      } else if ((keyword->getValue() == "defun" ||
+                  keyword->getValue() == "defun-memo") &&
+                 rest.size() >= 3) {
+        generateDefun(rest[0], rest[1],
+                      std::vector(rest.begin() + 2, rest.end() - 1),
+                      rest.back(), keyword->getValue() == "defun-memo");
+      } else if (keyword->getValue() == "let" && rest.size() >= 2) {
+        // the leading (declare ...) forms, then the body
+        auto body = rest.begin() + 1;
+        while (body + 1 < rest.end() && headKeyword(*body) == "declare")
+          ++body;
+        generateLet(rest[0], std::vector(rest.begin() + 1, body),
+                    implicitProgn(std::vector(body, rest.end())));
+      } else if (keyword->getValue() == "the") {
+        generateThe(rest);
+      } else if (keyword->getValue() == "declaim") {
+        generateDeclaim(rest);
+      } else if (keyword->getValue() == "lambda") {
+        generateLambda(rest);
+      } else if (keyword->getValue() == "funcall") {
+        generateFuncall(rest);
+      } else if (keyword->getValue() == "setq") {
+        generateSetq(rest);
+      } else if ((keyword->getValue() == "dotimes" ||
+                  keyword->getValue() == "dolist") &&
+                 !rest.empty()) {
+        generateIteration(keyword->getValue(), rest);
+      } else if (keyword->getValue() == "loop") {
+        generateLoop(rest);
+      } else if (keyword->getValue() == "make-array") {
+        generateMakeArray(rest);
+      } else if (keyword->getValue() == "make-hash-table") {
+        generateMakeHashTable(rest);
+      } else if (keyword->getValue() == "setf" && rest.size() == 2) {
+        markSideEffect("setf", false);
+        generateSetf(rest[0], rest[1]);
+      } else if (keyword->getValue() == "function" && rest.size() == 1) {
+        generateFunction(rest[0]);
+      } else if (keyword->getValue() == "reduce") {
+        generateReduce(rest);
+      } else if (keyword->getValue() == "pcall") {
+        generateParallel("Pcall", rest);
+      } else if (keyword->getValue() == "pmapcar") {
+        generateParallel("Pmapcar", rest);
       } else {
         throw std::runtime_error("Unexpected keyword");
       }
+    } else if (headKeyword(first) == "lambda") {
+      // ((lambda (x) body) value) binds x like a let
+      const auto &lambda =
+          std::static_pointer_cast<parser::ast::ListNode>(first)
+              ->getExpressions();
+      if (lambda.size() < 3 ||
+          lambda[1]->getType() != parser::ast::NodeType::List)
+        throw std::runtime_error("Invalid lambda call");
+      const auto &params =
+          std::static_pointer_cast<parser::ast::ListNode>(lambda[1])
+              ->getExpressions();
+      if (params.size() != rest.size())
+        throw std::runtime_error("Invalid number of arguments");
+      auto assignments = std::make_shared<parser::ast::ListNode>();
+      for (std::size_t i = 0; i < params.size(); i++) {
+        auto assignment = std::make_shared<parser::ast::ListNode>();
+        assignment->addExpression(params[i]);
+        assignment->addExpression(rest[i]);
+        assignments->addExpression(assignment);
+      }
+      generateLet(assignments, {},
+                  implicitProgn(std::vector(lambda.begin() + 2, lambda.end())));
     } else {
       throw std::runtime_error("Unexpected function call");
     }
@@ -223,18 +899,18 @@ void generator::Generator::generateFunctionCall(
   _body += ")";
 }
 
-// (defun ident (ident1 ident2) (expression))
+// (defun ident (ident1 ident2) (declare ...) (expression))
+// defun-memo is a defun declared with (declare (memoize))
 void generator::Generator::generateDefun(
     const std::shared_ptr<parser::ast::ASTNode> &name,
     const std::shared_ptr<parser::ast::ASTNode> &args,
-    const std::shared_ptr<parser::ast::ASTNode> &body) {
+    const std::vector<std::shared_ptr<parser::ast::ASTNode>> &declarations,
+    const std::shared_ptr<parser::ast::ASTNode> &body, const bool memoize) {
 
+  // functions only see their own parameters, they run in a frame of their own
   auto original_scope = _scope;
-  _scope = std::make_shared<Scope>(original_scope);
+  _scope = std::make_shared<Scope>(_global);
 
-  static unsigned int func_count = 0;
-  const std::string generated_name = "L" + std::to_string(func_count);
-  func_count++;
   std::string func_name;
   int args_count = 0;
   std::string body_str;
@@ -246,11 +922,18 @@ void generator::Generator::generateDefun(
     auto ident = std::static_pointer_cast<parser::ast::IdentifierNode>(name);
     func_name = ident->getValue();
   }
+  // the name only depends on the lisp name, so that adding or editing a
+  // function does not rename the others
+  const std::string generated_name = "L_" + modules::identifier(func_name);
 
-  // Set function to top level scope
-  _scope->set(func_name, Value(ValueType::Function, generated_name), true);
+  // 2. Read declarations
+  Declarations declared;
+  declared.memoize = memoize;
+  parseDeclarations(declarations, declared);
 
-  // 2. Generate arguments
+  // 3. Generate arguments, a typed argument is passed in the unboxed slot of
+  // its index; the cache of a memoized function reads them boxed
+  std::string kinds;
   {
     if (args->getType() == parser::ast::NodeType::List)
       for (const auto list =
@@ -260,9 +943,15 @@ void generator::Generator::generateDefun(
           throw std::runtime_error("Invalid argument");
         const auto ident =
             std::static_pointer_cast<parser::ast::IdentifierNode>(expr);
-        _scope->set(ident->getValue(),
-                    Value(ValueType::Expression,
-                          "ARG(" + std::to_string(args_count) + ")"));
+        const auto type = declared.types.find(ident->getValue());
+        Value value(ValueType::Expression, "", body);
+        if (type != declared.types.end() && !declared.memoize)
+          value._native = type->second;
+        value._value = nativeSlot(value._native, args_count);
+        kinds += value._native == NativeType::Fixnum   ? 'f'
+                 : value._native == NativeType::Double ? 'd'
+                                                       : 'b';
+        _scope->set(ident->getValue(), value);
         args_count++;
       }
     else if (args->getType() == parser::ast::NodeType::Keyword) {
@@ -274,66 +963,1056 @@ void generator::Generator::generateDefun(
       throw std::runtime_error("Invalid arguments list");
   }
 
-  // 3. Generate body
+  // Set function to top level scope
+  Value function(ValueType::Function, generated_name);
+  function._arity = args_count;
+  if (kinds.find_first_not_of('b') != std::string::npos)
+    function._kinds = kinds;
+  _scope->set(func_name, function, true);
+
+  // 4. Generate body, the frame starts with the arguments, in a unit of its
+  // own
+  const auto original_definitions = _definitions;
+  const auto original_calls = _calls;
+  const auto original_unit = _unit;
+  const std::size_t original_closures = _closures;
+  _definitions.clear();
+  _calls.clear();
+  _unit = generated_name;
+  _closures = 0;
+  const std::size_t original_locals = _locals;
+  const std::size_t original_max_locals = _max_locals;
+  const std::size_t original_natives = _natives;
+  const std::size_t original_max_natives = _max_natives;
+  const bool original_prints = _prints;
+  const bool original_side_effect = _side_effect;
+  _locals = args_count;
+  _max_locals = args_count;
+  _natives = function._kinds.size();
+  _max_natives = _natives;
+  _prints = false;
+  _side_effect = false;
   {
     const std::size_t pos = _body.size();
     generateExpression(body, false);
     body_str = _body.substr(pos);
     _body.resize(pos);
   }
+  const std::size_t locals_count = _max_locals;
+  const std::size_t natives_count = _max_natives;
+  if (_prints)
+    _printing.insert(generated_name);
+  if (_side_effect)
+    _impure.insert(generated_name);
+  if (declared.memoize && _side_effect)
+    std::cerr << location(name.get()) << "Warning: memoized function "
+              << func_name
+              << " is not pure, cached calls skip its side effects"
+              << std::endl;
+  _locals = original_locals;
+  _max_locals = original_max_locals;
+  _natives = original_natives;
+  _max_natives = original_max_natives;
+  _prints = original_prints;
+  _side_effect = original_side_effect;
 
-  _header += "DEF(";
-  _header += generated_name;
-  _header += ",";
-  _header += std::to_string(args_count);
-  _header += ",";
-  _header += body_str;
-  _header += ");\n";
+  // the cache is keyed on the evaluated arguments
+  if (declared.memoize)
+    body_str = "MEMO(\"" + func_name + "\"," + std::to_string(args_count) +
+               "," + std::to_string(declared.memo_size) + "," + body_str + ")";
 
-  _body += "SYMBOL(\"";
-  _body += func_name;
-  _body += "\")";
+  std::string declaration = "DEF(";
+  declaration += generated_name;
+  declaration += ",\"";
+  declaration += func_name;
+  declaration += "\",";
+  declaration += std::to_string(args_count);
+  declaration += ",";
+  declaration += std::to_string(locals_count);
+  declaration += ",";
+  declaration += std::to_string(natives_count);
+  declaration += ",\"";
+  declaration += kinds;
+  declaration += "\");\n";
+  // the member functions of the struct, the frames of the function in a
+  // profile, are on the line of the defun
+  _declarations.emplace_back(generated_name, mapped(name, declaration));
+  Unit unit;
+  unit.name = generated_name;
+  unit.code = _definitions;
+  unit.code += mapped(name, "DEF_BODY(" + generated_name + "," + body_str +
+                                ");\n");
+  unit.calls.assign(_calls.begin(), _calls.end());
+  _units.push_back(std::move(unit));
+  _definitions = original_definitions;
+  _calls = original_calls;
+  _unit = original_unit;
+  _closures = original_closures;
+
+  modules::Export exported;
+  exported.name = func_name;
+  exported.arity = args_count;
+  exported.kinds = function._kinds;
+  if (_printing.contains(generated_name))
+    exported.effects = "p";
+  else if (_impure.contains(generated_name))
+    exported.effects = "s";
+  exported.symbol = modules::mangle(_config.module, func_name);
+  _defined.emplace_back(generated_name, exported);
+
+  generateSymbol(func_name);
 
   _scope = original_scope;
 }
 
+// (let ((ident1 expr1) (ident2 expr2)) (declare ...) (expression))
+// the values are evaluated into consecutive slots of the current frame, the
+// variables declared fixnum or double-float into unboxed slots
 void generator::Generator::generateLet(
     const std::shared_ptr<parser::ast::ASTNode> &assignments,
+    const std::vector<std::shared_ptr<parser::ast::ASTNode>> &declarations,
     const std::shared_ptr<parser::ast::ASTNode> &body) {
   auto original_scope = _scope;
-  _scope = std::make_shared<Scope>(original_scope);
+  const std::size_t first = _locals;
+  const std::size_t first_native = _natives;
+  std::vector<Value> values;
+  std::vector<std::size_t> slots;
 
-  // 1. assign variables to current scope
+  Declarations declared;
+  parseDeclarations(declarations, declared);
+  if (declared.memoize)
+    throw std::runtime_error("Invalid declaration: memoize");
+
+  // 1. evaluate the values in the enclosing scope
   // format : ( (ident1 expr1) (ident2 expr2) ... )
   {
     if (assignments->getType() != parser::ast::NodeType::List)
       throw std::runtime_error("Invalid assignments list");
-    for (const auto list =
-             std::static_pointer_cast<parser::ast::ListNode>(assignments);
-         const auto &expr : list->getExpressions()) {
+    const auto list =
+        std::static_pointer_cast<parser::ast::ListNode>(assignments);
+    std::vector<std::string> names;
+    for (const auto &expr : list->getExpressions()) {
       if (expr->getType() != parser::ast::NodeType::List)
         throw std::runtime_error("Invalid assignment");
       const auto assignment =
           std::static_pointer_cast<parser::ast::ListNode>(expr);
-      if (assignment->getExpressions().size() != 2 &&
+      if (assignment->getExpressions().size() != 2 ||
           assignment->getExpressions().front()->getType() !=
               parser::ast::NodeType::Identifier)
         throw std::runtime_error("Invalid assignment");
-      const auto ident = std::static_pointer_cast<parser::ast::IdentifierNode>(
-          assignment->getExpressions().front());
-      const auto value = assignment->getExpressions().back();
-      const std::size_t pos = _body.size();
-      generateExpression(value, false);
-      _scope->set(ident->getValue(),
-                  Value(ValueType::Expression, _body.substr(pos)));
-      _body.resize(pos);
+      const auto &name = std::static_pointer_cast<parser::ast::IdentifierNode>(
+                             assignment->getExpressions().front())
+                             ->getValue();
+      Value value(ValueType::Expression, "", body);
+      if (const auto type = declared.types.find(name);
+          type != declared.types.end())
+        value._native = type->second;
+      // reserve the slots first so that nested lets use the following ones
+      slots.push_back(value._native == NativeType::None ? _locals++
+                                                        : _natives++);
+      value._value = nativeSlot(value._native, slots.back());
+      names.push_back(name);
+      values.push_back(value);
+    }
+    _max_locals = std::max(_max_locals, _locals);
+    _max_natives = std::max(_max_natives, _natives);
+    // a typed let assigns its slots one by one before the body
+    const bool typed =
+        std::any_of(values.begin(), values.end(), [](const Value &value) {
+          return value._native != NativeType::None;
+        });
+    if (typed) {
+      _body += "FUNC(Progn, ";
+    } else {
+      _body += "LET(";
+      _body += std::to_string(first);
+      _body += ",";
+    }
+    for (std::size_t i = 0; i < values.size(); i++) {
+      const auto &form = std::static_pointer_cast<parser::ast::ListNode>(
+                             list->getExpressions()[i])
+                             ->getExpressions()
+                             .back();
+      checkDeclared(names[i], values[i]._native, form);
+      if (typed) {
+        _body += values[i]._native == NativeType::Fixnum   ? "SET_FIXNUM("
+                 : values[i]._native == NativeType::Double ? "SET_DOUBLE("
+                                                           : "SETQ(";
+        _body += std::to_string(slots[i]);
+        _body += ",";
+      }
+      generateExpression(form, false);
+      _body += typed ? ")," : ",";
     }
+
+    // 2. assign variables to their slots in a new scope
+    _scope = std::make_shared<Scope>(original_scope);
+    for (std::size_t i = 0; i < names.size(); i++)
+      _scope->set(names[i], values[i]);
   }
 
-  // 2. generate body
+  // 3. generate body
   {
     generateExpression(body, false);
+    _body += ")";
+  }
+
+  _scope = original_scope;
+  _locals = first;
+  _natives = first_native;
+}
+
+// (lambda (ident1 ident2) body...), a flat closure: the body runs in its own
+// frame and reads the variables of the enclosing frames from a copy of their
+// values taken when the closure is created
+void generator::Generator::generateLambda(
+    const std::vector<std::shared_ptr<parser::ast::ASTNode>> &args) {
+  if (args.size() < 2)
+    throw std::runtime_error("Invalid lambda");
+  // numbered in their unit, so that other units do not rename them
+  std::string generated_name = "C" + std::to_string(_closures++);
+  if (!_unit.empty())
+    generated_name += "_" + _unit;
+  const auto body = implicitProgn(std::vector(args.begin() + 1, args.end()));
+
+  // 1. bind the arguments in a scope that captures the free variables
+  auto original_scope = _scope;
+  const auto scope = std::make_shared<Scope>(_scope, true);
+  _scope = scope;
+  std::size_t args_count = 0;
+  if (args[0]->getType() == parser::ast::NodeType::List) {
+    for (const auto &expr :
+         std::static_pointer_cast<parser::ast::ListNode>(args[0])
+             ->getExpressions()) {
+      if (expr->getType() != parser::ast::NodeType::Identifier)
+        throw std::runtime_error("Invalid argument");
+      _scope->set(
+          std::static_pointer_cast<parser::ast::IdentifierNode>(expr)
+              ->getValue(),
+          Value(ValueType::Expression,
+                "LOCAL(" + std::to_string(args_count) + ")", body));
+      args_count++;
+    }
+  } else if (args[0]->getType() != parser::ast::NodeType::Keyword ||
+             std::static_pointer_cast<parser::ast::KeywordNode>(args[0])
+                     ->getValue() != "nil") {
+    throw std::runtime_error("Invalid arguments list");
+  }
+
+  // 2. generate the body in a new frame starting with the arguments
+  const std::size_t original_locals = _locals;
+  const std::size_t original_max_locals = _max_locals;
+  const std::size_t original_shared_locals = _shared_locals;
+  const std::size_t original_natives = _natives;
+  const std::size_t original_max_natives = _max_natives;
+  const std::size_t original_shared_natives = _shared_natives;
+  _locals = args_count;
+  _max_locals = args_count;
+  _shared_locals = 0;
+  _natives = 0;
+  _max_natives = 0;
+  _shared_natives = 0;
+  const std::size_t pos = _body.size();
+  generateExpression(body, false);
+  const std::string body_str = _body.substr(pos);
+  _body.resize(pos);
+  const std::size_t locals_count = _max_locals;
+  const std::size_t natives_count = _max_natives;
+  _locals = original_locals;
+  _max_locals = original_max_locals;
+  _shared_locals = original_shared_locals;
+  _natives = original_natives;
+  _max_natives = original_max_natives;
+  _shared_natives = original_shared_natives;
+  _scope = original_scope;
+
+  // 3. the captured values are copies, so the variables must not change
+  for (const auto &[name, value] : scope->getCaptures())
+    if (value._region && assigns(value._region, name))
+      throw std::runtime_error("Closure captures an assigned variable: " +
+                               name);
+
+  // defined with the unit, before the code creating it, on the line of its
+  // arguments
+  std::string definition = "LAMBDA(";
+  definition += generated_name;
+  definition += ",";
+  definition += std::to_string(args_count);
+  definition += ");\n";
+  definition += "LAMBDA_BODY(";
+  definition += generated_name;
+  definition += ",";
+  definition += std::to_string(locals_count);
+  definition += ",";
+  definition += std::to_string(natives_count);
+  definition += ",";
+  definition += body_str;
+  definition += ");\n";
+  _definitions += mapped(args[0], definition);
+
+  _body += "CLOSURE(";
+  _body += generated_name;
+  _body += ", ";
+  for (const auto &[name, value] : scope->getCaptures()) {
+    _body += value._value;
+    _body += ",";
+  }
+  _body += ")";
+}
+
+// (funcall function arg1 arg2), a named function or a lambda is called
+// directly
+void generator::Generator::generateFuncall(
+    const std::vector<std::shared_ptr<parser::ast::ASTNode>> &args) {
+  if (args.empty())
+    throw std::runtime_error("Invalid funcall");
+  const auto rest = std::vector(args.begin() + 1, args.end());
+  auto function = args[0];
+  if (function->getType() == parser::ast::NodeType::Quoted)
+    function =
+        std::static_pointer_cast<parser::ast::QuotedNode>(function)
+            ->getExpression();
+  else if (headKeyword(function) == "function")
+    function = std::static_pointer_cast<parser::ast::ListNode>(function)
+                   ->getExpressions()
+                   .back();
+  else
+    function = nullptr;
+  if (function && (function->getType() == parser::ast::NodeType::Identifier ||
+                   function->getType() == parser::ast::NodeType::Keyword ||
+                   headKeyword(function) == "lambda")) {
+    auto call = std::make_shared<parser::ast::ListNode>();
+    call->addExpression(function);
+    for (const auto &arg : rest)
+      call->addExpression(arg);
+    generateList(call, false);
+    return;
+  }
+  // the function is only known at run time, it may have any side effect
+  markSideEffect("funcall", false);
+  generateFunctionCall("Funcall", args);
+}
+
+// (setq ident1 expr1 ident2 expr2), assigned in order
+void generator::Generator::generateSetq(
+    const std::vector<std::shared_ptr<parser::ast::ASTNode>> &args) {
+  if (args.empty() || args.size() % 2 != 0)
+    throw std::runtime_error("Invalid setq");
+  if (args.size() > 2)
+    _body += "FUNC(Progn, ";
+  for (std::size_t i = 0; i < args.size(); i += 2) {
+    if (args[i]->getType() != parser::ast::NodeType::Identifier)
+      throw std::runtime_error("Invalid setq");
+    const auto &name =
+        std::static_pointer_cast<parser::ast::IdentifierNode>(args[i])
+            ->getValue();
+    // only variables living in a frame slot can be assigned
+    const Value value = _scope->get(name);
+    if (value._value.starts_with("CAPTURED("))
+      throw std::runtime_error("Closure captures an assigned variable: " +
+                               name);
+    if (value._type != ValueType::Expression ||
+        !(value._value.starts_with("LOCAL(") ||
+          value._value.starts_with("FIXNUM_SLOT(") ||
+          value._value.starts_with("DOUBLE_SLOT(")))
+      throw std::runtime_error("Invalid setq: " + name);
+    const std::size_t open = value._value.find('(');
+    const std::string index =
+        value._value.substr(open + 1, value._value.size() - open - 2);
+    const bool local = value._value.starts_with("LOCAL(");
+    // the arguments of pcall and pmapcar share the slots below their own
+    if (_parallel &&
+        std::stoul(index) < (local ? _shared_locals : _shared_natives))
+      throw std::runtime_error("Side effect inside pcall or pmapcar: setq");
+    if (!local)
+      checkDeclared(name, value._native, args[i + 1]);
+    _body += local                                   ? "SETQ("
+             : value._native == NativeType::Fixnum ? "SET_FIXNUM("
+                                                   : "SET_DOUBLE(";
+    _body += index;
+    _body += ",";
+    generateExpression(args[i + 1], false);
+    _body += ")";
+    if (args.size() > 2)
+      _body += ",";
+  }
+  if (args.size() > 2)
+    _body += ")";
+}
+
+// (dotimes (ident count [result]) body...) or
+// (dolist (ident list [result]) body...)
+void generator::Generator::generateIteration(
+    const std::string &name,
+    const std::vector<std::shared_ptr<parser::ast::ASTNode>> &args) {
+  if (args.front()->getType() != parser::ast::NodeType::List)
+    throw std::runtime_error("Invalid " + name);
+  const auto &spec =
+      std::static_pointer_cast<parser::ast::ListNode>(args.front())
+          ->getExpressions();
+  if (spec.size() < 2 || spec.size() > 3 ||
+      spec.front()->getType() != parser::ast::NodeType::Identifier)
+    throw std::runtime_error("Invalid " + name);
+  auto original_scope = _scope;
+  const std::size_t slot = _locals;
+
+  // 1. evaluate the count or the list in the enclosing scope
+  _locals++;
+  _max_locals = std::max(_max_locals, _locals);
+  _body += name == "dotimes" ? "DOTIMES(" : "DOLIST(";
+  _body += std::to_string(slot);
+  _body += ",";
+  generateExpression(spec[1], false);
+  _body += ",";
+
+  // 2. the result and the body see the variable
+  _scope = std::make_shared<Scope>(original_scope);
+  auto region = std::make_shared<parser::ast::ListNode>();
+  for (const auto &expr : args)
+    region->addExpression(expr);
+  Value variable(ValueType::Expression, "LOCAL(" + std::to_string(slot) + ")",
+                 region);
+  // the counter of dotimes is always a fixnum, it stays boxed because the
+  // runtime reuses its box
+  if (name == "dotimes")
+    variable._native = NativeType::Fixnum;
+  _scope->set(
+      std::static_pointer_cast<parser::ast::IdentifierNode>(spec.front())
+          ->getValue(),
+      variable);
+  if (spec.size() == 3)
+    generateExpression(spec[2], false);
+  else
+    _body += "NIL()";
+  _body += ",";
+  for (std::size_t i = 1; i < args.size(); i++) {
+    generateExpression(args[i], false);
+    _body += ",";
   }
+  _body += ")";
 
   _scope = original_scope;
+  _locals = slot;
+}
+
+// (loop while condition do body...) or (loop until condition do body...)
+void generator::Generator::generateLoop(
+    const std::vector<std::shared_ptr<parser::ast::ASTNode>> &args) {
+  const auto word = [&](const std::size_t i) -> std::string {
+    if (i >= args.size() ||
+        args[i]->getType() != parser::ast::NodeType::Identifier)
+      return "";
+    return std::static_pointer_cast<parser::ast::IdentifierNode>(args[i])
+        ->getValue();
+  };
+  const auto test = word(0);
+  if ((test != "while" && test != "until") || args.size() < 4 ||
+      word(2) != "do")
+    throw std::runtime_error("Invalid loop");
+  _body += test == "until" ? "LOOP(true," : "LOOP(false,";
+  generateExpression(args[1], false);
+  _body += ",";
+  for (std::size_t i = 3; i < args.size(); i++) {
+    generateExpression(args[i], false);
+    _body += ",";
+  }
+  _body += ")";
+}
+
+// (make-array size :element-type 'fixnum :initial-element 0)
+// the element type selects the storage of the vector at compile time
+void generator::Generator::generateMakeArray(
+    const std::vector<std::shared_ptr<parser::ast::ASTNode>> &args) {
+  if (args.empty() || args.size() % 2 == 0)
+    throw std::runtime_error("Invalid make-array");
+  std::string element = "T";
+  std::shared_ptr<parser::ast::ASTNode> initial;
+  for (std::size_t i = 1; i < args.size(); i += 2) {
+    if (args[i]->getType() != parser::ast::NodeType::Identifier)
+      throw std::runtime_error("Invalid make-array option");
+    const auto option =
+        std::static_pointer_cast<parser::ast::IdentifierNode>(args[i])
+            ->getValue();
+    if (option == ":initial-element") {
+      initial = args[i + 1];
+    } else if (option == ":element-type") {
+      auto type = args[i + 1];
+      if (type->getType() == parser::ast::NodeType::Quoted)
+        type = std::static_pointer_cast<parser::ast::QuotedNode>(type)
+                   ->getExpression();
+      std::string name;
+      if (type->getType() == parser::ast::NodeType::Identifier)
+        name = std::static_pointer_cast<parser::ast::IdentifierNode>(type)
+                   ->getValue();
+      else if (type->getType() == parser::ast::NodeType::Keyword)
+        name = std::static_pointer_cast<parser::ast::KeywordNode>(type)
+                   ->getValue();
+      if (name == "fixnum")
+        element = "Fixnum";
+      else if (name == "double-float")
+        element = "Double";
+      else if (name == "t")
+        element = "T";
+      else
+        throw std::runtime_error("Unsupported array element type: " + name);
+    } else {
+      throw std::runtime_error("Unknown make-array option: " + option);
+    }
+  }
+
+  _body += "MAKE_ARRAY(";
+  _body += element;
+  _body += ", ";
+  generateExpression(args[0], false);
+  _body += ",";
+  if (initial)
+    generateExpression(initial, false);
+  else
+    _body += element == "Double" ? "FLOAT(0.0)" : "INT(0)";
+  _body += ")";
+}
+
+// (setf (aref vector index) value) or (setf (gethash key table) value)
+void generator::Generator::generateSetf(
+    const std::shared_ptr<parser::ast::ASTNode> &place,
+    const std::shared_ptr<parser::ast::ASTNode> &value) {
+  if (place->getType() == parser::ast::NodeType::List) {
+    const auto list = std::static_pointer_cast<parser::ast::ListNode>(place);
+    const auto &expressions = list->getExpressions();
+    if (expressions.size() == 3 &&
+        expressions.front()->getType() == parser::ast::NodeType::Keyword) {
+      const auto &accessor =
+          std::static_pointer_cast<parser::ast::KeywordNode>(
+              expressions.front())
+              ->getValue();
+      if (accessor == "aref") {
+        generateFunctionCall("SetAref",
+                             {expressions[1], expressions[2], value});
+        return;
+      }
+      if (accessor == "gethash") {
+        generateFunctionCall("SetGethash",
+                             {expressions[1], expressions[2], value});
+        return;
+      }
+    }
+  }
+  throw std::runtime_error("Unsupported setf place");
+}
+
+// (make-hash-table :test #'equal), the test is eql or equal
+void generator::Generator::generateMakeHashTable(
+    const std::vector<std::shared_ptr<parser::ast::ASTNode>> &args) {
+  bool structural = false;
+  if (args.size() == 2) {
+    if (args[0]->getType() != parser::ast::NodeType::Identifier ||
+        std::static_pointer_cast<parser::ast::IdentifierNode>(args[0])
+                ->getValue() != ":test")
+      throw std::runtime_error("Unknown make-hash-table option");
+    // 'equal is a quoted identifier, #'equal a (function equal) list
+    auto test = args[1];
+    if (test->getType() == parser::ast::NodeType::Quoted)
+      test = std::static_pointer_cast<parser::ast::QuotedNode>(test)
+                 ->getExpression();
+    else if (test->getType() == parser::ast::NodeType::List &&
+             std::static_pointer_cast<parser::ast::ListNode>(test)
+                     ->getExpressions()
+                     .size() == 2)
+      test = std::static_pointer_cast<parser::ast::ListNode>(test)
+                 ->getExpressions()
+                 .back();
+    const std::string name =
+        test->getType() == parser::ast::NodeType::Identifier
+            ? std::static_pointer_cast<parser::ast::IdentifierNode>(test)
+                  ->getValue()
+            : "";
+    if (name == "equal")
+      structural = true;
+    else if (name != "eql")
+      throw std::runtime_error("Unsupported hash table test");
+  } else if (!args.empty()) {
+    throw std::runtime_error("Invalid make-hash-table");
+  }
+  _body += structural ? "MAKE_HASH_TABLE(true)" : "MAKE_HASH_TABLE(false)";
+}
+
+// (function name) or #'name, name is a defun or a builtin of fixed arity
+void generator::Generator::generateFunction(
+    const std::shared_ptr<parser::ast::ASTNode> &name) {
+  // #'(lambda ...) is the lambda itself
+  if (headKeyword(name) == "lambda") {
+    const auto &expressions =
+        std::static_pointer_cast<parser::ast::ListNode>(name)->getExpressions();
+    generateLambda(std::vector(expressions.begin() + 1, expressions.end()));
+    return;
+  }
+  if (name->getType() == parser::ast::NodeType::Identifier) {
+    const Value value = _scope->get(
+        std::static_pointer_cast<parser::ast::IdentifierNode>(name)
+            ->getValue());
+    if (value._type != ValueType::Function)
+      throw std::runtime_error("Not a function");
+    markCall(std::static_pointer_cast<parser::ast::IdentifierNode>(name)
+                 ->getValue(),
+             value._value);
+    _body += "FUNCTION(";
+    _body += value._value;
+    _body += ")";
+    return;
+  }
+  if (name->getType() != parser::ast::NodeType::Keyword)
+    throw std::runtime_error("Invalid function name");
+  const auto &keyword =
+      std::static_pointer_cast<parser::ast::KeywordNode>(name)->getValue();
+  if (!predefined_arity.contains(keyword))
+    throw std::runtime_error("Unsupported function: " + keyword);
+  if (keyword == "print")
+    markSideEffect(keyword, true);
+
+  // builtins are wrapped in a definition taking the arguments in order
+  const auto &builtin = predefined.at(keyword);
+  const std::string generated_name = "F_" + builtin;
+  if (!_wrapped.contains(builtin)) {
+    const int arity = predefined_arity.at(keyword);
+    _declarations.emplace_back(
+        generated_name, "DEF(" + generated_name + ",\"" + keyword + "\"," +
+                            std::to_string(arity) + "," +
+                            std::to_string(arity) + ",0,\"" +
+                            std::string(arity, 'b') + "\");\n");
+    _wrappers += "DEF_BODY(";
+    _wrappers += generated_name;
+    _wrappers += ",FUNC(";
+    _wrappers += builtin;
+    _wrappers += ", ";
+    for (int i = 0; i < arity; i++) {
+      _wrappers += "LOCAL(" + std::to_string(i) + ")";
+      _wrappers += ",";
+    }
+    _wrappers += "));\n";
+    _wrapped.insert(builtin);
+  }
+  _calls.insert(generated_name);
+  _body += "FUNCTION(";
+  _body += generated_name;
+  _body += ")";
+}
+
+// (reduce function sequence :initial-value value)
+void generator::Generator::generateReduce(
+    const std::vector<std::shared_ptr<parser::ast::ASTNode>> &args) {
+  if (!args.empty()) {
+    if (const long arity = knownArity(args[0]); arity >= 0)
+      checkArity("the function of reduce", 2, arity, arity);
+    if (!knownFunction(args[0]))
+      markSideEffect("reduce", false);
+  }
+  if (args.size() == 4) {
+    if (args[2]->getType() != parser::ast::NodeType::Identifier ||
+        std::static_pointer_cast<parser::ast::IdentifierNode>(args[2])
+                ->getValue() != ":initial-value")
+      throw std::runtime_error("Unknown reduce option");
+    generateFunctionCall("Reduce", {args[0], args[1], args[3]});
+  } else if (args.size() == 2) {
+    generateFunctionCall("Reduce", args);
+  } else {
+    throw std::runtime_error("Invalid reduce");
+  }
+}
+
+// (pcall function args...) or (pmapcar function lists...)
+// the arguments may run concurrently, so each of them gets let slots of its
+// own and none of them may have side effects, the runtime does not lock the
+// output, the hash tables or the vectors
+void generator::Generator::generateParallel(
+    const std::string &name,
+    const std::vector<std::shared_ptr<parser::ast::ASTNode>> &args) {
+  if (args.empty())
+    throw std::runtime_error("Invalid " + name);
+  if (name == "Pmapcar")
+    checkArity("pmapcar", args.size(), 2, SIZE_MAX);
+  // pcall passes one argument per form, pmapcar one per list
+  if (const long arity = knownArity(args[0]); arity >= 0)
+    checkArity(name == "Pcall" ? "the function of pcall"
+                               : "the function of pmapcar",
+               args.size() - 1, arity, arity);
+  // a function value only known at run time may have side effects
+  if (!knownFunction(args[0]))
+    throw std::runtime_error(
+        "Side effect inside pcall or pmapcar: unknown function");
+  const std::size_t first = _locals;
+  const std::size_t first_native = _natives;
+  _parallel++;
+  _body += "FUNC(";
+  _body += name;
+  _body += ", ";
+  const std::size_t shared_locals = _shared_locals;
+  const std::size_t shared_natives = _shared_natives;
+  for (const auto &expr : args) {
+    const std::size_t max_locals = _max_locals;
+    const std::size_t max_natives = _max_natives;
+    _max_locals = _locals;
+    _shared_locals = _locals;
+    _max_natives = _natives;
+    _shared_natives = _natives;
+    generateExpression(expr, false);
+    _body += ",";
+    _locals = _max_locals;
+    _max_locals = std::max(max_locals, _max_locals);
+    _natives = _max_natives;
+    _max_natives = std::max(max_natives, _max_natives);
+  }
+  _body += ")";
+  _parallel--;
+  _shared_locals = shared_locals;
+  _shared_natives = shared_natives;
+  _locals = first;
+  _natives = first_native;
+}
+
+// (declaim (optimize (safety 0))), the other qualities are accepted and ignored
+void generator::Generator::generateDeclaim(
+    const std::vector<std::shared_ptr<parser::ast::ASTNode>> &args) {
+  // the safety applies to the whole program, so it must be set before the
+  // code it affects is generated
+  if (_started)
+    throw std::runtime_error("Declamation after the first form");
+  for (const auto &arg : args) {
+    if (arg->getType() != parser::ast::NodeType::List)
+      throw std::runtime_error("Invalid declamation");
+    const auto &spec =
+        std::static_pointer_cast<parser::ast::ListNode>(arg)->getExpressions();
+    if (spec.empty() ||
+        spec.front()->getType() != parser::ast::NodeType::Identifier ||
+        std::static_pointer_cast<parser::ast::IdentifierNode>(spec.front())
+                ->getValue() != "optimize")
+      throw std::runtime_error("Unknown declamation");
+    for (auto it = spec.begin() + 1; it != spec.end(); ++it) {
+      // a quality alone means level 3
+      if ((*it)->getType() == parser::ast::NodeType::Identifier)
+        continue;
+      const auto &quality =
+          (*it)->getType() == parser::ast::NodeType::List
+              ? std::static_pointer_cast<parser::ast::ListNode>(*it)
+                    ->getExpressions()
+              : std::vector<std::shared_ptr<parser::ast::ASTNode>>();
+      if (quality.size() != 2 ||
+          quality[0]->getType() != parser::ast::NodeType::Identifier ||
+          quality[1]->getType() != parser::ast::NodeType::Integer)
+        throw std::runtime_error("Invalid optimize quality");
+      const auto &value =
+          std::static_pointer_cast<parser::ast::IntegerNode>(quality[1])
+              ->getValue();
+      int level;
+      if (const auto [ptr, error] = std::from_chars(
+              value.data(), value.data() + value.size(), level);
+          error != std::errc() || ptr != value.data() + value.size() ||
+          level < 0 || level > 3)
+        throw std::runtime_error("Invalid optimize quality");
+      if (std::static_pointer_cast<parser::ast::IdentifierNode>(quality[0])
+              ->getValue() == "safety")
+        _config.safety = level;
+    }
+  }
+  _body += "NIL()";
+}
+
+// (the fixnum expression) or (the double-float expression), the check is
+// left out when the type of the expression is known
+void generator::Generator::generateThe(
+    const std::vector<std::shared_ptr<parser::ast::ASTNode>> &args) {
+  if (args.size() != 2)
+    throw std::runtime_error("Invalid the");
+  const NativeType type =
+      args[0]->getType() == parser::ast::NodeType::Identifier
+          ? declaredType(
+                std::static_pointer_cast<parser::ast::IdentifierNode>(args[0])
+                    ->getValue())
+          : NativeType::None;
+  checkDeclared("the", type, args[1]);
+  if (type == NativeType::None || staticType(args[1]) == type) {
+    generateExpression(args[1], false);
+    return;
+  }
+  _body += type == NativeType::Fixnum ? "FUNC(TheFixnum, " : "FUNC(TheDouble, ";
+  generateExpression(args[1], false);
+  _body += ")";
+}
+
+// arithmetic or a comparison on operands of a known type, a fixnum operand
+// of a double-float operation is converted
+void generator::Generator::generateTypedCall(
+    const std::string &name, const NativeType type,
+    const std::vector<std::shared_ptr<parser::ast::ASTNode>> &args) {
+  _body += "FUNC(";
+  _body += type == NativeType::Fixnum ? "Fixnum" : "Double";
+  _body += typed_builtins.at(name);
+  _body += ", ";
+  for (const auto &arg : args) {
+    const bool convert = type == NativeType::Double &&
+                         staticType(arg) == NativeType::Fixnum;
+    if (convert)
+      _body += "FUNC(TheFixnum, ";
+    generateExpression(arg, false);
+    _body += convert ? ")," : ",";
+  }
+  _body += ")";
+}
+
+// the type of a form as far as the declarations tell, without generating it
+generator::NativeType generator::Generator::staticType(
+    const std::shared_ptr<parser::ast::ASTNode> &ast) {
+  switch (ast->getType()) {
+  case parser::ast::NodeType::Integer: {
+    const auto &value =
+        std::static_pointer_cast<parser::ast::IntegerNode>(ast)->getValue();
+    long long fixnum;
+    if (const auto [ptr, error] = std::from_chars(
+            value.data(), value.data() + value.size(), fixnum);
+        error == std::errc() && fixnum != LLONG_MIN)
+      return NativeType::Fixnum;
+    return NativeType::None;
+  }
+  case parser::ast::NodeType::Floating:
+    return NativeType::Double;
+  case parser::ast::NodeType::Identifier: {
+    const auto &name =
+        std::static_pointer_cast<parser::ast::IdentifierNode>(ast)->getValue();
+    if (name.starts_with(':'))
+      return NativeType::None;
+    return _scope->get(name)._native;
+  }
+  case parser::ast::NodeType::List:
+    break;
+  default:
+    return NativeType::None;
+  }
+  // the scope only grows, so a type found in it stays valid
+  if (_typed_scope != _scope) {
+    _form_types.clear();
+    _typed_scope = _scope;
+  }
+  if (const auto known = _form_types.find(ast); known != _form_types.end())
+    return known->second;
+  const NativeType type = formType(ast);
+  _form_types.emplace(ast, type);
+  return type;
+}
+
+// the type of a list form, see staticType
+generator::NativeType generator::Generator::formType(
+    const std::shared_ptr<parser::ast::ASTNode> &ast) {
+  const auto head = headKeyword(ast);
+  const auto &expressions =
+      std::static_pointer_cast<parser::ast::ListNode>(ast)->getExpressions();
+  const auto rest = std::vector(expressions.begin() + 1, expressions.end());
+  if (head == "the" && rest.size() == 2 &&
+      rest[0]->getType() == parser::ast::NodeType::Identifier)
+    return declaredType(
+        std::static_pointer_cast<parser::ast::IdentifierNode>(rest[0])
+            ->getValue());
+  if (head == "if" && rest.size() == 3) {
+    const NativeType type = staticType(rest[1]);
+    return staticType(rest[2]) == type ? type : NativeType::None;
+  }
+  if (head == "progn" && !rest.empty())
+    return staticType(rest.back());
+  if ((head == "+" || head == "-" || head == "*" || head == "/") &&
+      rest.size() == 2)
+    return operandType(head, rest);
+  return NativeType::None;
+}
+
+// the type the operands of an arithmetic or a comparison are computed in:
+// fixnum when both are fixnums, double-float when both are numbers of a
+// known type and one is a double-float
+generator::NativeType generator::Generator::operandType(
+    const std::string &name,
+    const std::vector<std::shared_ptr<parser::ast::ASTNode>> &args) {
+  if (args.size() != 2)
+    return NativeType::None;
+  const NativeType a = staticType(args[0]), b = staticType(args[1]);
+  if (a == NativeType::None || b == NativeType::None)
+    return NativeType::None;
+  if (a == NativeType::Fixnum && b == NativeType::Fixnum)
+    // the quotient of two fixnums may be a fraction
+    return name == "/" ? NativeType::None : NativeType::Fixnum;
+  return NativeType::Double;
+}
+
+// reject a value whose type is known to differ from a declaration
+void generator::Generator::checkDeclared(
+    const std::string &name, const NativeType type,
+    const std::shared_ptr<parser::ast::ASTNode> &value) {
+  if (type == NativeType::None)
+    return;
+  if (const NativeType actual = staticType(value);
+      actual != NativeType::None && actual != type) {
+    // reported at the value
+    if (value->getLine() != 0)
+      _current = value.get();
+    throw std::runtime_error(
+        std::string("Invalid type for ") +
+        (type == NativeType::Fixnum ? "fixnum" : "double-float") +
+        " declaration: " + name);
+  }
+}
+
+// reject a call with the wrong number of arguments
+void generator::Generator::checkArity(const std::string &name,
+                                      const std::size_t count,
+                                      const std::size_t min,
+                                      const std::size_t max) const {
+  if (count >= min && count <= max)
+    return;
+  std::string expected = std::to_string(min);
+  if (max == SIZE_MAX)
+    expected = "at least " + expected;
+  else if (max != min)
+    expected += " to " + std::to_string(max);
+  throw std::runtime_error("Invalid number of arguments to " + name +
+                           ": expected " + expected + ", got " +
+                           std::to_string(count));
+}
+
+// the number of arguments of #'name or a lambda, or -1 if it is not known
+long generator::Generator::knownArity(
+    const std::shared_ptr<parser::ast::ASTNode> &function) {
+  auto target = function;
+  if (headKeyword(target) == "function")
+    target = std::static_pointer_cast<parser::ast::ListNode>(target)
+                 ->getExpressions()
+                 .back();
+  else if (headKeyword(target) != "lambda")
+    return -1;
+  if (headKeyword(target) == "lambda") {
+    const auto &lambda =
+        std::static_pointer_cast<parser::ast::ListNode>(target)
+            ->getExpressions();
+    if (lambda.size() < 2)
+      return -1;
+    if (lambda[1]->getType() == parser::ast::NodeType::List)
+      return static_cast<long>(
+          std::static_pointer_cast<parser::ast::ListNode>(lambda[1])
+              ->getExpressions()
+              .size());
+    return 0;
+  }
+  if (target->getType() == parser::ast::NodeType::Keyword) {
+    const auto &keyword =
+        std::static_pointer_cast<parser::ast::KeywordNode>(target)->getValue();
+    return predefined_arity.contains(keyword) ? predefined_arity.at(keyword)
+                                              : -1;
+  }
+  if (target->getType() != parser::ast::NodeType::Identifier)
+    return -1;
+  const Value value = _scope->get(
+      std::static_pointer_cast<parser::ast::IdentifierNode>(target)
+          ->getValue());
+  if (value._type != ValueType::Function)
+    return -1;
+  return static_cast<long>(value._arity);
+}
+
+// a lambda, or #'name of a defun or a builtin, whose side effects are known
+// when it is generated
+bool generator::Generator::knownFunction(
+    const std::shared_ptr<parser::ast::ASTNode> &function) {
+  if (knownArity(function) >= 0)
+    return true;
+  return headKeyword(function) == "function" &&
+         std::static_pointer_cast<parser::ast::ListNode>(function)
+                 ->getExpressions()
+                 .back()
+                 ->getType() == parser::ast::NodeType::Keyword;
+}
+
+// side effects make the current definition impure, and may not run in
+// parallel since neither the output nor the tables and vectors are locked
+void generator::Generator::markSideEffect(const std::string &name,
+                                          const bool output) {
+  if (_parallel)
+    throw std::runtime_error("Side effect inside pcall or pmapcar: " + name);
+  if (output)
+    _prints = true;
+  _side_effect = true;
+}
+
+// calling a definition has the side effects of its body, and the unit
+// calling it depends on its declaration
+void generator::Generator::markCall(const std::string &name,
+                                    const std::string &generated_name) {
+  _calls.insert(generated_name);
+  if (_printing.contains(generated_name))
+    markSideEffect(name, true);
+  else if (_impure.contains(generated_name))
+    markSideEffect(name, false);
+}
+
+// (declare (memoize)), (declare (memoize size)), or type declarations like
+// (declare (type fixnum x y)) and (declare (double-float z))
+void generator::Generator::parseDeclarations(
+    const std::vector<std::shared_ptr<parser::ast::ASTNode>> &forms,
+    Declarations &declarations) {
+  for (const auto &form : forms) {
+    if (form->getType() != parser::ast::NodeType::List)
+      throw std::runtime_error("Invalid function body");
+    const auto &declare =
+        std::static_pointer_cast<parser::ast::ListNode>(form)->getExpressions();
+    if (declare.empty() ||
+        declare.front()->getType() != parser::ast::NodeType::Keyword ||
+        std::static_pointer_cast<parser::ast::KeywordNode>(declare.front())
+                ->getValue() != "declare")
+      throw std::runtime_error("Invalid function body");
+    for (auto it = declare.begin() + 1; it != declare.end(); ++it) {
+      if ((*it)->getType() != parser::ast::NodeType::List)
+        throw std::runtime_error("Invalid declaration");
+      const auto &spec =
+          std::static_pointer_cast<parser::ast::ListNode>(*it)->getExpressions();
+      if (spec.empty() ||
+          spec.front()->getType() != parser::ast::NodeType::Identifier)
+        throw std::runtime_error("Invalid declaration");
+      const auto &kind =
+          std::static_pointer_cast<parser::ast::IdentifierNode>(spec.front())
+              ->getValue();
+      if (kind == "memoize" && spec.size() <= 2) {
+        declarations.memoize = true;
+        if (spec.size() == 2) {
+          if (spec[1]->getType() != parser::ast::NodeType::Integer)
+            throw std::runtime_error("Invalid memoize size");
+          const auto &value =
+              std::static_pointer_cast<parser::ast::IntegerNode>(spec[1])
+                  ->getValue();
+          if (const auto [ptr, error] =
+                  std::from_chars(value.data(), value.data() + value.size(),
+                                  declarations.memo_size);
+              error != std::errc() || ptr != value.data() + value.size())
+            throw std::runtime_error("Invalid memoize size");
+        }
+      } else if (kind == "type" || declaredType(kind) != NativeType::None) {
+        // other types are accepted and the variables stay boxed
+        auto variable = spec.begin() + 1;
+        NativeType type = declaredType(kind);
+        if (kind == "type") {
+          if (variable == spec.end())
+            throw std::runtime_error("Invalid declaration");
+          if ((*variable)->getType() == parser::ast::NodeType::Identifier)
+            type = declaredType(
+                std::static_pointer_cast<parser::ast::IdentifierNode>(
+                    *variable)
+                    ->getValue());
+          ++variable;
+        }
+        for (; variable != spec.end(); ++variable) {
+          if ((*variable)->getType() != parser::ast::NodeType::Identifier)
+            throw std::runtime_error("Invalid declaration");
+          if (type != NativeType::None)
+            declarations.types[std::static_pointer_cast<
+                                   parser::ast::IdentifierNode>(*variable)
+                                   ->getValue()] = type;
+        }
+      } else {
+        throw std::runtime_error("Unknown declaration: " + kind);
+      }
+    }
+  }
 }
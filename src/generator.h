@@ -2,9 +2,12 @@
 #define GENERATOR_H
 
 #include "ast.h"
+#include "module.h"
 #include <memory>
+#include <set>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 
 namespace generator {
@@ -14,41 +17,131 @@ enum class ValueType {
   Expression,
 };
 
+// the declared type of a variable, typed variables live unboxed
+enum class NativeType {
+  None,
+  Fixnum,
+  Double,
+};
+
 struct Value {
   ~Value() = default;
   explicit Value() = default;
-  explicit Value(const ValueType type, std::string value)
-      : _type(type), _value(std::move(value)) {}
+  explicit Value(const ValueType type, std::string value,
+                 std::shared_ptr<parser::ast::ASTNode> region = nullptr)
+      : _type(type), _value(std::move(value)), _region(std::move(region)) {}
 
   ValueType _type{};
   std::string _value;
+  std::size_t _arity = 0; // number of arguments of a function
+  std::string _kinds; // b, f or d per argument of a function, f for fixnum
+  NativeType _native = NativeType::None; // declared type of a variable
+  // the forms where a variable is visible, to find assignments to it
+  std::shared_ptr<parser::ast::ASTNode> _region;
 };
 
 class Scope {
 public:
-  explicit Scope(const std::shared_ptr<Scope> &parent) : _parent(parent) {}
+  // the scope of a lambda captures the variables of the enclosing frames
+  explicit Scope(const std::shared_ptr<Scope> &parent, const bool closure = false)
+      : _parent(parent), _closure(closure) {}
   Value get(const std::string &name);
   void set(const std::string &name, const Value &value, bool top = false);
   std::shared_ptr<Scope> getParent() { return _parent; }
+  // captured variables with their value in the enclosing scope, in order
+  const std::vector<std::pair<std::string, Value>> &getCaptures() const {
+    return _captures;
+  }
 
 private:
   std::shared_ptr<Scope> _parent;
+  bool _closure;
+  std::vector<std::pair<std::string, Value>> _captures;
   std::unordered_map<std::string, Value> _symbols;
 };
 
+// declarations of a defun, from its (declare ...) forms
+struct Declarations {
+  bool memoize = false;      // cache results on the arguments
+  std::size_t memo_size = 0; // entries kept, 0 for the runtime default
+  // variables declared fixnum or double-float
+  std::unordered_map<std::string, NativeType> types;
+};
+
+struct Config {
+  bool profile = false; // instrument functions and builtins for profiling
+  int safety = 1;       // 0 omits the dynamic type checks
+  bool eliminate_dead_code = true; // drop unused defuns and pure forms
+  std::string module; // name of the module compiled, empty for a program
+  std::vector<modules::Interface> imports; // modules whose functions it calls
+  // every module of a program, in the order to initialize them
+  std::vector<modules::Interface> modules;
+  std::string source; // the lisp file, for errors and the #line directives
+  // #line directives mapping the functions and forms to their lisp lines
+  bool line_directives = false;
+};
+
+// a #line directive numbering the line after it as this line of the file
+std::string lineDirective(std::size_t line, const std::string &file);
+
+// ends the lisp code of a function or form in the generated code, it maps
+// the lines after it back to the file the code is written to, see
+// driver::update
+inline const std::string resume_line = "#line resume\n";
+
+// a file of a split program, compiled on its own: a defun with the lambdas
+// it creates, or the top-level forms
+struct Unit {
+  std::string name; // generated name of the defun, program for the forms
+  std::string code; // the file after the #include of the header
+  std::vector<std::string> calls; // generated names of the functions called
+};
+
+// the program split in units sharing one header, for incremental builds
+struct Split {
+  // the runtime and the linkage, the header without the declarations
+  std::string prelude;
+  std::string header;
+  // the declaration of every function by generated name, a unit depends on
+  // the declarations of the functions it calls
+  std::vector<std::pair<std::string, std::string>> declarations;
+  std::vector<Unit> units;
+};
+
+// the units of a split program grouped in count files of similar size,
+// the code of each file after the #include of the header
+std::vector<std::string> partition(const Split &split, std::size_t count);
+
 class Generator {
 public:
-  explicit Generator(const std::shared_ptr<parser::ast::ASTNode> &ast)
-      : _ast(ast), _scope(nullptr) {}
+  explicit Generator(const std::shared_ptr<parser::ast::ASTNode> &ast,
+                     const Config &config = Config())
+      : _ast(ast), _config(config), _scope(nullptr) {}
   std::string generate();
+  // the same program as units, valid after generate
+  Split getSplit() const;
+  // top-level forms removed by dead code elimination, in program order
+  const std::vector<std::string> &getEliminated() const { return _eliminated; }
+  // functions defined by a module, for its interface
+  std::vector<modules::Export> getExports() const;
 
 private:
+  std::string defines() const;
+  std::string location(const parser::ast::ASTNode *ast = nullptr) const;
+  std::string mapped(const std::shared_ptr<parser::ast::ASTNode> &ast,
+                     const std::string &code) const;
+  std::string fill(std::string content, const std::string &linkage,
+                   const std::string &definitions) const;
   void generateProgram(const std::shared_ptr<parser::ast::ASTNode> &ast);
+  void findDeadCode(
+      const std::vector<std::shared_ptr<parser::ast::ASTNode>> &forms);
   void generateExpression(const std::shared_ptr<parser::ast::ASTNode> &ast,
                           bool quoted);
   void generateLiteral(const std::shared_ptr<parser::ast::ASTNode> &ast);
+  void generateConstant(const std::shared_ptr<parser::ast::ASTNode> &ast);
   void generateIdentifier(const std::shared_ptr<parser::ast::ASTNode> &ast,
                           bool quoted);
+  void generateSymbol(const std::string &name);
   void generateKeyword(const std::shared_ptr<parser::ast::ASTNode> &ast,
                        bool quoted);
   void generateQuoted(const std::shared_ptr<parser::ast::ASTNode> &ast,
@@ -58,14 +151,101 @@ private:
   void generateFunctionCall(
       const std::string &name,
       const std::vector<std::shared_ptr<parser::ast::ASTNode>> &args);
-  void generateDefun(const std::shared_ptr<parser::ast::ASTNode> &name,
-                     const std::shared_ptr<parser::ast::ASTNode> &args,
-                     const std::shared_ptr<parser::ast::ASTNode> &body);
-  void generateLet(const std::shared_ptr<parser::ast::ASTNode> &assignments,
-                   const std::shared_ptr<parser::ast::ASTNode> &body);
+  void generateDefun(
+      const std::shared_ptr<parser::ast::ASTNode> &name,
+      const std::shared_ptr<parser::ast::ASTNode> &args,
+      const std::vector<std::shared_ptr<parser::ast::ASTNode>> &declarations,
+      const std::shared_ptr<parser::ast::ASTNode> &body, bool memoize);
+  void parseDeclarations(
+      const std::vector<std::shared_ptr<parser::ast::ASTNode>> &forms,
+      Declarations &declarations);
+  void generateLet(
+      const std::shared_ptr<parser::ast::ASTNode> &assignments,
+      const std::vector<std::shared_ptr<parser::ast::ASTNode>> &declarations,
+      const std::shared_ptr<parser::ast::ASTNode> &body);
+  void generateLambda(
+      const std::vector<std::shared_ptr<parser::ast::ASTNode>> &args);
+  void generateFuncall(
+      const std::vector<std::shared_ptr<parser::ast::ASTNode>> &args);
+  void generateSetq(
+      const std::vector<std::shared_ptr<parser::ast::ASTNode>> &args);
+  void generateIteration(
+      const std::string &name,
+      const std::vector<std::shared_ptr<parser::ast::ASTNode>> &args);
+  void generateLoop(
+      const std::vector<std::shared_ptr<parser::ast::ASTNode>> &args);
+  void generateMakeArray(
+      const std::vector<std::shared_ptr<parser::ast::ASTNode>> &args);
+  void generateMakeHashTable(
+      const std::vector<std::shared_ptr<parser::ast::ASTNode>> &args);
+  void generateSetf(const std::shared_ptr<parser::ast::ASTNode> &place,
+                    const std::shared_ptr<parser::ast::ASTNode> &value);
+  void generateFunction(const std::shared_ptr<parser::ast::ASTNode> &name);
+  void generateReduce(
+      const std::vector<std::shared_ptr<parser::ast::ASTNode>> &args);
+  void generateParallel(
+      const std::string &name,
+      const std::vector<std::shared_ptr<parser::ast::ASTNode>> &args);
+  void generateDeclaim(
+      const std::vector<std::shared_ptr<parser::ast::ASTNode>> &args);
+  void generateThe(
+      const std::vector<std::shared_ptr<parser::ast::ASTNode>> &args);
+  void generateTypedCall(
+      const std::string &name, NativeType type,
+      const std::vector<std::shared_ptr<parser::ast::ASTNode>> &args);
+  NativeType staticType(const std::shared_ptr<parser::ast::ASTNode> &ast);
+  NativeType formType(const std::shared_ptr<parser::ast::ASTNode> &ast);
+  NativeType operandType(
+      const std::string &name,
+      const std::vector<std::shared_ptr<parser::ast::ASTNode>> &args);
+  void checkDeclared(const std::string &name, NativeType type,
+                     const std::shared_ptr<parser::ast::ASTNode> &value);
+  void checkArity(const std::string &name, std::size_t count,
+                  std::size_t min, std::size_t max) const;
+  long knownArity(const std::shared_ptr<parser::ast::ASTNode> &function);
+  bool knownFunction(const std::shared_ptr<parser::ast::ASTNode> &function);
+  void markSideEffect(const std::string &name, bool output);
+  void markCall(const std::string &name, const std::string &generated_name);
   std::shared_ptr<parser::ast::ASTNode> _ast;
+  Config _config;
   std::shared_ptr<Scope> _scope;
-  std::string _header;
+  std::shared_ptr<Scope> _global;
+  // the static types of the forms already looked at in _typed_scope, every
+  // level of a nested form asks for the types of the forms below it
+  std::shared_ptr<Scope> _typed_scope;
+  std::unordered_map<std::shared_ptr<parser::ast::ASTNode>, NativeType>
+      _form_types;
+  std::size_t _locals = 0;     // next free local variable slot
+  std::size_t _max_locals = 0; // slots needed by the current frame
+  std::size_t _natives = 0;     // next free unboxed slot
+  std::size_t _max_natives = 0; // unboxed slots needed by the current frame
+  std::unordered_set<std::string> _wrapped; // builtins wrapped for #'
+  // generated names of the quoted lists and strings by their code
+  std::unordered_map<std::string, std::string> _constants;
+  std::unordered_set<std::string> _printing; // definitions that print
+  std::unordered_set<std::string> _impure;   // definitions with side effects
+  bool _prints = false;      // the current definition prints
+  bool _side_effect = false; // the current definition has side effects
+  int _parallel = 0;         // depth of pcall and pmapcar arguments
+  bool _started = false;     // a form other than declaim was generated
+  std::size_t _shared_locals = 0; // slots shared by the parallel arguments
+  std::size_t _shared_natives = 0;
+  // the innermost form with a position being generated, for errors
+  const parser::ast::ASTNode *_current = nullptr;
+  std::unordered_set<const parser::ast::ASTNode *> _dead; // forms to drop
+  std::vector<std::string> _eliminated;
+  // defined functions by generated name, exported by a module
+  std::vector<std::pair<std::string, modules::Export>> _defined;
+  std::string _linkage; // functions and initializers of the imported modules
+  // the declaration of every function, before any definition
+  std::vector<std::pair<std::string, std::string>> _declarations;
+  std::vector<Unit> _units; // the defuns, each with its definitions
+  std::string _definitions; // definitions of the unit being generated
+  std::set<std::string> _calls; // functions called by the unit
+  std::string _unit;            // generated name of the unit, empty for forms
+  std::size_t _closures = 0;    // lambdas of the unit
+  std::string _wrappers; // definitions of the builtins wrapped for #'
+  std::string _entry;    // exports with module initializer, or program entry
   std::string _body;
 };
 
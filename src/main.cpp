@@ -1,19 +1,28 @@
+#include "build.h"
 #include "generator.h"
+#include "module.h"
+#include "options.h"
 #include "parser.h"
+#include "report.h"
+#include <algorithm>
 #include <cstdlib>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <string>
+#include <thread>
 
 int main(const int argc, char *argv[]) {
   try {
-    if (argc != 2) {
-      std::cerr << "Usage: lisp-compiler <filename>" << std::endl;
+    driver::Options options;
+    try {
+      options = driver::parseOptions(argc, argv);
+    } catch (const std::invalid_argument &e) {
+      std::cerr << e.what() << std::endl << driver::usage;
       return 1;
     }
 
-    const std::string filename = argv[1];
+    const std::string filename = options.filename;
     if (std::ifstream file(filename); !file.is_open()) {
       std::cerr << "Could not open file: " << filename << std::endl;
       return 1;
@@ -24,51 +33,148 @@ int main(const int argc, char *argv[]) {
     source.assign((std::istreambuf_iterator<char>(file)),
                   std::istreambuf_iterator<char>());
 
-    parser::Parser parser(source);
-    auto ast = parser.parse();
+    report::Report report;
+    parser::Parser parser(source, filename);
+    report.time("preprocess", [&] { parser.preprocess(); });
+    report.time("tokenize", [&] { parser.tokenize(); });
+    report.time("parse", [&] { parser.parseTokens(); });
+    const auto &ast = parser.getAST();
     // printAST(ast); // uncomment to print the AST
 
-    generator::Generator generator(ast);
-    const auto output = generator.generate();
+    generator::Config config;
+    config.profile = options.profile;
+    config.safety = options.safety;
+    config.eliminate_dead_code = options.dead_code_elimination;
+    if (options.module)
+      config.module = modules::moduleName(filename);
+    for (const auto &import : options.imports)
+      config.imports.push_back(modules::readInterface(import));
+    config.modules = modules::loadInterfaces(options.imports);
+    config.source = filename;
+    config.line_directives = options.debug;
+    generator::Generator generator(ast, config);
+    const auto output =
+        report.time("generate", [&] { return generator.generate(); });
+    if (options.dead_code_summary) {
+      const auto &eliminated = generator.getEliminated();
+      std::cerr << "Dead code elimination removed " << eliminated.size()
+                << " top-level form(s)" << std::endl;
+      for (const auto &form : eliminated)
+        std::cerr << "  " << form << std::endl;
+    }
 
-    // write the generated code to a file at the same location as the input file
     std::filesystem::path input_path(filename);
-    std::filesystem::path output_path = input_path.parent_path() / "middle.cpp";
-    std::filesystem::path executable_path = input_path.parent_path() / "output";
-
-    // Write the generated code to the output file
-    std::ofstream out(output_path);
-    if (!out) {
-      throw std::ios_base::failure("Failed to open output file: " +
-                                   output_path.string());
-    }
-    out << output;
-    out.close();
+    // one g++ process per core by default
+    const unsigned jobs =
+        options.jobs ? options.jobs
+                     : std::max(std::thread::hardware_concurrency(), 1u);
+    std::string flags = driver::optimizationFlags(options.optimization);
+    if (options.debug)
+      flags += " -g";
+    if (options.emit_cpp) {
+      const std::string cpp_path = filename + ".cpp";
+      report.time("write", [&] { driver::update(cpp_path, output); });
+      std::cout << "C++ generated at: " << cpp_path << std::endl;
+    } else if (options.incremental) {
+      const auto compiled = driver::buildIncremental(
+          generator.getSplit(),
+          input_path.parent_path() / (input_path.stem().string() + ".cache"),
+          filename + ".out", config.modules, flags, jobs, report);
+      std::cout << "Recompiled " << compiled.size() << " unit(s):";
+      for (const auto &name : compiled)
+        std::cout << " " << name;
+      std::cout << std::endl;
+      std::cout << "Compilation successful. Executable created at: "
+                << filename << ".out" << std::endl;
+    } else if (options.module) {
+      // modules of one directory may be compiled at the same time
+      std::filesystem::path output_path =
+          input_path.parent_path() / (config.module + ".middle.cpp");
+      report.time("write", [&] { driver::update(output_path, output); });
 
-    std::string compile_command =
-        "g++ -O2 -o " + filename + ".out " + output_path.string();
-    if (std::system(compile_command.c_str()) != 0) {
-      throw std::runtime_error("Compilation failed");
-    }
+      // a module compiles to an object file and an interface
+      std::filesystem::path object_path = input_path;
+      object_path.replace_extension(".o");
+      const std::string compile_command =
+          "g++ " + flags + " -pthread -c -o " + object_path.string() + " " +
+          output_path.string();
+      if (report.time("compile", [&] {
+            return std::system(compile_command.c_str());
+          }) != 0) {
+        throw std::runtime_error("Compilation failed");
+      }
+      if (options.keep_cpp)
+        std::cout << "C++ kept at: " << output_path.string() << std::endl;
+      else
+        std::filesystem::remove(output_path);
 
-    std::cout << "Compilation successful. Executable created at: "
-              << executable_path.string() << std::endl;
+      modules::Interface unit;
+      unit.name = config.module;
+      unit.object = object_path.string();
+      unit.imports = options.imports;
+      unit.exports = generator.getExports();
+      std::filesystem::path interface_path = input_path;
+      interface_path.replace_extension(".lispi");
+      modules::writeInterface(interface_path.string(), unit);
+      std::cout << "Compilation successful. Module created at: "
+                << object_path.string() << std::endl;
+    } else {
+      // a large program is split in one file per job, sharing a header with
+      // the runtime and the declarations, and compiled concurrently; every
+      // file compiles the runtime, so by default a file gets at least
+      // split_size bytes of generated code
+      constexpr std::size_t split_size = 64 * 1024;
+      const auto split = generator.getSplit();
+      std::size_t parts = std::min<std::size_t>(jobs, split.units.size());
+      if (!options.jobs) {
+        std::size_t size = 0;
+        for (const auto &unit : split.units)
+          size += unit.code.size();
+        parts = std::min(parts, 1 + size / split_size);
+      }
+      std::vector<std::filesystem::path> sources;
+      report.time("write", [&] {
+        if (parts <= 1) {
+          sources.push_back(input_path.parent_path() / "middle.cpp");
+          driver::update(sources.back(), output);
+          return;
+        }
+        driver::update(input_path.parent_path() / "middle.h", split.header);
+        const auto files = generator::partition(split, parts);
+        for (std::size_t i = 0; i < files.size(); i++) {
+          sources.push_back(input_path.parent_path() /
+                            ("middle." + std::to_string(i) + ".cpp"));
+          driver::update(sources.back(),
+                         "#include \"middle.h\"\n\n" + files[i]);
+        }
+      });
 
-    const bool generate_assembly = true; // set to true to generate assembly
-    if (generate_assembly) {
-      std::filesystem::path assembly_path =
+      const std::filesystem::path assembly_path =
           input_path.parent_path() / "output.s";
-      std::string assembly_command = "g++ -O2 -masm=att -S -o " +
-                                     assembly_path.string() + " " +
-                                     output_path.string();
-      if (std::system(assembly_command.c_str()) != 0) {
-        throw std::runtime_error("Assembly generation failed");
+      driver::buildProgram(sources, filename + ".out", config.modules,
+                           assembly_path, flags, options.training, jobs,
+                           report);
+      if (options.keep_cpp) {
+        for (const auto &source : sources)
+          std::cout << "C++ kept at: " << source.string() << std::endl;
+      } else {
+        for (const auto &source : sources)
+          std::filesystem::remove(source);
+        std::filesystem::remove(input_path.parent_path() / "middle.h");
       }
+      std::cout << "Compilation successful. Executable created at: "
+                << filename << ".out" << std::endl;
       std::cout << "Assembly generated at: " << assembly_path.string()
                 << std::endl;
     }
-    std::filesystem::remove(output_path); // comment this line to keep the
-    // generated code
+
+    report.count("tokens", parser.getTokenCount());
+    report.count("ast_nodes", parser::ast::countAST(ast));
+    report.count("generated_bytes", output.size());
+    if (options.time_passes == driver::TimePasses::Text)
+      report.print(std::cerr);
+    else if (options.time_passes == driver::TimePasses::Json)
+      report.printJson(std::cerr);
 
   } catch (const std::exception &e) {
     std::cerr << e.what() << std::endl;
@@ -77,4 +183,3 @@ int main(const int argc, char *argv[]) {
 
   return 0;
 }
-
@@ -0,0 +1,136 @@
+#include "module.h"
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace {
+
+// the interface files record paths relative to their own directory
+std::string resolve(const std::string &interface, const std::string &path) {
+  return (std::filesystem::path(interface).parent_path() / path)
+      .lexically_normal()
+      .string();
+}
+
+std::string relative(const std::string &interface, const std::string &path) {
+  const auto base = std::filesystem::absolute(interface).parent_path();
+  return std::filesystem::absolute(path).lexically_relative(base).string();
+}
+
+} // namespace
+
+// lisp identifiers can not contain underscores, so different names give
+// different identifiers
+std::string modules::identifier(const std::string &name) {
+  std::string result;
+  for (const auto c : name)
+    result += std::isalnum(static_cast<unsigned char>(c)) ? c : '_';
+  return result;
+}
+
+std::string modules::moduleName(const std::string &filename) {
+  return identifier(std::filesystem::path(filename).stem().string());
+}
+
+// lengths prefix both names, so two pairs of names never give the same
+// symbol
+std::string modules::mangle(const std::string &module,
+                            const std::string &name) {
+  const std::string function = identifier(name);
+  return "lisp_" + std::to_string(module.size()) + module +
+         std::to_string(function.size()) + function;
+}
+
+std::string modules::initializer(const std::string &module) {
+  return "lisp_init_" + std::to_string(module.size()) + module;
+}
+
+// format, one entry per line:
+//   lisp-module 1
+//   name <module>
+//   object <object file>
+//   import <interface file>
+//   export <name> <arity> <kinds or -> <effects or -> <symbol>
+modules::Interface modules::readInterface(const std::string &path) {
+  std::ifstream file(path);
+  if (!file.is_open())
+    throw std::runtime_error("Could not open interface: " + path);
+  Interface unit;
+  unit.path = path;
+  std::string line;
+  if (!std::getline(file, line) || line != "lisp-module 1")
+    throw std::runtime_error("Invalid interface: " + path);
+  while (std::getline(file, line)) {
+    std::istringstream in(line);
+    std::string kind;
+    in >> kind;
+    if (kind == "name") {
+      in >> unit.name;
+    } else if (kind == "object") {
+      in >> unit.object;
+      unit.object = resolve(path, unit.object);
+    } else if (kind == "import") {
+      std::string import;
+      in >> import;
+      unit.imports.push_back(resolve(path, import));
+    } else if (kind == "export") {
+      Export function;
+      in >> function.name >> function.arity >> function.kinds >>
+          function.effects >> function.symbol;
+      if (function.kinds == "-")
+        function.kinds.clear();
+      if (function.effects == "-")
+        function.effects.clear();
+      unit.exports.push_back(function);
+    } else if (!kind.empty()) {
+      throw std::runtime_error("Invalid interface: " + path);
+    }
+    if (in.fail())
+      throw std::runtime_error("Invalid interface: " + path);
+  }
+  if (unit.name.empty() || unit.object.empty())
+    throw std::runtime_error("Invalid interface: " + path);
+  return unit;
+}
+
+void modules::writeInterface(const std::string &path, const Interface &unit) {
+  std::ofstream out(path);
+  if (!out)
+    throw std::ios_base::failure("Failed to open output file: " + path);
+  out << "lisp-module 1\n";
+  out << "name " << unit.name << "\n";
+  out << "object " << relative(path, unit.object) << "\n";
+  for (const auto &import : unit.imports)
+    out << "import " << relative(path, import) << "\n";
+  for (const auto &function : unit.exports)
+    out << "export " << function.name << " " << function.arity << " "
+        << (function.kinds.empty() ? "-" : function.kinds) << " "
+        << (function.effects.empty() ? "-" : function.effects) << " "
+        << function.symbol << "\n";
+}
+
+std::vector<modules::Interface>
+modules::loadInterfaces(const std::vector<std::string> &paths) {
+  std::vector<Interface> result;
+  std::unordered_set<std::string> done, loading;
+  std::function<void(const std::string &)> load = [&](const std::string &path) {
+    const auto key = std::filesystem::weakly_canonical(path).string();
+    if (done.contains(key))
+      return;
+    if (!loading.insert(key).second)
+      throw std::runtime_error("Circular import: " + path);
+    auto unit = readInterface(path);
+    for (const auto &import : unit.imports)
+      load(import);
+    loading.erase(key);
+    done.insert(key);
+    result.push_back(std::move(unit));
+  };
+  for (const auto &path : paths)
+    load(path);
+  return result;
+}
@@ -0,0 +1,48 @@
+#ifndef MODULE_H
+#define MODULE_H
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace modules {
+
+// a function exported by a module
+struct Export {
+  std::string name;    // lisp name
+  std::size_t arity = 0;
+  std::string kinds;   // b, f or d per argument, empty if all are boxed
+  std::string effects; // p if it prints, s if it has other side effects
+  std::string symbol;  // C++ name of its apply function
+};
+
+// the interface of a compiled module, written next to its object file
+struct Interface {
+  std::string path;   // the interface file itself
+  std::string name;   // module name, from the file name of the source
+  std::string object; // object file to link
+  std::vector<std::string> imports; // interface files it was compiled with
+  std::vector<Export> exports;
+};
+
+// a C++ identifier, the letters and digits of a name with underscores for
+// the other characters
+std::string identifier(const std::string &name);
+// the module name of a source file, its stem made a C++ identifier
+std::string moduleName(const std::string &filename);
+// the C++ symbol of a function of a module, it only depends on the two names
+// so that other modules keep linking when the module is rebuilt
+std::string mangle(const std::string &module, const std::string &name);
+// the C++ symbol of the function running the top-level forms of a module
+std::string initializer(const std::string &module);
+
+// throw std::runtime_error if the file is missing or malformed
+Interface readInterface(const std::string &path);
+void writeInterface(const std::string &path, const Interface &unit);
+
+// the interfaces and everything they import, each module after the modules
+// it imports, which is the order to initialize them in
+std::vector<Interface> loadInterfaces(const std::vector<std::string> &paths);
+
+} // namespace modules
+
+#endif // MODULE_H
@@ -0,0 +1,63 @@
+#include "options.h"
+#include <stdexcept>
+
+driver::Options driver::parseOptions(const int argc, char *argv[]) {
+  Options options;
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    if (arg == "--time-passes")
+      options.time_passes = TimePasses::Text;
+    else if (arg == "--time-passes=json")
+      options.time_passes = TimePasses::Json;
+    else if (arg == "--profile")
+      options.profile = true;
+    else if (arg.starts_with("--safety=") && arg.size() == 10 &&
+             arg[9] >= '0' && arg[9] <= '3')
+      options.safety = arg[9] - '0';
+    else if (arg == "--no-dce")
+      options.dead_code_elimination = false;
+    else if (arg == "--dce-summary")
+      options.dead_code_summary = true;
+    else if (arg == "--module")
+      options.module = true;
+    else if (arg.starts_with("--import=") && arg.size() > 9)
+      options.imports.push_back(arg.substr(9));
+    else if (arg == "--incremental")
+      options.incremental = true;
+    else if (arg.starts_with("--jobs=") && arg.size() > 7 &&
+             arg.find_first_not_of("0123456789", 7) == std::string::npos &&
+             std::stoul(arg.substr(7)) > 0)
+      options.jobs = std::stoul(arg.substr(7));
+    else if (arg == "--release")
+      options.optimization = Optimization::Release;
+    else if (arg == "--pgo")
+      options.training = "";
+    else if (arg.starts_with("--pgo=") && arg.size() > 6)
+      options.training = arg.substr(6);
+    else if (arg == "--emit-cpp")
+      options.emit_cpp = true;
+    else if (arg == "--keep-cpp")
+      options.keep_cpp = true;
+    else if (arg == "-g" || arg == "--debug")
+      options.debug = true;
+    else if (arg.starts_with("-"))
+      throw std::invalid_argument("Unknown option: " + arg);
+    else if (options.filename.empty())
+      options.filename = arg;
+    else
+      throw std::invalid_argument("Unexpected argument: " + arg);
+  }
+  if (options.filename.empty())
+    throw std::invalid_argument("No input file");
+  // a module is a single object file
+  if (options.module && options.incremental)
+    throw std::invalid_argument("--incremental can not be used with --module");
+  // only an executable can be trained
+  if (options.training && (options.module || options.incremental))
+    throw std::invalid_argument(
+        "--pgo can not be used with --module or --incremental");
+  if (options.emit_cpp && (options.incremental || options.training))
+    throw std::invalid_argument(
+        "--emit-cpp can not be used with --incremental or --pgo");
+  return options;
+}
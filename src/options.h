@@ -0,0 +1,83 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace driver {
+
+enum class TimePasses {
+  None,
+  Text,
+  Json,
+};
+
+enum class Optimization {
+  Default, // -O2
+  Release, // -O3, link time optimization and tuning for this machine
+};
+
+struct Options {
+  std::string filename;
+  TimePasses time_passes = TimePasses::None;
+  bool profile = false;
+  int safety = 1;
+  bool dead_code_elimination = true;
+  bool dead_code_summary = false;
+  bool module = false; // compile to an object file and an interface
+  std::vector<std::string> imports; // interface files of the used modules
+  bool incremental = false; // compile each function on its own, and only
+                            // the ones that changed since the last build
+  unsigned jobs = 0; // files compiled at the same time, 0 for one per core
+  Optimization optimization = Optimization::Default;
+  bool emit_cpp = false; // write the generated C++ and stop before g++
+  bool keep_cpp = false; // keep the generated C++ files after compiling them
+  // compile with debug information, the generated code mapped to the lines
+  // of the lisp source
+  bool debug = false;
+  // with --pgo, the shell command of the training run whose profile guides
+  // the build, empty to run the executable itself
+  std::optional<std::string> training;
+};
+
+// parse the command line, throws std::invalid_argument on bad usage
+Options parseOptions(int argc, char *argv[]);
+
+inline const char *usage = "Usage: lisp-compiler [options] <filename>\n"
+                           "Options:\n"
+                           "  --time-passes       print time and memory used "
+                           "by each phase\n"
+                           "  --time-passes=json  same as --time-passes, in "
+                           "JSON format\n"
+                           "  --profile           make the executable write a "
+                           "profile of its lisp functions\n"
+                           "  --safety=0          omit the dynamic type "
+                           "checks in arithmetic and car/cdr\n"
+                           "  --no-dce            keep unused functions and "
+                           "pure top-level forms\n"
+                           "  --dce-summary       print the forms removed by "
+                           "dead code elimination\n"
+                           "  --module            compile to <name>.o and the "
+                           "interface <name>.lispi\n"
+                           "  --import=<file>     call the functions of the "
+                           "module with this interface\n"
+                           "  --incremental       recompile only the changed "
+                           "functions, cached in <name>.cache\n"
+                           "  --jobs=<n>          split the program in n files "
+                           "compiled in parallel\n"
+                           "  --release           optimize with -O3, link time "
+                           "optimization and -march=native\n"
+                           "  --pgo               optimize with the profile of "
+                           "a run of the executable\n"
+                           "  --pgo=<command>     same as --pgo, with the "
+                           "profile of a run of command\n"
+                           "  --emit-cpp          write the generated C++ to "
+                           "<filename>.cpp without compiling it\n"
+                           "  --keep-cpp          keep the generated C++ files "
+                           "after compiling them\n"
+                           "  -g, --debug         add debug information, "
+                           "mapped to the lines of the lisp source\n";
+
+} // namespace driver
+
+#endif // OPTIONS_H
@@ -1,17 +1,18 @@
 #include "parser.h"
 #include "rule.h"
+#include <algorithm>
 #include <tao/pegtl/contrib/analyze.hpp>
 
 void parser::Parser::preprocess() {
   std::string output;
-  tao::pegtl::memory_input<> input(_source, "source");
+  tao::pegtl::memory_input<> input(_source, _filename);
   assert(tao::pegtl::analyze<helper::rule::Grammar>() == 0);
   tao::pegtl::parse<helper::rule::Grammar, helper::rule::Action>(input, output);
   _source = output;
 }
 
 void parser::Parser::tokenize() {
-  tao::pegtl::memory_input<> input(_source, "source");
+  tao::pegtl::memory_input<> input(_source, _filename);
   assert(tao::pegtl::analyze<lexer::rule::Grammar>() == 0);
   tao::pegtl::parse<lexer::rule::Grammar, lexer::rule::Action>(input, _tokens);
 }
@@ -27,6 +28,15 @@ void parser::Parser::parseTokens() { _ast = parseProgram(); }
 
 void parser::Parser::advance() { _index++; }
 
+// file:line:column of a token before an error message, the file alone at the
+// end of tokens
+std::string parser::Parser::at(const lexer::token::Token &token) const {
+  if (token.getLine() == 0)
+    return _filename + ": ";
+  return _filename + ":" + std::to_string(token.getLine()) + ":" +
+         std::to_string(token.getColumn()) + ": ";
+}
+
 lexer::token::Token parser::Parser::currentToken() {
   if (_index < _tokens.size())
     return _tokens[_index];
@@ -40,12 +50,22 @@ std::shared_ptr<parser::ast::ASTNode> parser::Parser::parseProgram() {
   return program;
 }
 
+// an expression starts where its first token does
 std::shared_ptr<parser::ast::ASTNode> parser::Parser::parseExpression() {
+  const auto token = currentToken();
+  auto expression = parseForm();
+  expression->setPosition(token.getLine(), token.getColumn());
+  return expression;
+}
+
+std::shared_ptr<parser::ast::ASTNode> parser::Parser::parseForm() {
   switch (currentToken().getType()) {
   case lexer::token::TokenType::LParen:
     return parseList();
   case lexer::token::TokenType::Quote:
     return parseQuoted();
+  case lexer::token::TokenType::FunctionQuote:
+    return parseFunctionQuoted();
   case lexer::token::TokenType::Identifier:
     return parseIdentifier();
   case lexer::token::TokenType::Integer:
@@ -65,6 +85,41 @@ std::shared_ptr<parser::ast::ASTNode> parser::Parser::parseExpression() {
   case lexer::token::TokenType::List:
   case lexer::token::TokenType::Progn:
   case lexer::token::TokenType::Print:
+  case lexer::token::TokenType::MakeArray:
+  case lexer::token::TokenType::Aref:
+  case lexer::token::TokenType::Setf:
+  case lexer::token::TokenType::Length:
+  case lexer::token::TokenType::VectorAdd:
+  case lexer::token::TokenType::VectorMul:
+  case lexer::token::TokenType::VectorDot:
+  case lexer::token::TokenType::VectorSum:
+  case lexer::token::TokenType::VectorMin:
+  case lexer::token::TokenType::VectorMax:
+  case lexer::token::TokenType::Mapcar:
+  case lexer::token::TokenType::Reduce:
+  case lexer::token::TokenType::Append:
+  case lexer::token::TokenType::Reverse:
+  case lexer::token::TokenType::Nth:
+  case lexer::token::TokenType::Member:
+  case lexer::token::TokenType::Assoc:
+  case lexer::token::TokenType::Function:
+  case lexer::token::TokenType::Pcall:
+  case lexer::token::TokenType::Pmapcar:
+  case lexer::token::TokenType::DefineMemoFunction:
+  case lexer::token::TokenType::Declare:
+  case lexer::token::TokenType::MakeHashTable:
+  case lexer::token::TokenType::Gethash:
+  case lexer::token::TokenType::Remhash:
+  case lexer::token::TokenType::HashTableCount:
+  case lexer::token::TokenType::Eq:
+  case lexer::token::TokenType::Setq:
+  case lexer::token::TokenType::Dotimes:
+  case lexer::token::TokenType::Dolist:
+  case lexer::token::TokenType::Loop:
+  case lexer::token::TokenType::Lambda:
+  case lexer::token::TokenType::Funcall:
+  case lexer::token::TokenType::Declaim:
+  case lexer::token::TokenType::The:
   case lexer::token::TokenType::Greater:
   case lexer::token::TokenType::GreaterEqual:
   case lexer::token::TokenType::Less:
@@ -77,7 +132,8 @@ std::shared_ptr<parser::ast::ASTNode> parser::Parser::parseExpression() {
   case lexer::token::TokenType::Divide:
     return parseKeyword();
   default:
-    throw std::runtime_error("Unexpected token at parsing expression");
+    throw std::runtime_error(at(currentToken()) +
+                             "Unexpected token at parsing expression");
   }
 }
 
@@ -94,9 +150,16 @@ std::shared_ptr<parser::ast::ASTNode> parser::Parser::parseLiteral() {
   const auto token = currentToken();
   advance();
   switch (token.getType()) {
-  case lexer::token::TokenType::Integer:
+  case lexer::token::TokenType::Integer: {
+    // drop the plus sign and leading zeros
+    auto value = token.getValue().value();
+    const bool negative = value.front() == '-';
+    if (value.front() == '+' || negative)
+      value.erase(0, 1);
+    value.erase(0, std::min(value.find_first_not_of('0'), value.size() - 1));
     return std::make_shared<ast::IntegerNode>(
-        std::stoi(token.getValue().value()));
+        negative && value != "0" ? "-" + value : value);
+  }
   case lexer::token::TokenType::Floating:
     return std::make_shared<ast::FloatingNode>(
         std::stod(token.getValue().value()));
@@ -104,7 +167,7 @@ std::shared_ptr<parser::ast::ASTNode> parser::Parser::parseLiteral() {
   case lexer::token::TokenType::String:
     return std::make_shared<ast::StringNode>(token.getValue().value());
   default:
-    throw std::runtime_error("Unexpected token at parsing literal");
+    throw std::runtime_error(at(token) + "Unexpected token at parsing literal");
   }
 }
 
@@ -113,6 +176,18 @@ std::shared_ptr<parser::ast::ASTNode> parser::Parser::parseQuoted() {
   return std::make_shared<ast::QuotedNode>(parseExpression());
 }
 
+// #'name is read as (function name)
+std::shared_ptr<parser::ast::ASTNode> parser::Parser::parseFunctionQuoted() {
+  const auto token = currentToken();
+  advance();
+  auto list = std::make_shared<ast::ListNode>();
+  auto function = std::make_shared<ast::KeywordNode>("function");
+  function->setPosition(token.getLine(), token.getColumn());
+  list->addExpression(function);
+  list->addExpression(parseExpression());
+  return list;
+}
+
 std::shared_ptr<parser::ast::ASTNode> parser::Parser::parseIdentifier() {
   const auto token = currentToken();
   advance();
@@ -150,6 +225,76 @@ std::shared_ptr<parser::ast::ASTNode> parser::Parser::parseKeyword() {
     return std::make_shared<ast::KeywordNode>("progn");
   case lexer::token::TokenType::Print:
     return std::make_shared<ast::KeywordNode>("print");
+  case lexer::token::TokenType::MakeArray:
+    return std::make_shared<ast::KeywordNode>("make-array");
+  case lexer::token::TokenType::Aref:
+    return std::make_shared<ast::KeywordNode>("aref");
+  case lexer::token::TokenType::Setf:
+    return std::make_shared<ast::KeywordNode>("setf");
+  case lexer::token::TokenType::Length:
+    return std::make_shared<ast::KeywordNode>("length");
+  case lexer::token::TokenType::VectorAdd:
+    return std::make_shared<ast::KeywordNode>("vector-add");
+  case lexer::token::TokenType::VectorMul:
+    return std::make_shared<ast::KeywordNode>("vector-mul");
+  case lexer::token::TokenType::VectorDot:
+    return std::make_shared<ast::KeywordNode>("vector-dot");
+  case lexer::token::TokenType::VectorSum:
+    return std::make_shared<ast::KeywordNode>("vector-sum");
+  case lexer::token::TokenType::VectorMin:
+    return std::make_shared<ast::KeywordNode>("vector-min");
+  case lexer::token::TokenType::VectorMax:
+    return std::make_shared<ast::KeywordNode>("vector-max");
+  case lexer::token::TokenType::Mapcar:
+    return std::make_shared<ast::KeywordNode>("mapcar");
+  case lexer::token::TokenType::Reduce:
+    return std::make_shared<ast::KeywordNode>("reduce");
+  case lexer::token::TokenType::Append:
+    return std::make_shared<ast::KeywordNode>("append");
+  case lexer::token::TokenType::Reverse:
+    return std::make_shared<ast::KeywordNode>("reverse");
+  case lexer::token::TokenType::Nth:
+    return std::make_shared<ast::KeywordNode>("nth");
+  case lexer::token::TokenType::Member:
+    return std::make_shared<ast::KeywordNode>("member");
+  case lexer::token::TokenType::Assoc:
+    return std::make_shared<ast::KeywordNode>("assoc");
+  case lexer::token::TokenType::Function:
+    return std::make_shared<ast::KeywordNode>("function");
+  case lexer::token::TokenType::Pcall:
+    return std::make_shared<ast::KeywordNode>("pcall");
+  case lexer::token::TokenType::Pmapcar:
+    return std::make_shared<ast::KeywordNode>("pmapcar");
+  case lexer::token::TokenType::DefineMemoFunction:
+    return std::make_shared<ast::KeywordNode>("defun-memo");
+  case lexer::token::TokenType::Declare:
+    return std::make_shared<ast::KeywordNode>("declare");
+  case lexer::token::TokenType::MakeHashTable:
+    return std::make_shared<ast::KeywordNode>("make-hash-table");
+  case lexer::token::TokenType::Gethash:
+    return std::make_shared<ast::KeywordNode>("gethash");
+  case lexer::token::TokenType::Remhash:
+    return std::make_shared<ast::KeywordNode>("remhash");
+  case lexer::token::TokenType::HashTableCount:
+    return std::make_shared<ast::KeywordNode>("hash-table-count");
+  case lexer::token::TokenType::Eq:
+    return std::make_shared<ast::KeywordNode>("eq");
+  case lexer::token::TokenType::Setq:
+    return std::make_shared<ast::KeywordNode>("setq");
+  case lexer::token::TokenType::Dotimes:
+    return std::make_shared<ast::KeywordNode>("dotimes");
+  case lexer::token::TokenType::Dolist:
+    return std::make_shared<ast::KeywordNode>("dolist");
+  case lexer::token::TokenType::Loop:
+    return std::make_shared<ast::KeywordNode>("loop");
+  case lexer::token::TokenType::Lambda:
+    return std::make_shared<ast::KeywordNode>("lambda");
+  case lexer::token::TokenType::Funcall:
+    return std::make_shared<ast::KeywordNode>("funcall");
+  case lexer::token::TokenType::Declaim:
+    return std::make_shared<ast::KeywordNode>("declaim");
+  case lexer::token::TokenType::The:
+    return std::make_shared<ast::KeywordNode>("the");
   case lexer::token::TokenType::Greater:
     return std::make_shared<ast::KeywordNode>(">");
   case lexer::token::TokenType::GreaterEqual:
@@ -171,6 +316,6 @@ std::shared_ptr<parser::ast::ASTNode> parser::Parser::parseKeyword() {
   case lexer::token::TokenType::Divide:
     return std::make_shared<ast::KeywordNode>("/");
   default:
-    throw std::runtime_error("Unexpected token at parsing keyword");
+    throw std::runtime_error(at(token) + "Unexpected token at parsing keyword");
   }
 }
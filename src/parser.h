@@ -10,27 +10,39 @@ namespace parser {
 
 class Parser {
 public:
-  explicit Parser(std::string source)
-      : _source(std::move(source)), _ast(nullptr) {}
+  // the file name starts the errors
+  explicit Parser(std::string source, std::string filename = "source")
+      : _source(std::move(source)), _filename(std::move(filename)),
+        _ast(nullptr) {}
   std::shared_ptr<ast::ASTNode> parse();
 
-private:
+  // the phases run by parse(), in order
   void preprocess();
   void tokenize();
   void parseTokens();
+  [[nodiscard]] const std::shared_ptr<ast::ASTNode> &getAST() const {
+    return _ast;
+  }
+  [[nodiscard]] std::size_t getTokenCount() const { return _tokens.size(); }
+
+private:
   std::string _source;
+  std::string _filename;
   std::vector<lexer::token::Token> _tokens;
   std::shared_ptr<ast::ASTNode> _ast;
   size_t _index = 0;
 
   // Parser functions
   void advance();
+  [[nodiscard]] std::string at(const lexer::token::Token &token) const;
   lexer::token::Token currentToken();
   std::shared_ptr<ast::ASTNode> parseProgram();
   std::shared_ptr<ast::ASTNode> parseList();
   std::shared_ptr<ast::ASTNode> parseLiteral();
   std::shared_ptr<ast::ASTNode> parseExpression();
+  std::shared_ptr<ast::ASTNode> parseForm();
   std::shared_ptr<ast::ASTNode> parseQuoted();
+  std::shared_ptr<ast::ASTNode> parseFunctionQuoted();
   std::shared_ptr<ast::ASTNode> parseIdentifier();
   std::shared_ptr<ast::ASTNode> parseKeyword();
 };
@@ -0,0 +1,78 @@
+#include "report.h"
+#include <iomanip>
+#include <sys/resource.h>
+
+namespace {
+
+// user + system time of all terminated child processes in milliseconds
+double childTime() {
+  rusage usage{};
+  getrusage(RUSAGE_CHILDREN, &usage);
+  return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1e3 +
+         (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e3;
+}
+
+// peak resident set size in kilobytes
+long peakRss(const int who) {
+  rusage usage{};
+  getrusage(who, &usage);
+  return usage.ru_maxrss;
+}
+
+} // namespace
+
+report::Report::Timer::Timer(Report &report, std::string name)
+    : _report(report), _name(std::move(name)),
+      _start(std::chrono::steady_clock::now()), _child(childTime()) {}
+
+report::Report::Timer::~Timer() {
+  const std::chrono::duration<double, std::milli> wall =
+      std::chrono::steady_clock::now() - _start;
+  _report._phases.push_back({_name, wall.count(), childTime() - _child});
+}
+
+void report::Report::count(const std::string &name, const std::size_t value) {
+  _counters.emplace_back(name, value);
+}
+
+void report::Report::print(std::ostream &out) const {
+  double wall = 0, child = 0;
+  out << std::fixed << std::setprecision(3);
+  out << std::left << std::setw(16) << "phase" << std::right << std::setw(14)
+      << "wall (ms)" << std::setw(14) << "child (ms)" << '\n';
+  for (const auto &[name, phase_wall, phase_child] : _phases) {
+    out << std::left << std::setw(16) << name << std::right << std::setw(14)
+        << phase_wall << std::setw(14) << phase_child << '\n';
+    wall += phase_wall, child += phase_child;
+  }
+  out << std::left << std::setw(16) << "total" << std::right << std::setw(14)
+      << wall << std::setw(14) << child << '\n';
+  out << '\n';
+  for (const auto &[name, value] : _counters)
+    out << std::left << std::setw(16) << name << std::right << std::setw(14)
+        << value << '\n';
+  out << std::left << std::setw(16) << "peak rss (kb)" << std::right
+      << std::setw(14) << peakRss(RUSAGE_SELF) << '\n';
+  out << std::left << std::setw(16) << "child rss (kb)" << std::right
+      << std::setw(14) << peakRss(RUSAGE_CHILDREN) << '\n';
+}
+
+void report::Report::printJson(std::ostream &out) const {
+  out << std::fixed << std::setprecision(3);
+  out << "{\"phases\":[";
+  for (std::size_t i = 0; i < _phases.size(); i++) {
+    if (i)
+      out << ',';
+    out << "{\"name\":\"" << _phases[i].name
+        << "\",\"wall_ms\":" << _phases[i].wall
+        << ",\"child_ms\":" << _phases[i].child << '}';
+  }
+  out << "],\"counters\":{";
+  for (std::size_t i = 0; i < _counters.size(); i++) {
+    if (i)
+      out << ',';
+    out << '"' << _counters[i].first << "\":" << _counters[i].second;
+  }
+  out << "},\"peak_rss_kb\":" << peakRss(RUSAGE_SELF)
+      << ",\"child_peak_rss_kb\":" << peakRss(RUSAGE_CHILDREN) << "}\n";
+}
@@ -0,0 +1,49 @@
+#ifndef REPORT_H
+#define REPORT_H
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace report {
+
+struct Phase {
+  std::string name;
+  double wall;  // wall time in milliseconds
+  double child; // user + system time of child processes in milliseconds
+};
+
+// collects per-phase timings and counters of one compiler invocation
+class Report {
+public:
+  // run f as the phase called name and record how long it took
+  template <typename F> decltype(auto) time(const std::string &name, F &&f) {
+    Timer timer(*this, name);
+    return f();
+  }
+  void count(const std::string &name, std::size_t value);
+  void print(std::ostream &out) const;
+  void printJson(std::ostream &out) const;
+
+private:
+  class Timer {
+  public:
+    Timer(Report &report, std::string name);
+    ~Timer();
+
+  private:
+    Report &_report;
+    std::string _name;
+    std::chrono::steady_clock::time_point _start;
+    double _child;
+  };
+
+  std::vector<Phase> _phases;
+  std::vector<std::pair<std::string, std::size_t>> _counters;
+};
+
+} // namespace report
+
+#endif // REPORT_H
@@ -27,17 +27,19 @@ struct Divide : pegtl::one<'/'> {};
 struct LParen : pegtl::one<'('> {};
 struct RParen : pegtl::one<')'> {};
 struct Quote : pegtl::one<'\''> {};
-struct Symbol : pegtl::sor<GreaterEqual, LessEqual, NotEqual, Greater, Less, Equal, Plus, Minus, Times, Divide, LParen, RParen, Quote> {};
+struct FunctionQuote : pegtl::string<'#', '\''> {};
+struct Nil : pegtl::string<'(', ')'> {}; // () is read as nil
+struct Symbol : pegtl::sor<GreaterEqual, LessEqual, NotEqual, Greater, Less, Equal, Plus, Minus, Times, Divide, LParen, RParen, Quote, FunctionQuote> {};
 
 // atoms
 struct Integer : pegtl::seq<pegtl::opt<pegtl::one<'+', '-'>>, pegtl::plus<pegtl::digit>> {};
 struct Floating : pegtl::seq<pegtl::opt<pegtl::one<'+', '-'>>, pegtl::plus<pegtl::digit>, pegtl::one<'.'>, pegtl::plus<pegtl::digit>> {};
 struct String : pegtl::seq<pegtl::one<'"'>, pegtl::star<pegtl::sor<pegtl::seq<pegtl::one<'\\'>, pegtl::any>, pegtl::not_one<'"', '\\'>>>, pegtl::one<'"'>> {};
-struct Identifier : pegtl::plus<pegtl::sor<pegtl::alnum>> {};
+struct Identifier : pegtl::seq<pegtl::opt<pegtl::one<':'>>, pegtl::alnum, pegtl::star<pegtl::sor<pegtl::alnum, pegtl::one<'-'>>>> {};
 
 // rules
 struct Unknown : pegtl::any {};
-struct Token : pegtl::sor<Space, Symbol, String, Floating, Integer, Identifier, Unknown> {};
+struct Token : pegtl::sor<Space, Floating, Integer, Nil, Symbol, String, Identifier, Unknown> {};
 struct Grammar : pegtl::seq<pegtl::star<Token>, pegtl::eof> {};
 
 // clang-format on
@@ -57,123 +59,181 @@ std::unordered_map<std::string, token::TokenType> keywords = {
     {"cons", token::TokenType::Cons},
     {"list", token::TokenType::List},
     {"progn", token::TokenType::Progn},
-    {"print", token::TokenType::Print}};
+    {"print", token::TokenType::Print},
+    {"make-array", token::TokenType::MakeArray},
+    {"aref", token::TokenType::Aref},
+    {"setf", token::TokenType::Setf},
+    {"length", token::TokenType::Length},
+    {"vector-add", token::TokenType::VectorAdd},
+    {"vector-mul", token::TokenType::VectorMul},
+    {"vector-dot", token::TokenType::VectorDot},
+    {"vector-sum", token::TokenType::VectorSum},
+    {"vector-min", token::TokenType::VectorMin},
+    {"vector-max", token::TokenType::VectorMax},
+    {"mapcar", token::TokenType::Mapcar},
+    {"reduce", token::TokenType::Reduce},
+    {"append", token::TokenType::Append},
+    {"reverse", token::TokenType::Reverse},
+    {"nth", token::TokenType::Nth},
+    {"member", token::TokenType::Member},
+    {"assoc", token::TokenType::Assoc},
+    {"function", token::TokenType::Function},
+    {"pcall", token::TokenType::Pcall},
+    {"pmapcar", token::TokenType::Pmapcar},
+    {"defun-memo", token::TokenType::DefineMemoFunction},
+    {"declare", token::TokenType::Declare},
+    {"make-hash-table", token::TokenType::MakeHashTable},
+    {"gethash", token::TokenType::Gethash},
+    {"remhash", token::TokenType::Remhash},
+    {"hash-table-count", token::TokenType::HashTableCount},
+    {"eq", token::TokenType::Eq},
+    {"setq", token::TokenType::Setq},
+    {"dotimes", token::TokenType::Dotimes},
+    {"dolist", token::TokenType::Dolist},
+    {"loop", token::TokenType::Loop},
+    {"lambda", token::TokenType::Lambda},
+    {"funcall", token::TokenType::Funcall},
+    {"declaim", token::TokenType::Declaim},
+    {"the", token::TokenType::The}};
+
+// push a token starting where the matched input does
+template <typename Input>
+void emit(const Input &in, std::vector<token::Token> &out,
+          const token::TokenType type,
+          const std::optional<std::string> &value = std::nullopt) {
+  const auto position = in.position();
+  out.emplace_back(type, value, position.line, position.column);
+}
 
 template <typename Rule> struct Action {};
 
+template <> struct Action<Nil> {
+  template <typename Input>
+  static void apply(const Input &in, std::vector<token::Token> &out) {
+    emit(in, out, token::TokenType::Nil, "nil");
+  }
+};
+
 template <> struct Action<Identifier> {
   template <typename Input>
 
   static void apply(const Input &in, std::vector<token::Token> &out) {
     if (keywords.contains(in.string()))
-      out.emplace_back(keywords.at(in.string()), in.string());
+      emit(in, out, keywords.at(in.string()), in.string());
     else
-      out.emplace_back(token::TokenType::Identifier, in.string());
+      emit(in, out, token::TokenType::Identifier, in.string());
   }
 };
 
 template <> struct Action<GreaterEqual> {
   template <typename Input>
   static void apply(const Input &in, std::vector<token::Token> &out) {
-    out.emplace_back(token::TokenType::GreaterEqual);
+    emit(in, out, token::TokenType::GreaterEqual);
   }
 };
 
 template <> struct Action<LessEqual> {
   template <typename Input>
   static void apply(const Input &in, std::vector<token::Token> &out) {
-    out.emplace_back(token::TokenType::LessEqual);
+    emit(in, out, token::TokenType::LessEqual);
   }
 };
 
 template <> struct Action<NotEqual> {
   template <typename Input>
   static void apply(const Input &in, std::vector<token::Token> &out) {
-    out.emplace_back(token::TokenType::NotEqual);
+    emit(in, out, token::TokenType::NotEqual);
   }
 };
 
 template <> struct Action<Greater> {
   template <typename Input>
   static void apply(const Input &in, std::vector<token::Token> &out) {
-    out.emplace_back(token::TokenType::Greater);
+    emit(in, out, token::TokenType::Greater);
   }
 };
 
 template <> struct Action<Less> {
   template <typename Input>
   static void apply(const Input &in, std::vector<token::Token> &out) {
-    out.emplace_back(token::TokenType::Less);
+    emit(in, out, token::TokenType::Less);
   }
 };
 
 template <> struct Action<Equal> {
   template <typename Input>
   static void apply(const Input &in, std::vector<token::Token> &out) {
-    out.emplace_back(token::TokenType::Equal);
+    emit(in, out, token::TokenType::Equal);
   }
 };
 
 template <> struct Action<Plus> {
   template <typename Input>
   static void apply(const Input &in, std::vector<token::Token> &out) {
-    out.emplace_back(token::TokenType::Plus);
+    emit(in, out, token::TokenType::Plus);
   }
 };
 
 template <> struct Action<Minus> {
   template <typename Input>
   static void apply(const Input &in, std::vector<token::Token> &out) {
-    out.emplace_back(token::TokenType::Minus);
+    emit(in, out, token::TokenType::Minus);
   }
 };
 
 template <> struct Action<Times> {
   template <typename Input>
   static void apply(const Input &in, std::vector<token::Token> &out) {
-    out.emplace_back(token::TokenType::Times);
+    emit(in, out, token::TokenType::Times);
   }
 };
 
 template <> struct Action<Divide> {
   template <typename Input>
   static void apply(const Input &in, std::vector<token::Token> &out) {
-    out.emplace_back(token::TokenType::Divide);
+    emit(in, out, token::TokenType::Divide);
   }
 };
 
 template <> struct Action<LParen> {
   template <typename Input>
   static void apply(const Input &in, std::vector<token::Token> &out) {
-    out.emplace_back(token::TokenType::LParen);
+    emit(in, out, token::TokenType::LParen);
   }
 };
 
 template <> struct Action<RParen> {
   template <typename Input>
   static void apply(const Input &in, std::vector<token::Token> &out) {
-    out.emplace_back(token::TokenType::RParen);
+    emit(in, out, token::TokenType::RParen);
   }
 };
 
 template <> struct Action<Quote> {
   template <typename Input>
   static void apply(const Input &in, std::vector<token::Token> &out) {
-    out.emplace_back(token::TokenType::Quote);
+    emit(in, out, token::TokenType::Quote);
+  }
+};
+
+template <> struct Action<FunctionQuote> {
+  template <typename Input>
+  static void apply(const Input &in, std::vector<token::Token> &out) {
+    emit(in, out, token::TokenType::FunctionQuote);
   }
 };
 
 template <> struct Action<Integer> {
   template <typename Input>
   static void apply(const Input &in, std::vector<token::Token> &out) {
-    out.emplace_back(token::TokenType::Integer, in.string());
+    emit(in, out, token::TokenType::Integer, in.string());
   }
 };
 
 template <> struct Action<Floating> {
   template <typename Input>
   static void apply(const Input &in, std::vector<token::Token> &out) {
-    out.emplace_back(token::TokenType::Floating, in.string());
+    emit(in, out, token::TokenType::Floating, in.string());
   }
 };
 
@@ -188,14 +248,18 @@ template <> struct Action<String> {
       else
         value += c, escape = false;
     }
-    out.emplace_back(token::TokenType::String, value);
+    emit(in, out, token::TokenType::String, value);
   }
 };
 
 template <> struct Action<Unknown> {
   template <typename Input>
   static void apply(const Input &in, std::vector<token::Token> &out) {
-    throw std::runtime_error("Could not lex: " + in.string());
+    const auto position = in.position();
+    throw std::runtime_error(position.source + ":" +
+                             std::to_string(position.line) + ":" +
+                             std::to_string(position.column) +
+                             ": Could not lex: " + in.string());
   }
 };
 
@@ -212,12 +276,9 @@ struct SingleLineComment : pegtl::seq<pegtl::string<';'>, pegtl::until<pegtl::eo
 struct MultiLineComment : pegtl::seq<pegtl::string<'#', '|'>, pegtl::until<pegtl::string<'|', '#'>>> {};
 struct Comment : pegtl::sor<SingleLineComment, MultiLineComment> {};
 
-// () -> nil
-struct Nil : pegtl::string<'(', ')'> {};
-
 // rules
 struct Unknown : pegtl::any {};
-struct Grammar : pegtl::seq<pegtl::star<pegtl::sor<Comment, Nil, Unknown>>, pegtl::eof> {};
+struct Grammar : pegtl::seq<pegtl::star<pegtl::sor<Comment, Unknown>>, pegtl::eof> {};
 
 // clang-format on
 
@@ -231,10 +292,13 @@ template <> struct Action<Unknown> {
   }
 };
 
-template <> struct Action<Nil> {
+// a comment is blanked out, so that the tokens after it keep their line and
+// column
+template <> struct Action<Comment> {
   template <typename Input>
   static void apply(const Input &in, std::string &out) {
-    out += "nil";
+    for (const auto c : in.string())
+      out += c == '\n' ? '\n' : ' ';
   }
 };
 
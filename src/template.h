@@ -6,417 +6,2044 @@
 namespace generator {
 
 inline std::string code_template =
-    "#include <iostream>\n#include <memory>\n#include <stdexcept>\n#include "
-    "<string>\n#include <utility>\n#include <vector>\n\n// lisp value "
-    "types\n#pragma region ValueTypes\n\nenum class Type {\n    Symbol,\n    "
-    "Int,\n    Float,\n    String,\n    List,\n    Quoted,\n    T,\n    "
-    "Nil,\n};\n\nstruct Value {\n    virtual ~Value() = default;\n    explicit "
-    "Value(Type type) : _type(type) {}\n    [[nodiscard]] virtual std::string "
-    "get() const = 0;\n    Type _type;\n};\n\nstruct Symbol final : Value {\n  "
-    "  explicit Symbol(std::string value)\n        : Value(Type::Symbol), "
-    "_value(std::move(value)) {}\n    std::string _value;\n    [[nodiscard]] "
-    "std::string get() const override {\n        std::string result;\n        "
-    "for (const auto &c : _value)\n            if (islower(c))\n               "
-    " result += toupper(c);\n            else\n                result += c;\n  "
-    "      return result;\n    }\n};\n\nstruct Int final : Value {\n    "
-    "explicit Int(int value) : Value(Type::Int), _value(value) {}\n    int "
-    "_value;\n    [[nodiscard]] std::string get() const override {\n        "
-    "return std::to_string(_value);\n    }\n};\n\nstruct Float final : Value "
-    "{\n    explicit Float(double value) : Value(Type::Float), _value(value) "
-    "{}\n    double _value;\n    [[nodiscard]] std::string get() const "
-    "override {\n        return std::to_string(_value);\n    }\n};\n\nstruct "
-    "String final : Value {\n    explicit String(std::string value)\n        : "
-    "Value(Type::String), _value(std::move(value)) {}\n    std::string "
-    "_value;\n    [[nodiscard]] std::string get() const override { return '\"' "
-    "+ _value + '\"'; }\n};\n\nstruct List final : Value {\n    explicit "
+    "#include <algorithm>\n#include <array>\n#include <charconv>\n#include "
+    "<cstdint>\n#include <cstdio>\n#include <cstring>\n#include "
+    "<iostream>\n#include <memory>\n#include <mutex>\n#include "
+    "<stdexcept>\n#include <string>\n#include <unordered_map>\n#include "
+    "<utility>\n#include <vector>\n\n// lisp output\n#pragma region "
+    "Output\n\n// Printer : buffered sink for print, flushed when full and on "
+    "exit\nstruct Printer {\n    ~Printer() { flush(); }\n    void write(const "
+    "char *data, std::size_t size) {\n        if (_size + size > "
+    "sizeof(_buffer)) {\n            flush();\n            if (size > "
+    "sizeof(_buffer)) {\n                fwrite(data, 1, size, stdout);\n      "
+    "          return;\n            }\n        }\n        std::memcpy(_buffer "
+    "+ _size, data, size);\n        _size += size;\n    }\n    void "
+    "write(const std::string &value) { write(value.data(), value.size()); }\n  "
+    "  void put(char c) {\n        if (_size == sizeof(_buffer))\n            "
+    "flush();\n        _buffer[_size++] = c;\n    }\n    void write(long long "
+    "value) {\n        char buffer[24];\n        const auto result = "
+    "std::to_chars(buffer, buffer + sizeof(buffer), value);\n        "
+    "write(buffer, result.ptr - buffer);\n    }\n    // same format as "
+    "std::to_string(double)\n    void write(double value) {\n        char "
+    "buffer[512];\n        const auto result = std::to_chars(buffer, buffer + "
+    "sizeof(buffer), value,\n                                          "
+    "std::chars_format::fixed, 6);\n        write(buffer, result.ptr - "
+    "buffer);\n    }\n    void flush() {\n        if (_size)\n            "
+    "fwrite(_buffer, 1, _size, stdout);\n        _size = 0;\n        "
+    "fflush(stdout);\n    }\n\n    char _buffer[1 << 16]{};\n    std::size_t "
+    "_size = 0; // not locked, print never runs in parallel\n};\n\ninline "
+    "Printer output;\n\n#pragma endregion Output\n\n// lisp arbitrary "
+    "precision integers\n#pragma region Bignum\n\n#include "
+    "<algorithm>\n#include <climits>\n#include <cstdint>\n\n// BigInt : sign "
+    "and magnitude integer, used when a fixnum overflows\nstruct BigInt {\n    "
+    "using Limb = std::uint64_t;\n    using Wide = unsigned __int128;\n    "
+    "using Limbs = std::vector<Limb>; // little endian, no leading zero "
+    "limbs\n\n    // operands with fewer limbs are multiplied with the "
+    "schoolbook method\n    static constexpr std::size_t karatsuba_threshold = "
+    "32;\n    // largest power of ten that fits in a limb\n    static "
+    "constexpr Limb decimal_base = 10000000000000000000ULL;\n    static "
+    "constexpr int decimal_digits = 19;\n\n    BigInt() = default;\n    "
+    "explicit BigInt(long long value) : _negative(value < 0) {\n        // "
+    "negate in unsigned arithmetic so that LLONG_MIN does not overflow\n       "
+    " const Limb magnitude =\n            value < 0 ? "
+    "~static_cast<Limb>(value) + 1 : static_cast<Limb>(value);\n        if "
+    "(magnitude)\n            _limbs.push_back(magnitude);\n    }\n    "
+    "BigInt(bool negative, Limbs limbs)\n        : _negative(negative), "
+    "_limbs(std::move(limbs)) {\n        trim(_limbs);\n        if "
+    "(_limbs.empty())\n            _negative = false;\n    }\n\n    // parse : "
+    "parse an optionally signed decimal integer\n    [[nodiscard]] static "
+    "BigInt parse(const std::string &text) {\n        std::size_t i = 0;\n     "
+    "   bool negative = false;\n        if (i < text.size() && (text[i] == '+' "
+    "|| text[i] == '-'))\n            negative = text[i++] == '-';\n        "
+    "Limbs limbs;\n        while (i < text.size()) {\n            const "
+    "std::size_t count =\n                "
+    "std::min<std::size_t>(decimal_digits, text.size() - i);\n            Limb "
+    "chunk = 0, scale = 1;\n            for (std::size_t j = 0; j < count; "
+    "j++, i++) {\n                chunk = chunk * 10 + (text[i] - '0');\n      "
+    "          scale *= 10;\n            }\n            mul_small(limbs, "
+    "scale, chunk);\n        }\n        return {negative, std::move(limbs)};\n "
+    "   }\n\n    [[nodiscard]] bool is_zero() const { return _limbs.empty(); "
+    "}\n\n    [[nodiscard]] bool fits_fixnum() const {\n        if "
+    "(_limbs.size() > 1)\n            return false;\n        if "
+    "(_limbs.empty())\n            return true;\n        return _limbs[0] <= "
+    "(_negative ? Limb(1) << 63 : (Limb(1) << 63) - 1);\n    }\n\n    "
+    "[[nodiscard]] long long to_fixnum() const {\n        if "
+    "(_limbs.empty())\n            return 0;\n        return static_cast<long "
+    "long>(_negative ? ~_limbs[0] + 1 : _limbs[0]);\n    }\n\n    "
+    "[[nodiscard]] double to_double() const {\n        double result = 0;\n    "
+    "    for (auto i = _limbs.size(); i-- > 0;)\n            result = result * "
+    "18446744073709551616.0 + static_cast<double>(_limbs[i]);\n        return "
+    "_negative ? -result : result;\n    }\n\n    // write : print in decimal, "
+    "converting 19 digits per pass\n    void write(Printer &out) const {\n     "
+    "   if (_limbs.empty()) {\n            out.put('0');\n            "
+    "return;\n        }\n        std::vector<Limb> chunks;\n        Limbs rest "
+    "= _limbs;\n        while (!rest.empty())\n            "
+    "chunks.push_back(div_small(rest, decimal_base));\n        if "
+    "(_negative)\n            out.put('-');\n        char top[decimal_digits + "
+    "1];\n        const auto result = std::to_chars(top, top + sizeof(top), "
+    "chunks.back());\n        out.write(top, result.ptr - top);\n        for "
+    "(auto i = chunks.size() - 1; i-- > 0;) {\n            char "
+    "buffer[decimal_digits];\n            Limb chunk = chunks[i];\n            "
+    "for (int j = decimal_digits; j-- > 0; chunk /= 10)\n                "
+    "buffer[j] = static_cast<char>('0' + chunk % 10);\n            "
+    "out.write(buffer, decimal_digits);\n        }\n    }\n\n    [[nodiscard]] "
+    "static int compare(const BigInt &a, const BigInt &b) {\n        if "
+    "(a._negative != b._negative)\n            return a._negative ? -1 : 1;\n  "
+    "      const int result = compare(a._limbs, b._limbs);\n        return "
+    "a._negative ? -result : result;\n    }\n\n    friend BigInt "
+    "operator-(BigInt a) {\n        if (!a._limbs.empty())\n            "
+    "a._negative = !a._negative;\n        return a;\n    }\n\n    friend "
+    "BigInt operator+(const BigInt &a, const BigInt &b) {\n        if "
+    "(a._negative == b._negative)\n            return {a._negative, "
+    "add(a._limbs, b._limbs)};\n        if (compare(a._limbs, b._limbs) >= "
+    "0)\n            return {a._negative, sub(a._limbs, b._limbs)};\n        "
+    "return {b._negative, sub(b._limbs, a._limbs)};\n    }\n\n    friend "
+    "BigInt operator-(const BigInt &a, const BigInt &b) { return a + -b; }\n\n "
+    "   friend BigInt operator*(const BigInt &a, const BigInt &b) {\n        "
+    "return {a._negative != b._negative, mul(a._limbs, b._limbs)};\n    }\n\n  "
+    "  // divmod : truncating division, the remainder has the sign of a\n    "
+    "static void divmod(const BigInt &a, const BigInt &b, BigInt &quotient,\n  "
+    "                     BigInt &remainder) {\n        if (b.is_zero())\n     "
+    "       throw std::runtime_error(\"Division by zero\");\n        Limbs q, "
+    "r;\n        divmod(a._limbs, b._limbs, q, r);\n        quotient = "
+    "BigInt(a._negative != b._negative, std::move(q));\n        remainder = "
+    "BigInt(a._negative, std::move(r));\n    }\n\n    bool _negative = "
+    "false;\n    Limbs _limbs;\n\n  private:\n    static void trim(Limbs &v) "
+    "{\n        while (!v.empty() && v.back() == 0)\n            "
+    "v.pop_back();\n    }\n\n    [[nodiscard]] static int compare(const Limbs "
+    "&a, const Limbs &b) {\n        if (a.size() != b.size())\n            "
+    "return a.size() < b.size() ? -1 : 1;\n        for (auto i = a.size(); i-- "
+    "> 0;)\n            if (a[i] != b[i])\n                return a[i] < b[i] "
+    "? -1 : 1;\n        return 0;\n    }\n\n    [[nodiscard]] static Limbs "
+    "add(const Limbs &a, const Limbs &b) {\n        const Limbs &longer = "
+    "a.size() >= b.size() ? a : b;\n        const Limbs &shorter = a.size() >= "
+    "b.size() ? b : a;\n        Limbs result(longer.size() + 1);\n        Limb "
+    "carry = 0;\n        for (std::size_t i = 0; i < longer.size(); i++) {\n   "
+    "         const Wide sum = Wide(longer[i]) + (i < shorter.size() ? "
+    "shorter[i] : 0) + carry;\n            result[i] = "
+    "static_cast<Limb>(sum);\n            carry = static_cast<Limb>(sum >> "
+    "64);\n        }\n        result[longer.size()] = carry;\n        "
+    "trim(result);\n        return result;\n    }\n\n    // sub : a - b, "
+    "requires a >= b\n    [[nodiscard]] static Limbs sub(const Limbs &a, const "
+    "Limbs &b) {\n        Limbs result(a.size());\n        Limb borrow = 0;\n  "
+    "      for (std::size_t i = 0; i < a.size(); i++) {\n            const "
+    "Limb y = i < b.size() ? b[i] : 0;\n            const Limb d = a[i] - y - "
+    "borrow;\n            borrow = (a[i] < y || (a[i] == y && borrow)) ? 1 : "
+    "0;\n            result[i] = d;\n        }\n        trim(result);\n        "
+    "return result;\n    }\n\n    // add_to : a += b << (64 * shift)\n    "
+    "static void add_to(Limbs &a, const Limbs &b, std::size_t shift) {\n       "
+    " if (a.size() < b.size() + shift + 1)\n            a.resize(b.size() + "
+    "shift + 1);\n        Limb carry = 0;\n        std::size_t i = 0;\n        "
+    "for (; i < b.size(); i++) {\n            const Wide sum = Wide(a[i + "
+    "shift]) + b[i] + carry;\n            a[i + shift] = "
+    "static_cast<Limb>(sum);\n            carry = static_cast<Limb>(sum >> "
+    "64);\n        }\n        for (; carry; i++) {\n            if (i + shift "
+    "== a.size())\n                a.push_back(0);\n            const Wide sum "
+    "= Wide(a[i + shift]) + carry;\n            a[i + shift] = "
+    "static_cast<Limb>(sum);\n            carry = static_cast<Limb>(sum >> "
+    "64);\n        }\n    }\n\n    // mul_small : v = v * factor + addend\n    "
+    "static void mul_small(Limbs &v, Limb factor, Limb addend) {\n        Limb "
+    "carry = addend;\n        for (auto &limb : v) {\n            const Wide "
+    "product = Wide(limb) * factor + carry;\n            limb = "
+    "static_cast<Limb>(product);\n            carry = "
+    "static_cast<Limb>(product >> 64);\n        }\n        if (carry)\n        "
+    "    v.push_back(carry);\n    }\n\n    // div_small : v = v / divisor, "
+    "returns the remainder\n    static Limb div_small(Limbs &v, Limb divisor) "
+    "{\n        Wide remainder = 0;\n        for (auto i = v.size(); i-- > 0;) "
+    "{\n            const Wide current = (remainder << 64) | v[i];\n           "
+    " v[i] = static_cast<Limb>(current / divisor);\n            remainder = "
+    "current % divisor;\n        }\n        trim(v);\n        return "
+    "static_cast<Limb>(remainder);\n    }\n\n    [[nodiscard]] static Limbs "
+    "schoolbook(const Limbs &a, const Limbs &b) {\n        Limbs "
+    "result(a.size() + b.size());\n        for (std::size_t i = 0; i < "
+    "a.size(); i++) {\n            Limb carry = 0;\n            for "
+    "(std::size_t j = 0; j < b.size(); j++) {\n                const Wide "
+    "product = Wide(a[i]) * b[j] + result[i + j] + carry;\n                "
+    "result[i + j] = static_cast<Limb>(product);\n                carry = "
+    "static_cast<Limb>(product >> 64);\n            }\n            result[i + "
+    "b.size()] = carry;\n        }\n        trim(result);\n        return "
+    "result;\n    }\n\n    [[nodiscard]] static Limbs mul(const Limbs &a, "
+    "const Limbs &b) {\n        if (a.size() < b.size())\n            return "
+    "mul(b, a);\n        if (b.empty())\n            return {};\n        if "
+    "(b.size() < karatsuba_threshold)\n            return schoolbook(a, "
+    "b);\n\n        // a = a1 * B^half + a0, b = b1 * B^half + b0\n        "
+    "const std::size_t half = a.size() / 2;\n        Limbs a0(a.begin(), "
+    "a.begin() + half), a1(a.begin() + half, a.end());\n        trim(a0);\n    "
+    "    if (b.size() <= half) {\n            // unbalanced operands : a * b = "
+    "a0 * b + (a1 * b) * B^half\n            Limbs result = mul(a0, b);\n      "
+    "      add_to(result, mul(a1, b), half);\n            trim(result);\n      "
+    "      return result;\n        }\n        Limbs b0(b.begin(), b.begin() + "
+    "half), b1(b.begin() + half, b.end());\n        trim(b0);\n\n        // a "
+    "* b = z2 * B^(2 half) + (z1 - z2 - z0) * B^half + z0\n        const Limbs "
+    "z0 = mul(a0, b0);\n        const Limbs z2 = mul(a1, b1);\n        const "
+    "Limbs z1 = sub(sub(mul(add(a0, a1), add(b0, b1)), z0), z2);\n        "
+    "Limbs result = z0;\n        add_to(result, z1, half);\n        "
+    "add_to(result, z2, 2 * half);\n        trim(result);\n        return "
+    "result;\n    }\n\n    // divmod : schoolbook long division (Knuth, "
+    "algorithm D)\n    static void divmod(const Limbs &a, const Limbs &b, "
+    "Limbs &quotient,\n                       Limbs &remainder) {\n        if "
+    "(compare(a, b) < 0) {\n            quotient.clear();\n            "
+    "remainder = a;\n            return;\n        }\n        if (b.size() == "
+    "1) {\n            quotient = a;\n            const Limb r = "
+    "div_small(quotient, b[0]);\n            remainder = r ? Limbs{r} : "
+    "Limbs{};\n            return;\n        }\n\n        // normalize so that "
+    "the top bit of the divisor is set\n        const int shift = "
+    "__builtin_clzll(b.back());\n        const Limbs v = shift_left(b, "
+    "shift);\n        Limbs u = shift_left(a, shift);\n        "
+    "u.resize(a.size() + 1);\n        const std::size_t n = v.size(), m = "
+    "a.size() - b.size();\n        quotient.assign(m + 1, 0);\n\n        for "
+    "(auto j = m + 1; j-- > 0;) {\n            const Wide numerator = "
+    "(Wide(u[j + n]) << 64) | u[j + n - 1];\n            Wide qhat = numerator "
+    "/ v[n - 1];\n            Wide rhat = numerator % v[n - 1];\n            "
+    "while (qhat >> 64 ||\n                   qhat * v[n - 2] > ((rhat << 64) "
+    "| u[j + n - 2])) {\n                qhat--;\n                rhat += v[n "
+    "- 1];\n                if (rhat >> 64)\n                    break;\n      "
+    "      }\n\n            // u[j .. j + n] -= qhat * v\n            Limb "
+    "borrow = 0, carry = 0;\n            for (std::size_t i = 0; i < n; i++) "
+    "{\n                const Wide product = qhat * v[i] + carry;\n            "
+    "    carry = static_cast<Limb>(product >> 64);\n                const Limb "
+    "low = static_cast<Limb>(product);\n                const Limb d = u[i + "
+    "j] - low - borrow;\n                borrow = (u[i + j] < low || (u[i + j] "
+    "== low && borrow)) ? 1 : 0;\n                u[i + j] = d;\n            "
+    "}\n            const Limb top = u[j + n];\n            u[j + n] = top - "
+    "carry - borrow;\n            const bool negative = top < carry || (top == "
+    "carry && borrow);\n\n            // qhat was one too large, add the "
+    "divisor back\n            if (negative) {\n                qhat--;\n      "
+    "          Limb c = 0;\n                for (std::size_t i = 0; i < n; "
+    "i++) {\n                    const Wide sum = Wide(u[i + j]) + v[i] + c;\n "
+    "                   u[i + j] = static_cast<Limb>(sum);\n                   "
+    " c = static_cast<Limb>(sum >> 64);\n                }\n                "
+    "u[j + n] += c;\n            }\n            quotient[j] = "
+    "static_cast<Limb>(qhat);\n        }\n        trim(quotient);\n        "
+    "u.resize(n);\n        remainder = shift_right(u, shift);\n    }\n\n    "
+    "[[nodiscard]] static Limbs shift_left(const Limbs &v, int shift) {\n      "
+    "  Limbs result(v.size() + 1);\n        for (std::size_t i = 0; i < "
+    "v.size(); i++) {\n            result[i] |= v[i] << shift;\n            if "
+    "(shift)\n                result[i + 1] = v[i] >> (64 - shift);\n        "
+    "}\n        trim(result);\n        return result;\n    }\n\n    "
+    "[[nodiscard]] static Limbs shift_right(const Limbs &v, int shift) {\n     "
+    "   Limbs result(v.size());\n        for (std::size_t i = 0; i < v.size(); "
+    "i++) {\n            result[i] = v[i] >> shift;\n            if (shift && "
+    "i + 1 < v.size())\n                result[i] |= v[i + 1] << (64 - "
+    "shift);\n        }\n        trim(result);\n        return result;\n    "
+    "}\n};\n\n#pragma endregion Bignum\n\n// lisp value types\n#pragma region "
+    "ValueTypes\n\nenum class Type {\n    Symbol,\n    Int,\n    Bignum,\n    "
+    "Float,\n    String,\n    List,\n    Vector,\n    Procedure,\n    "
+    "HashTable,\n    Quoted,\n    T,\n    Nil,\n};\n\nstruct Value {\n    "
+    "virtual ~Value();\n    explicit Value(Type type);\n    virtual void "
+    "write(Printer &out) const = 0;\n    Type _type;\n};\n\n// symbols are "
+    "interned, so two symbols are the same symbol only if they are\n// the "
+    "same object\nstruct Symbol final : Value {\n    explicit "
+    "Symbol(std::string name)\n        : Value(Type::Symbol), "
+    "_name(std::move(name)) {}\n    std::string _name; // upper case print "
+    "name\n    void write(Printer &out) const override { out.write(_name); "
+    "}\n};\n\nstruct Int final : Value {\n    explicit Int(long long value) : "
+    "Value(Type::Int), _value(value) {}\n    long long _value;\n    void "
+    "write(Printer &out) const override {\n        out.write(static_cast<long "
+    "long>(_value));\n    }\n};\n\nstruct Bignum final : Value {\n    explicit "
+    "Bignum(BigInt value) : Value(Type::Bignum), _value(std::move(value)) {}\n "
+    "   BigInt _value;\n    void write(Printer &out) const override { "
+    "_value.write(out); }\n};\n\nstruct Float final : Value {\n    explicit "
+    "Float(double value) : Value(Type::Float), _value(value) {}\n    double "
+    "_value;\n    void write(Printer &out) const override { out.write(_value); "
+    "}\n};\n\nstruct String final : Value {\n    explicit String(std::string "
+    "value)\n        : Value(Type::String), _value(std::move(value)) {}\n    "
+    "std::string _value;\n    void write(Printer &out) const override {\n      "
+    "  out.put('\"');\n        out.write(_value);\n        out.put('\"');\n    "
+    "}\n};\n\nstruct List final : Value {\n    explicit "
     "List(std::vector<std::shared_ptr<Value>> value)\n        : "
     "Value(Type::List), _value(std::move(value)) {}\n    "
-    "std::vector<std::shared_ptr<Value>> _value;\n    [[nodiscard]] "
-    "std::string get() const override {\n        std::string result = \"(\";\n "
-    "       for (const auto &v : _value)\n            result += v->get() + \" "
-    "\";\n        if (!result.empty())\n            result.pop_back();\n       "
-    " return result + \")\";\n    }\n};\n\nstruct Quoted final : Value {\n    "
-    "explicit Quoted(std::shared_ptr<Value> value)\n        : "
+    "std::vector<std::shared_ptr<Value>> _value;\n    void write(Printer &out) "
+    "const override {\n        if (_value.empty()) {\n            "
+    "out.write(\"NIL\", 3);\n            return;\n        }\n        "
+    "out.put('(');\n        for (std::size_t i = 0; i < _value.size(); i++) "
+    "{\n            if (i)\n                out.put(' ');\n            "
+    "_value[i]->write(out);\n        }\n        out.put(')');\n    "
+    "}\n};\n\nstruct Vector final : Value {\n    // element storage, fixnum "
+    "and double-float vectors are unboxed\n    enum class Element {\n        "
+    "T,\n        Fixnum,\n        Double,\n    };\n    Vector(Element element, "
+    "std::size_t size)\n        : Value(Type::Vector), _element(element) {\n   "
+    "     if (element == Element::Fixnum)\n            "
+    "_fixnums.resize(size);\n        else if (element == Element::Double)\n    "
+    "        _doubles.resize(size);\n        else\n            "
+    "_values.resize(size);\n    }\n    Element _element;\n    "
+    "std::vector<std::shared_ptr<Value>> _values;\n    std::vector<long long> "
+    "_fixnums;\n    std::vector<double> _doubles;\n    [[nodiscard]] "
+    "std::size_t size() const {\n        if (_element == Element::Fixnum)\n    "
+    "        return _fixnums.size();\n        if (_element == "
+    "Element::Double)\n            return _doubles.size();\n        return "
+    "_values.size();\n    }\n    void write(Printer &out) const override {\n   "
+    "     out.write(\"#(\", 2);\n        for (std::size_t i = 0; i < size(); "
+    "i++) {\n            if (i)\n                out.put(' ');\n            if "
+    "(_element == Element::Fixnum)\n                out.write(_fixnums[i]);\n  "
+    "          else if (_element == Element::Double)\n                "
+    "out.write(_doubles[i]);\n            else\n                "
+    "_values[i]->write(out);\n        }\n        out.put(')');\n    "
+    "}\n};\n\nstruct Procedure final : Value {\n    // native entry point, "
+    "takes the evaluated arguments and the captured\n    // values of a "
+    "closure\n    using Native = std::shared_ptr<Value> (*)(const "
+    "std::shared_ptr<Value> *,\n                                              "
+    "const std::shared_ptr<Value> *);\n    Procedure(Native native, "
+    "std::size_t arity, const std::string &name,\n              "
+    "std::vector<std::shared_ptr<Value>> captured = {})\n        : "
+    "Value(Type::Procedure), _native(native), _arity(arity),\n          "
+    "_captured(std::move(captured)) {\n        _name.reserve(name.size());\n   "
+    "     for (const auto &c : name)\n            _name += "
+    "static_cast<char>(toupper(c));\n    }\n    Native _native;\n    "
+    "std::size_t _arity;\n    std::vector<std::shared_ptr<Value>> _captured; "
+    "// flat closure environment\n    std::string _name; // upper case print "
+    "name\n    void write(Printer &out) const override {\n        "
+    "out.write(\"#<FUNCTION \", 11);\n        out.write(_name);\n        "
+    "out.put('>');\n    }\n};\n\nstruct HashTable final : Value {\n    // open "
+    "addressing with robin hood probing, slots are kept sorted by\n    // "
+    "their distance from the home slot so lookups stop early; not locked,\n    "
+    "// the compiler rejects changes to a table inside pcall and pmapcar\n    "
+    "struct Slot {\n        std::shared_ptr<Value> _key;\n        "
+    "std::shared_ptr<Value> _value;\n        std::size_t _hash = 0;\n        "
+    "std::uint32_t _distance = 0; // probe distance + 1, 0 when empty\n    "
+    "};\n    explicit HashTable(bool structural)\n        : "
+    "Value(Type::HashTable), _structural(structural) {}\n    bool _structural; "
+    "// equal instead of eql\n    std::vector<Slot> _slots;\n    std::size_t "
+    "_count = 0;\n    [[nodiscard]] std::size_t locate(const "
+    "std::shared_ptr<Value> &key) const;\n    [[nodiscard]] const Slot "
+    "*find(const std::shared_ptr<Value> &key) const {\n        const auto i = "
+    "locate(key);\n        return i == SIZE_MAX ? nullptr : &_slots[i];\n    "
+    "}\n    void insert(std::shared_ptr<Value> key, std::shared_ptr<Value> "
+    "value);\n    bool erase(const std::shared_ptr<Value> &key);\n    void "
+    "write(Printer &out) const override {\n        out.write(_structural ? "
+    "\"#<HASH-TABLE :TEST EQUAL :COUNT \"\n                              : "
+    "\"#<HASH-TABLE :TEST EQL :COUNT \");\n        out.write(static_cast<long "
+    "long>(_count));\n        out.put('>');\n    }\n};\n\nstruct Quoted final "
+    ": Value {\n    explicit Quoted(std::shared_ptr<Value> value)\n        : "
     "Value(Type::Quoted), _value(std::move(value)) {}\n    "
-    "std::shared_ptr<Value> _value;\n    [[nodiscard]] std::string get() const "
-    "override { return \"'\" + _value->get(); }\n};\n\nstruct T final : Value "
-    "{\n    explicit T() : Value(Type::T) {}\n    [[nodiscard]] std::string "
-    "get() const override { return \"T\"; }\n};\n\nstruct Nil final : Value "
-    "{\n    explicit Nil() : Value(Type::Nil) {}\n    [[nodiscard]] "
-    "std::string get() const override { return \"NIL\"; }\n};\n\n#pragma "
-    "endregion ValueTypes\n\n// lisp function definition\n#pragma region "
-    "FunctionDefinition\n\nstruct Expression {\n    virtual ~Expression() = "
-    "default;\n    explicit "
-    "Expression(std::vector<std::shared_ptr<Expression>> values)\n        : "
-    "_values(std::move(values)) {}\n    [[nodiscard]] virtual "
-    "std::shared_ptr<Value> operator()() const = 0;\n\n    "
-    "std::vector<std::shared_ptr<Expression>> _values;\n};\n\n#pragma "
-    "endregion FunctionDefinition\n\n// lisp type alias\n#pragma region "
-    "TypeAlias\n\nusing Variable = std::shared_ptr<Value>;\nusing Function = "
+    "std::shared_ptr<Value> _value;\n    void write(Printer &out) const "
+    "override {\n        out.put('\\'');\n        _value->write(out);\n    "
+    "}\n};\n\nstruct T final : Value {\n    explicit T() : Value(Type::T) {}\n "
+    "   void write(Printer &out) const override { out.put('T'); "
+    "}\n};\n\nstruct Nil final : Value {\n    explicit Nil() : "
+    "Value(Type::Nil) {}\n    void write(Printer &out) const override { "
+    "out.write(\"NIL\", 3); }\n};\n\n#pragma endregion ValueTypes\n\n// lisp "
+    "function definition\n#pragma region FunctionDefinition\n\n// the "
+    "generator checks the number of arguments of every call it emits, so\n// "
+    "operator() does not check it again\nstruct Expression {\n    virtual "
+    "~Expression();\n    explicit "
+    "Expression(std::vector<std::shared_ptr<Expression>> values);\n    "
+    "[[nodiscard]] virtual std::shared_ptr<Value> operator()() const = 0;\n    "
+    "// typed expressions override these to skip boxing their result\n    "
+    "[[nodiscard]] virtual long long as_fixnum() const;\n    [[nodiscard]] "
+    "virtual double as_double() const;\n    [[nodiscard]] virtual bool "
+    "as_bool() const;\n    // evaluate for the side effects only\n    virtual "
+    "void execute() const;\n\n    std::vector<std::shared_ptr<Expression>> "
+    "_values;\n};\n\n#pragma endregion FunctionDefinition\n\n// lisp type "
+    "alias\n#pragma region TypeAlias\n\nusing Variable = "
+    "std::shared_ptr<Value>;\nusing Function = "
     "std::shared_ptr<Expression>;\nusing Args = "
     "std::vector<std::shared_ptr<Expression>>;\n\n#pragma endregion "
-    "TypeAlias\n\n// lisp helper functions\n#pragma region "
-    "HelperFunctions\n\n// to_symbol : convert a Value to a "
-    "Symbol\n[[nodiscard]] std::shared_ptr<Symbol> to_symbol(const Variable "
-    "&v) {\n    if (v->_type == Type::Symbol)\n        return "
+    "TypeAlias\n\n// lisp runtime statistics, printed on exit when "
+    "LISP_STATS=1\n#pragma region Statistics\n\n#include <algorithm>\n#include "
+    "<atomic>\n#include <cstdint>\n#include <cstdio>\n#include "
+    "<cstdlib>\n#include <cstring>\n\n// trivially destructible, so that "
+    "values destroyed during static destruction\n// can still update it, and "
+    "atomic, so that pcall and pmapcar can allocate\n// values on several "
+    "threads at once\nstruct Counter {\n    const char *_name;\n    "
+    "std::atomic<std::uint64_t> _allocs;\n    std::atomic<std::uint64_t> "
+    "_bytes;\n    std::atomic<std::uint64_t> _live;\n    "
+    "std::atomic<std::uint64_t> _max_live;\n    Counter *_next;\n\n    void "
+    "allocate(std::size_t bytes) {\n        _allocs.fetch_add(1, "
+    "std::memory_order_relaxed);\n        _bytes.fetch_add(bytes, "
+    "std::memory_order_relaxed);\n    }\n    void acquire() {\n        const "
+    "auto live = _live.fetch_add(1, std::memory_order_relaxed) + 1;\n        "
+    "auto max_live = _max_live.load(std::memory_order_relaxed);\n        while "
+    "(live > max_live &&\n               "
+    "!_max_live.compare_exchange_weak(max_live, live,\n                        "
+    "                        std::memory_order_relaxed)) {\n        }\n    }\n "
+    "   void release() { _live.fetch_sub(1, std::memory_order_relaxed); "
+    "}\n};\n\ninline Counter value_counters[] = {\n    {\"Symbol\"}, "
+    "{\"Int\"},       {\"Bignum\"}, {\"Float\"}, {\"String\"}, {\"List\"},\n   "
+    " {\"Vector\"}, {\"Procedure\"}, {\"HashTable\"}, {\"Quoted\"}, {\"T\"}, "
+    "{\"Nil\"},\n};\ninline Counter all_values{\"total\"};\ninline Counter "
+    "all_expressions{\"total\"};\ninline std::atomic<Counter *> "
+    "expression_counters{nullptr};\n\ninline void print_stats();\ninline void "
+    "print_memo_stats();\n\ninline const bool stats_enabled = [] {\n    const "
+    "char *env = std::getenv(\"LISP_STATS\");\n    if (!env || !*env || "
+    "std::strcmp(env, \"0\") == 0)\n        return false;\n    "
+    "std::atexit(print_stats);\n    return true;\n}();\n\n[[nodiscard]] inline "
+    "std::size_t value_size(Type type) {\n    switch (type) {\n    case "
+    "Type::Symbol: return sizeof(Symbol);\n    case Type::Int: return "
+    "sizeof(Int);\n    case Type::Bignum: return sizeof(Bignum);\n    case "
+    "Type::Float: return sizeof(Float);\n    case Type::String: return "
+    "sizeof(String);\n    case Type::List: return sizeof(List);\n    case "
+    "Type::Vector: return sizeof(Vector);\n    case Type::Procedure: return "
+    "sizeof(Procedure);\n    case Type::HashTable: return sizeof(HashTable);\n "
+    "   case Type::Quoted: return sizeof(Quoted);\n    case Type::T: return "
+    "sizeof(T);\n    case Type::Nil: return sizeof(Nil);\n    }\n    return "
+    "sizeof(Value);\n}\n\ninline Value::Value(Type type) : _type(type) {\n    "
+    "if (stats_enabled) {\n        auto &counter = "
+    "value_counters[static_cast<int>(type)];\n        "
+    "counter.allocate(value_size(type));\n        counter.acquire();\n        "
+    "all_values.allocate(value_size(type));\n        all_values.acquire();\n   "
+    " }\n}\n\ninline Value::~Value() {\n    if (stats_enabled) {\n        "
+    "value_counters[static_cast<int>(_type)].release();\n        "
+    "all_values.release();\n    }\n}\n\ninline "
+    "Expression::Expression(std::vector<std::shared_ptr<Expression>> values)\n "
+    "   : _values(std::move(values)) {\n    if (stats_enabled)\n        "
+    "all_expressions.acquire();\n}\n\ninline Expression::~Expression() {\n    "
+    "if (stats_enabled)\n        all_expressions.release();\n}\n\n// "
+    "register_counter : add a counter to the expression counters printed on "
+    "exit\ninline Counter &register_counter(Counter &counter) {\n    "
+    "counter._next = expression_counters.load();\n    while "
+    "(!expression_counters.compare_exchange_weak(counter._next, &counter)) {\n "
+    "   }\n    return counter;\n}\n\n// expression_counter : the counter of an "
+    "expression type\ntemplate <typename E> Counter &expression_counter(const "
+    "char *name) {\n    static Counter counter{name};\n    static Counter "
+    "&registered = register_counter(counter);\n    return registered;\n}\n\n// "
+    "make_expression : create an expression, counted under the name of its "
+    "type\ntemplate <typename E, typename... A>\n[[nodiscard]] inline "
+    "std::shared_ptr<E> make_expression(const char *name, A &&...args) {\n    "
+    "if (stats_enabled) {\n        "
+    "expression_counter<E>(name).allocate(sizeof(E));\n        "
+    "all_expressions.allocate(sizeof(E));\n    }\n    return "
+    "std::make_shared<E>(std::forward<A>(args)...);\n}\n\ninline void "
+    "print_counter(const Counter &c) {\n    fprintf(stderr, \"%-20s %14llu "
+    "%14llu %14llu\\n\", c._name,\n            static_cast<unsigned long "
+    "long>(c._allocs),\n            static_cast<unsigned long "
+    "long>(c._bytes),\n            static_cast<unsigned long "
+    "long>(c._max_live));\n}\n\ninline void print_stats() {\n    "
+    "output.flush();\n    fprintf(stderr, \"%-20s %14s %14s %14s\\n\", \"value "
+    "type\", \"allocs\", \"bytes\",\n            \"max live\");\n    for "
+    "(const auto &c : value_counters)\n        print_counter(c);\n    "
+    "print_counter(all_values);\n    fprintf(stderr, \"\\n%-20s %14s %14s "
+    "%14s\\n\", \"expression type\", \"allocs\",\n            \"bytes\", \"max "
+    "live\");\n    std::vector<const Counter *> expressions;\n    for (auto c "
+    "= expression_counters.load(); c; c = c->_next)\n        "
+    "expressions.push_back(c);\n    std::sort(expressions.begin(), "
+    "expressions.end(),\n              [](auto a, auto b) { return a->_allocs "
+    "> b->_allocs; });\n    for (const auto c : expressions)\n        "
+    "fprintf(stderr, \"%-20s %14llu %14llu %14s\\n\", c->_name,\n              "
+    "  static_cast<unsigned long long>(c->_allocs),\n                "
+    "static_cast<unsigned long long>(c->_bytes), \"-\");\n    "
+    "print_counter(all_expressions);\n    print_memo_stats();\n}\n\n#pragma "
+    "endregion Statistics\n\n// lisp helper functions\n#pragma region "
+    "HelperFunctions\n\n// checked : a dynamic type check, assumed to hold "
+    "when compiled with safety 0\n#ifdef LISP_UNSAFE\n#define "
+    "CHECKED(condition) true\n#else\n#define CHECKED(condition) "
+    "(condition)\n#endif\n\n// to_symbol : convert a Value to a "
+    "Symbol\n[[nodiscard]] inline std::shared_ptr<Symbol> to_symbol(const "
+    "Variable &v) {\n    if (v->_type == Type::Symbol)\n        return "
     "std::static_pointer_cast<Symbol>(v);\n    throw "
     "std::runtime_error(\"Invalid type conversion\");\n}\n\n// to_int : "
-    "convert a Value to an Int\n[[nodiscard]] std::shared_ptr<Int> "
+    "convert a Value to an Int\n[[nodiscard]] inline std::shared_ptr<Int> "
     "to_int(const Variable &v) {\n    if (v->_type == Type::Int)\n        "
     "return std::static_pointer_cast<Int>(v);\n    if (v->_type == "
     "Type::Float)\n        return std::make_shared<Int>(\n            "
-    "static_cast<int>(std::static_pointer_cast<Float>(v)->_value));\n    throw "
-    "std::runtime_error(\"Invalid type conversion\");\n}\n\n// to_float : "
-    "convert a Value to a Float\n[[nodiscard]] std::shared_ptr<Float> "
+    "static_cast<long long>(std::static_pointer_cast<Float>(v)->_value));\n    "
+    "throw std::runtime_error(\"Invalid type conversion\");\n}\n\n// to_float "
+    ": convert a Value to a Float\n[[nodiscard]] inline std::shared_ptr<Float> "
     "to_float(const Variable &v) {\n    if (v->_type == Type::Float)\n        "
     "return std::static_pointer_cast<Float>(v);\n    if (v->_type == "
     "Type::Int)\n        return std::make_shared<Float>(\n            "
     "static_cast<double>(std::static_pointer_cast<Int>(v)->_value));\n    "
     "throw std::runtime_error(\"Invalid type conversion\");\n}\n\n// to_string "
-    ": convert a Value to a String\n[[nodiscard]] std::shared_ptr<String> "
-    "to_string(const Variable &v) {\n    if (v->_type == Type::String)\n       "
-    " return std::static_pointer_cast<String>(v);\n    throw "
-    "std::runtime_error(\"Invalid type conversion\");\n}\n\n// to_list : "
-    "convert a Value to a List\n[[nodiscard]] std::shared_ptr<List> "
-    "to_list(const Variable &v) {\n    if (v->_type == Type::List)\n        "
-    "return std::static_pointer_cast<List>(v);\n    if (v->_type == "
-    "Type::Nil)\n        return "
-    "std::make_shared<List>(std::vector<std::shared_ptr<Value>>());\n    throw "
+    ": convert a Value to a String\n[[nodiscard]] inline "
+    "std::shared_ptr<String> to_string(const Variable &v) {\n    if (v->_type "
+    "== Type::String)\n        return std::static_pointer_cast<String>(v);\n   "
+    " throw std::runtime_error(\"Invalid type conversion\");\n}\n\n// to_list "
+    ": convert a Value to a List\n[[nodiscard]] inline std::shared_ptr<List> "
+    "to_list(const Variable &v) {\n    if (v->_type == Type::Nil)\n        "
+    "return std::make_shared<List>(std::vector<std::shared_ptr<Value>>());\n   "
+    " if (CHECKED(v->_type == Type::List))\n        return "
+    "std::static_pointer_cast<List>(v);\n    throw "
     "std::runtime_error(\"Invalid type conversion\");\n}\n\n// to_quoted : "
-    "convert a Value to a Quoted\n[[nodiscard]] std::shared_ptr<Quoted> "
+    "convert a Value to a Quoted\n[[nodiscard]] inline std::shared_ptr<Quoted> "
     "to_quoted(const Variable &v) {\n    if (v->_type == Type::Quoted)\n       "
     " return std::static_pointer_cast<Quoted>(v);\n    throw "
     "std::runtime_error(\"Invalid type conversion\");\n}\n\n// to_t : convert "
-    "a Value to a T\n[[nodiscard]] std::shared_ptr<T> to_t(const Variable &v) "
-    "{\n    if (v->_type == Type::T)\n        return "
+    "a Value to a T\n[[nodiscard]] inline std::shared_ptr<T> to_t(const "
+    "Variable &v) {\n    if (v->_type == Type::T)\n        return "
     "std::static_pointer_cast<T>(v);\n    throw std::runtime_error(\"Invalid "
     "type conversion\");\n}\n\n// to_nil : convert a Value to a "
-    "Nil\n[[nodiscard]] std::shared_ptr<Nil> to_nil(const Variable &v) {\n    "
-    "if (v->_type == Type::Nil)\n        return "
+    "Nil\n[[nodiscard]] inline std::shared_ptr<Nil> to_nil(const Variable &v) "
+    "{\n    if (v->_type == Type::Nil)\n        return "
     "std::static_pointer_cast<Nil>(v);\n    throw std::runtime_error(\"Invalid "
-    "type conversion\");\n}\n\n// to_t_or_nil : convert a boolean to a T or "
-    "Nil\n[[nodiscard]] std::shared_ptr<Value> to_t_or_nil(bool value) {\n    "
-    "if (value)\n        return std::make_shared<T>();\n    return "
-    "std::make_shared<Nil>();\n}\n\n#pragma endregion HelperFunctions\n\n// "
-    "lisp value functions\n#pragma region ValueFunctions\n\n// symbol : create "
-    "a symbol\nstruct SymbolFunction final : public Expression {\n    explicit "
+    "type conversion\");\n}\n\n// fixnum : the value of an Int, v must be an "
+    "Int\n[[nodiscard]] inline long long fixnum(const Variable &v) {\n    "
+    "return static_cast<const Int &>(*v)._value;\n}\n\n// is_integer : check "
+    "if a Value is an Int or a Bignum\n[[nodiscard]] inline bool "
+    "is_integer(const Variable &v) {\n    return v->_type == Type::Int || "
+    "v->_type == Type::Bignum;\n}\n\n// is_number : check if a Value is an "
+    "Int, a Bignum or a Float\n[[nodiscard]] inline bool is_number(const "
+    "Variable &v) {\n    return is_integer(v) || v->_type == "
+    "Type::Float;\n}\n\n// to_bigint : convert an Int or a Bignum to a "
+    "BigInt\n[[nodiscard]] inline BigInt to_bigint(const Variable &v) {\n    "
+    "if (v->_type == Type::Int)\n        return BigInt(fixnum(v));\n    if "
+    "(v->_type == Type::Bignum)\n        return "
+    "std::static_pointer_cast<Bignum>(v)->_value;\n    throw "
+    "std::runtime_error(\"Invalid type conversion\");\n}\n\n// to_double : "
+    "convert a number to a double\n[[nodiscard]] inline double to_double(const "
+    "Variable &v) {\n    if (v->_type == Type::Int)\n        return "
+    "static_cast<double>(fixnum(v));\n    if (v->_type == Type::Float)\n       "
+    " return std::static_pointer_cast<Float>(v)->_value;\n    if (v->_type == "
+    "Type::Bignum)\n        return "
+    "std::static_pointer_cast<Bignum>(v)->_value.to_double();\n    throw "
+    "std::runtime_error(\"Invalid type conversion\");\n}\n\n// make_integer : "
+    "convert a BigInt to an Int if it fits in a fixnum\n[[nodiscard]] inline "
+    "Variable make_integer(BigInt value) {\n    if (value.fits_fixnum())\n     "
+    "   return std::make_shared<Int>(value.to_fixnum());\n    return "
+    "std::make_shared<Bignum>(std::move(value));\n}\n\n// to_vector : convert "
+    "a Value to a Vector\n[[nodiscard]] inline std::shared_ptr<Vector> "
+    "to_vector(const Variable &v) {\n    if (v->_type == Type::Vector)\n       "
+    " return std::static_pointer_cast<Vector>(v);\n    throw "
+    "std::runtime_error(\"Invalid type conversion\");\n}\n\n// vector_element "
+    ": get an element of a vector, boxing unboxed storage\n[[nodiscard]] "
+    "inline Variable vector_element(const Vector &v, std::size_t i) {\n    if "
+    "(v._element == Vector::Element::Fixnum)\n        return "
+    "std::make_shared<Int>(v._fixnums[i]);\n    if (v._element == "
+    "Vector::Element::Double)\n        return "
+    "std::make_shared<Float>(v._doubles[i]);\n    return "
+    "v._values[i];\n}\n\n// make_list : create a List, or a Nil if there are "
+    "no elements\n[[nodiscard]] inline Variable "
+    "make_list(std::vector<Variable> values) {\n    if (values.empty())\n      "
+    "  return std::make_shared<Nil>();\n    return "
+    "std::make_shared<List>(std::move(values));\n}\n\n// call : call a "
+    "function value with evaluated arguments\n[[nodiscard]] inline Variable "
+    "call(const Variable &f, const Variable *args,\n                           "
+    " std::size_t count) {\n    if (f->_type != Type::Procedure)\n        "
+    "throw std::runtime_error(\"Invalid type for function call\");\n    const "
+    "auto &procedure = static_cast<const Procedure &>(*f);\n    if "
+    "(procedure._arity != count)\n        throw std::runtime_error(\"Invalid "
+    "number of arguments\");\n    return procedure._native(args, "
+    "procedure._captured.data());\n}\n\n// float_bits : the representation of "
+    "a float, which eql compares\n[[nodiscard]] inline std::uint64_t "
+    "float_bits(const Variable &v) {\n    const double value = to_double(v);\n "
+    "   std::uint64_t bits;\n    std::memcpy(&bits, &value, sizeof bits);\n    "
+    "return bits;\n}\n\n// eql : same object, or numbers of the same type and "
+    "representation\n[[nodiscard]] inline bool eql(const Variable &a, const "
+    "Variable &b) {\n    if (a == b)\n        return true;\n    if (a->_type "
+    "!= b->_type)\n        return false;\n    switch (a->_type) {\n    case "
+    "Type::Int:\n        return fixnum(a) == fixnum(b);\n    case "
+    "Type::Bignum:\n        return BigInt::compare(to_bigint(a), to_bigint(b)) "
+    "== 0;\n    case Type::Float:\n        // the same representation, so 0.0 "
+    "and -0.0 are not eql\n        return float_bits(a) == float_bits(b);\n    "
+    "case Type::T:\n    case Type::Nil:\n        return true;\n    default:\n  "
+    "      return false;\n    }\n}\n\n// equal : eql, or strings and lists "
+    "with equal elements\n[[nodiscard]] inline bool equal(const Variable &a, "
+    "const Variable &b) {\n    if (eql(a, b))\n        return true;\n    if "
+    "(a->_type != b->_type)\n        return false;\n    if (a->_type == "
+    "Type::String)\n        return to_string(a)->_value == "
+    "to_string(b)->_value;\n    if (a->_type == Type::Quoted)\n        return "
+    "equal(to_quoted(a)->_value, to_quoted(b)->_value);\n    if (a->_type != "
+    "Type::List)\n        return false;\n    const auto &x = "
+    "to_list(a)->_value, &y = to_list(b)->_value;\n    if (x.size() != "
+    "y.size())\n        return false;\n    for (std::size_t i = 0; i < "
+    "x.size(); i++)\n        if (!equal(x[i], y[i]))\n            return "
+    "false;\n    return true;\n}\n\n// hash_combine : mix a hash into a "
+    "seed\n[[nodiscard]] inline std::size_t hash_combine(std::size_t seed, "
+    "std::size_t hash) {\n    return seed ^ (hash + 0x9e3779b97f4a7c15ULL + "
+    "(seed << 6) + (seed >> 2));\n}\n\n// hash_value : hash consistent with "
+    "eql, or with equal if structural is set,\n// seeded with the type "
+    "tag\n[[nodiscard]] inline std::size_t hash_value(const Variable &v, bool "
+    "structural) {\n    const auto seed = "
+    "static_cast<std::size_t>(v->_type);\n    switch (v->_type) {\n    case "
+    "Type::Int:\n        return hash_combine(seed, std::hash<long "
+    "long>()(fixnum(v)));\n    case Type::Bignum: {\n        const auto &value "
+    "= std::static_pointer_cast<Bignum>(v)->_value;\n        auto hash = "
+    "hash_combine(seed, value._negative);\n        for (const auto limb : "
+    "value._limbs)\n            hash = hash_combine(hash, "
+    "std::hash<std::uint64_t>()(limb));\n        return hash;\n    }\n    case "
+    "Type::Float:\n        return hash_combine(seed, "
+    "std::hash<std::uint64_t>()(float_bits(v)));\n    case Type::Symbol:\n     "
+    "   return hash_combine(seed, std::hash<const Value *>()(v.get()));\n    "
+    "case Type::T:\n    case Type::Nil:\n        return seed;\n    default:\n  "
+    "      break;\n    }\n    if (structural) {\n        if (v->_type == "
+    "Type::String)\n            return hash_combine(seed,\n                    "
+    "            std::hash<std::string>()(to_string(v)->_value));\n        if "
+    "(v->_type == Type::Quoted)\n            return hash_combine(seed, "
+    "hash_value(to_quoted(v)->_value, true));\n        if (v->_type == "
+    "Type::List) {\n            auto hash = seed;\n            for (const auto "
+    "&e : to_list(v)->_value)\n                hash = hash_combine(hash, "
+    "hash_value(e, true));\n            return hash;\n        }\n    }\n    "
+    "return hash_combine(seed, std::hash<const Value *>()(v.get()));\n}\n\n// "
+    "is_true : check if a condition holds, nil and zero are "
+    "false\n[[nodiscard]] inline bool is_true(const Variable &v) {\n    return "
+    "!(v->_type == Type::Nil ||\n             (v->_type == Type::Int && "
+    "fixnum(v) == 0) ||\n             (v->_type == Type::Float && to_double(v) "
+    "== 0));\n}\n\n// unbox_fixnum : the value of a variable declared "
+    "fixnum\n[[nodiscard]] inline long long unbox_fixnum(const Variable &v) "
+    "{\n    if (CHECKED(v->_type == Type::Int))\n        return fixnum(v);\n   "
+    " throw std::runtime_error(\"Invalid type for fixnum "
+    "declaration\");\n}\n\n// unbox_double : the value of a variable declared "
+    "double-float\n[[nodiscard]] inline double unbox_double(const Variable &v) "
+    "{\n    if (CHECKED(v->_type == Type::Float))\n        return "
+    "static_cast<const Float &>(*v)._value;\n    throw "
+    "std::runtime_error(\"Invalid type for double-float "
+    "declaration\");\n}\n\ninline long long Expression::as_fixnum() const { "
+    "return unbox_fixnum(operator()()); }\n\ninline double "
+    "Expression::as_double() const { return unbox_double(operator()()); "
+    "}\n\ninline bool Expression::as_bool() const { return "
+    "is_true(operator()()); }\n\ninline void Expression::execute() const { "
+    "auto discard = operator()(); }\n\n// to_t_or_nil : convert a boolean to a "
+    "T or Nil\n[[nodiscard]] inline std::shared_ptr<Value> to_t_or_nil(bool "
+    "value) {\n    if (value)\n        return std::make_shared<T>();\n    "
+    "return std::make_shared<Nil>();\n}\n\n// intern : the symbol of a print "
+    "name, shared by every module of a program\n[[nodiscard]] inline Variable "
+    "intern(const char *name) {\n    static std::mutex mutex;\n    static "
+    "std::unordered_map<std::string, Variable> symbols;\n    "
+    "std::lock_guard<std::mutex> lock(mutex);\n    auto &symbol = "
+    "symbols[name];\n    if (!symbol)\n        symbol = "
+    "std::make_shared<Symbol>(name);\n    return symbol;\n}\n\n#pragma "
+    "endregion HelperFunctions\n\n// lisp hash tables\n#pragma region "
+    "HashTables\n\n// locate : index of the slot of a key, SIZE_MAX if it is "
+    "absent\ninline std::size_t HashTable::locate(const Variable &key) const "
+    "{\n    if (_slots.empty())\n        return SIZE_MAX;\n    const "
+    "std::size_t mask = _slots.size() - 1;\n    const std::size_t hash = "
+    "hash_value(key, _structural);\n    for (std::size_t i = hash & mask, "
+    "distance = 1;; i = (i + 1) & mask) {\n        const auto &slot = "
+    "_slots[i];\n        // a closer entry means the key would have been "
+    "placed before it\n        if (slot._distance < distance)\n            "
+    "return SIZE_MAX;\n        if (slot._hash == hash &&\n            "
+    "(_structural ? equal(slot._key, key) : eql(slot._key, key)))\n            "
+    "return i;\n        distance++;\n    }\n}\n\ninline void "
+    "HashTable::insert(Variable key, Variable value) {\n    if (const auto i = "
+    "locate(key); i != SIZE_MAX) {\n        _slots[i]._value = "
+    "std::move(value);\n        return;\n    }\n    // grow at 7/8 load, "
+    "rehashing every entry\n    if ((_count + 1) * 8 > _slots.size() * 7) {\n  "
+    "      std::vector<Slot> slots(std::max<std::size_t>(8, _slots.size() * "
+    "2));\n        std::swap(slots, _slots);\n        _count = 0;\n        for "
+    "(auto &slot : slots)\n            if (slot._distance)\n                "
+    "insert(std::move(slot._key), std::move(slot._value));\n    }\n    const "
+    "std::size_t mask = _slots.size() - 1;\n    Slot entry{std::move(key), "
+    "std::move(value), 0, 1};\n    entry._hash = hash_value(entry._key, "
+    "_structural);\n    // take the slot of any entry closer to its home than "
+    "this one\n    for (std::size_t i = entry._hash & mask;; i = (i + 1) & "
+    "mask) {\n        auto &slot = _slots[i];\n        if (!slot._distance) "
+    "{\n            slot = std::move(entry);\n            break;\n        }\n  "
+    "      if (slot._distance < entry._distance)\n            std::swap(slot, "
+    "entry);\n        entry._distance++;\n    }\n    _count++;\n}\n\ninline "
+    "bool HashTable::erase(const Variable &key) {\n    std::size_t i = "
+    "locate(key);\n    if (i == SIZE_MAX)\n        return false;\n    // shift "
+    "the following entries back, there are no tombstones\n    const "
+    "std::size_t mask = _slots.size() - 1;\n    for (std::size_t j = (i + 1) & "
+    "mask; _slots[j]._distance > 1;\n         i = j, j = (j + 1) & mask) {\n   "
+    "     _slots[i] = std::move(_slots[j]);\n        _slots[i]._distance--;\n  "
+    "  }\n    _slots[i] = Slot();\n    _count--;\n    return true;\n}\n\n// "
+    "to_hash_table : convert a Value to a HashTable\n[[nodiscard]] inline "
+    "std::shared_ptr<HashTable> to_hash_table(const Variable &v) {\n    if "
+    "(v->_type == Type::HashTable)\n        return "
+    "std::static_pointer_cast<HashTable>(v);\n    throw "
+    "std::runtime_error(\"Invalid type conversion\");\n}\n\n#pragma endregion "
+    "HashTables\n\n// lisp profiler, enabled by compiling with "
+    "--profile\n#pragma region Profiler\n\n// set on the threads of the "
+    "parallel pool, only the main thread is profiled\ninline thread_local bool "
+    "worker_thread = false;\n\n#ifdef LISP_PROFILE\n\n#include "
+    "<algorithm>\n#include <chrono>\n#include <cstdint>\n#include "
+    "<cstdio>\n#include <cstdlib>\n#include <fstream>\n#include "
+    "<unordered_map>\n\n// statistics of one lisp function\nstruct "
+    "ProfileEntry {\n    explicit ProfileEntry(const char *name) : _name(name) "
+    "{}\n    const char *_name;\n    std::uint64_t _calls = 0;\n    "
+    "std::uint64_t _inclusive = 0; // nanoseconds, outermost activations "
+    "only\n    std::uint64_t _exclusive = 0; // nanoseconds, without callees\n "
+    "   unsigned _depth = 0;\n    unsigned _max_depth = 0;\n};\n\n// node of "
+    "the call tree, used to write collapsed stacks\nstruct ProfileNode {\n    "
+    "ProfileNode(ProfileEntry *entry, ProfileNode *parent)\n        : "
+    "_entry(entry), _parent(parent) {}\n    ProfileEntry *_entry;\n    "
+    "ProfileNode *_parent;\n    std::uint64_t _self = 0;\n    "
+    "std::unordered_map<ProfileEntry *, std::unique_ptr<ProfileNode>> "
+    "_children;\n};\n\nstruct Profiler {\n    Profiler() : _root(nullptr, "
+    "nullptr), _current(&_root) {}\n    ~Profiler() {\n        const char "
+    "*prefix = std::getenv(\"LISP_PROFILE_OUTPUT\");\n        const "
+    "std::string path = prefix ? prefix : \"lisp-profile\";\n        "
+    "write_report(path + \".txt\");\n        write_folded(path + "
+    "\".folded\");\n    }\n\n    ProfileEntry &entry(const char *name) {\n     "
+    "   std::lock_guard<std::mutex> lock(_mutex);\n        "
+    "_entries.push_back(std::make_unique<ProfileEntry>(name));\n        return "
+    "*_entries.back();\n    }\n\n    // sorted by exclusive time\n    void "
+    "write_report(const std::string &path) const {\n        "
+    "std::vector<ProfileEntry *> entries;\n        for (const auto &e : "
+    "_entries)\n            if (e->_calls)\n                "
+    "entries.push_back(e.get());\n        std::sort(entries.begin(), "
+    "entries.end(), [](auto a, auto b) {\n            return a->_exclusive > "
+    "b->_exclusive;\n        });\n        std::ofstream out(path);\n        "
+    "char line[256];\n        snprintf(line, sizeof(line), \"%14s %14s %14s "
+    "%10s  %s\\n\", \"calls\",\n                 \"inclusive ms\", \"exclusive "
+    "ms\", \"max depth\", \"function\");\n        out << line;\n        for "
+    "(const auto e : entries) {\n            snprintf(line, sizeof(line), "
+    "\"%14llu %14.3f %14.3f %10u  %s\\n\",\n                     "
+    "static_cast<unsigned long long>(e->_calls),\n                     "
+    "e->_inclusive / 1e6, e->_exclusive / 1e6, e->_max_depth,\n                "
+    "     e->_name);\n            out << line;\n        }\n    }\n\n    // one "
+    "\"caller;callee microseconds\" line per call path, for flamegraph.pl\n    "
+    "void write_folded(const std::string &path) const {\n        std::ofstream "
+    "out(path);\n        std::string stack;\n        write_folded(out, _root, "
+    "stack);\n    }\n\n    static void write_folded(std::ofstream &out, const "
+    "ProfileNode &node,\n                             std::string &stack) {\n  "
+    "      const auto length = stack.size();\n        if (node._entry) {\n     "
+    "       if (!stack.empty())\n                stack += ';';\n            "
+    "stack += node._entry->_name;\n            if (node._self >= 1000)\n       "
+    "         out << stack << ' ' << node._self / 1000 << '\\n';\n        }\n  "
+    "      for (const auto &[entry, child] : node._children)\n            "
+    "write_folded(out, *child, stack);\n        stack.resize(length);\n    "
+    "}\n\n    std::vector<std::unique_ptr<ProfileEntry>> _entries;\n    "
+    "std::mutex _mutex; // entries are registered from any thread\n    "
+    "ProfileNode _root;\n    ProfileNode *_current;\n};\n\ninline Profiler "
+    "&profiler() {\n    static Profiler instance;\n    return "
+    "instance;\n}\n\n// records one activation of a lisp function for the "
+    "lifetime of the object\nstruct ProfileScope {\n    explicit "
+    "ProfileScope(ProfileEntry &entry)\n        : _entry(entry) {\n        if "
+    "(worker_thread)\n            return;\n        auto &p = profiler();\n     "
+    "   auto &child = p._current->_children[&entry];\n        if (!child)\n    "
+    "        child = std::make_unique<ProfileNode>(&entry, p._current);\n      "
+    "  p._current = child.get();\n        _node = child.get();\n        _outer "
+    "= current;\n        current = this;\n        _entry._calls++;\n        "
+    "_entry._max_depth = std::max(_entry._max_depth, ++_entry._depth);\n       "
+    " _start = std::chrono::steady_clock::now();\n    }\n    ~ProfileScope() "
+    "{\n        if (!_node)\n            return;\n        const std::uint64_t "
+    "elapsed =\n            "
+    "std::chrono::duration_cast<std::chrono::nanoseconds>(\n                "
+    "std::chrono::steady_clock::now() - _start)\n                .count();\n   "
+    "     const std::uint64_t self = elapsed - std::min(elapsed, _children);\n "
+    "       _entry._exclusive += self;\n        if (--_entry._depth == 0)\n    "
+    "        _entry._inclusive += elapsed;\n        _node->_self += self;\n    "
+    "    profiler()._current = _node->_parent;\n        current = _outer;\n    "
+    "    if (_outer)\n            _outer->_children += elapsed;\n    }\n\n    "
+    "ProfileEntry &_entry;\n    ProfileNode *_node = nullptr;\n    "
+    "ProfileScope *_outer = nullptr;\n    std::uint64_t _children = 0;\n    "
+    "std::chrono::steady_clock::time_point _start;\n    static inline "
+    "ProfileScope *current = nullptr;\n};\n\n#define PROFILE(name)             "
+    "                                             \\\n    static ProfileEntry "
+    "&_profile_entry = profiler().entry(name);              \\\n    "
+    "ProfileScope _profile_scope(_profile_entry)\n\n#else\n\n#define "
+    "PROFILE(name)\n\n#endif\n\n#pragma endregion Profiler\n\n// simd kernels "
+    "of the vector operations, with a scalar fallback\n#pragma region "
+    "VectorKernels\n\n#if defined(__x86_64__)\n#include <immintrin.h>\n#define "
+    "LISP_X86 1\n#endif\n\n#ifdef LISP_X86\ninline const bool has_avx2 = "
+    "__builtin_cpu_supports(\"avx2\");\n#endif\n\n// add_overflows : check if "
+    "a + b overflowed into r\n[[nodiscard]] inline bool add_overflows(long "
+    "long a, long long b, long long r) {\n    return ((a ^ r) & (b ^ r)) < "
+    "0;\n}\n\n#ifdef LISP_X86\n\n__attribute__((target(\"avx2\"))) inline void "
+    "add_f64_avx2(const double *a, const double *b, double *r, std::size_t n) "
+    "{\n    std::size_t i = 0;\n    for (; i + 4 <= n; i += 4)\n        "
+    "_mm256_storeu_pd(r + i, _mm256_add_pd(_mm256_loadu_pd(a + i), "
+    "_mm256_loadu_pd(b + i)));\n    for (; i < n; i++)\n        r[i] = a[i] + "
+    "b[i];\n}\n\n__attribute__((target(\"avx2\"))) inline void "
+    "mul_f64_avx2(const double *a, const double *b, double *r, std::size_t n) "
+    "{\n    std::size_t i = 0;\n    for (; i + 4 <= n; i += 4)\n        "
+    "_mm256_storeu_pd(r + i, _mm256_mul_pd(_mm256_loadu_pd(a + i), "
+    "_mm256_loadu_pd(b + i)));\n    for (; i < n; i++)\n        r[i] = a[i] * "
+    "b[i];\n}\n\n// returns false if any element "
+    "overflowed\n__attribute__((target(\"avx2\"))) inline bool "
+    "add_i64_avx2(const long long *a, const long long *b, long long *r, "
+    "std::size_t n) {\n    std::size_t i = 0;\n    __m256i overflow = "
+    "_mm256_setzero_si256();\n    for (; i + 4 <= n; i += 4) {\n        const "
+    "__m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + "
+    "i));\n        const __m256i y = _mm256_loadu_si256(reinterpret_cast<const "
+    "__m256i *>(b + i));\n        const __m256i s = _mm256_add_epi64(x, y);\n  "
+    "      overflow = _mm256_or_si256(overflow, "
+    "_mm256_and_si256(_mm256_xor_si256(x, s), _mm256_xor_si256(y, s)));\n      "
+    "  _mm256_storeu_si256(reinterpret_cast<__m256i *>(r + i), s);\n    }\n    "
+    "bool ok = _mm256_movemask_pd(_mm256_castsi256_pd(overflow)) == 0;\n    "
+    "for (; i < n; i++)\n        ok &= !__builtin_add_overflow(a[i], b[i], r + "
+    "i);\n    return ok;\n}\n\n__attribute__((target(\"avx2\"))) inline double "
+    "dot_f64_avx2(const double *a, const double *b, std::size_t n) {\n    "
+    "std::size_t i = 0;\n    __m256d sum = _mm256_setzero_pd();\n    for (; i "
+    "+ 4 <= n; i += 4)\n        sum = _mm256_add_pd(sum, "
+    "_mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));\n    "
+    "alignas(32) double lanes[4];\n    _mm256_store_pd(lanes, sum);\n    "
+    "double result = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);\n    for "
+    "(; i < n; i++)\n        result += a[i] * b[i];\n    return "
+    "result;\n}\n\n__attribute__((target(\"avx2\"))) inline double "
+    "sum_f64_avx2(const double *a, std::size_t n) {\n    std::size_t i = 0;\n  "
+    "  __m256d sum = _mm256_setzero_pd();\n    for (; i + 4 <= n; i += 4)\n    "
+    "    sum = _mm256_add_pd(sum, _mm256_loadu_pd(a + i));\n    alignas(32) "
+    "double lanes[4];\n    _mm256_store_pd(lanes, sum);\n    double result = "
+    "(lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);\n    for (; i < n; i++)\n  "
+    "      result += a[i];\n    return result;\n}\n\n// returns false if the "
+    "sum overflowed\n__attribute__((target(\"avx2\"))) inline bool "
+    "sum_i64_avx2(const long long *a, std::size_t n, long long &result) {\n    "
+    "std::size_t i = 0;\n    __m256i sum = _mm256_setzero_si256();\n    "
+    "__m256i overflow = _mm256_setzero_si256();\n    for (; i + 4 <= n; i += "
+    "4) {\n        const __m256i x = _mm256_loadu_si256(reinterpret_cast<const "
+    "__m256i *>(a + i));\n        const __m256i s = _mm256_add_epi64(sum, "
+    "x);\n        overflow = _mm256_or_si256(overflow, "
+    "_mm256_and_si256(_mm256_xor_si256(sum, s), _mm256_xor_si256(x, s)));\n    "
+    "    sum = s;\n    }\n    alignas(32) long long lanes[4];\n    "
+    "_mm256_store_si256(reinterpret_cast<__m256i *>(lanes), sum);\n    bool ok "
+    "= _mm256_movemask_pd(_mm256_castsi256_pd(overflow)) == 0;\n    result = "
+    "0;\n    for (const auto lane : lanes)\n        ok &= "
+    "!__builtin_add_overflow(result, lane, &result);\n    for (; i < n; i++)\n "
+    "       ok &= !__builtin_add_overflow(result, a[i], &result);\n    return "
+    "ok;\n}\n\n// min or max of a non empty array\ntemplate <bool "
+    "Max>\n__attribute__((target(\"avx2\"))) inline double "
+    "extreme_f64_avx2(const double *a, std::size_t n) {\n    std::size_t i = "
+    "4;\n    if (n < 4) {\n        double result = a[0];\n        for (i = 1; "
+    "i < n; i++)\n            result = Max ? std::max(result, a[i]) : "
+    "std::min(result, a[i]);\n        return result;\n    }\n    __m256d m = "
+    "_mm256_loadu_pd(a);\n    for (; i + 4 <= n; i += 4)\n        m = Max ? "
+    "_mm256_max_pd(m, _mm256_loadu_pd(a + i)) : _mm256_min_pd(m, "
+    "_mm256_loadu_pd(a + i));\n    alignas(32) double lanes[4];\n    "
+    "_mm256_store_pd(lanes, m);\n    double result = lanes[0];\n    for (int j "
+    "= 1; j < 4; j++)\n        result = Max ? std::max(result, lanes[j]) : "
+    "std::min(result, lanes[j]);\n    for (; i < n; i++)\n        result = Max "
+    "? std::max(result, a[i]) : std::min(result, a[i]);\n    return "
+    "result;\n}\n\ntemplate <bool Max>\n__attribute__((target(\"avx2\"))) "
+    "inline long long extreme_i64_avx2(const long long *a, std::size_t n) {\n  "
+    "  std::size_t i = 4;\n    if (n < 4) {\n        long long result = "
+    "a[0];\n        for (i = 1; i < n; i++)\n            result = Max ? "
+    "std::max(result, a[i]) : std::min(result, a[i]);\n        return "
+    "result;\n    }\n    __m256i m = _mm256_loadu_si256(reinterpret_cast<const "
+    "__m256i *>(a));\n    for (; i + 4 <= n; i += 4) {\n        const __m256i "
+    "x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));\n       "
+    " const __m256i greater = Max ? _mm256_cmpgt_epi64(x, m) : "
+    "_mm256_cmpgt_epi64(m, x);\n        m = _mm256_blendv_epi8(m, x, "
+    "greater);\n    }\n    alignas(32) long long lanes[4];\n    "
+    "_mm256_store_si256(reinterpret_cast<__m256i *>(lanes), m);\n    long long "
+    "result = lanes[0];\n    for (int j = 1; j < 4; j++)\n        result = Max "
+    "? std::max(result, lanes[j]) : std::min(result, lanes[j]);\n    for (; i "
+    "< n; i++)\n        result = Max ? std::max(result, a[i]) : "
+    "std::min(result, a[i]);\n    return result;\n}\n\ninline void "
+    "add_f64_sse2(const double *a, const double *b, double *r, std::size_t n) "
+    "{\n    std::size_t i = 0;\n    for (; i + 2 <= n; i += 2)\n        "
+    "_mm_storeu_pd(r + i, _mm_add_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + "
+    "i)));\n    for (; i < n; i++)\n        r[i] = a[i] + b[i];\n}\n\ninline "
+    "void mul_f64_sse2(const double *a, const double *b, double *r, "
+    "std::size_t n) {\n    std::size_t i = 0;\n    for (; i + 2 <= n; i += "
+    "2)\n        _mm_storeu_pd(r + i, _mm_mul_pd(_mm_loadu_pd(a + i), "
+    "_mm_loadu_pd(b + i)));\n    for (; i < n; i++)\n        r[i] = a[i] * "
+    "b[i];\n}\n\n#endif\n\n// the kernels below pick the widest instruction "
+    "set available at runtime\n\ninline void add_f64(const double *a, const "
+    "double *b, double *r, std::size_t n) {\n#ifdef LISP_X86\n    if "
+    "(has_avx2)\n        return add_f64_avx2(a, b, r, n);\n    return "
+    "add_f64_sse2(a, b, r, n);\n#endif\n    for (std::size_t i = 0; i < n; "
+    "i++)\n        r[i] = a[i] + b[i];\n}\n\ninline void mul_f64(const double "
+    "*a, const double *b, double *r, std::size_t n) {\n#ifdef LISP_X86\n    if "
+    "(has_avx2)\n        return mul_f64_avx2(a, b, r, n);\n    return "
+    "mul_f64_sse2(a, b, r, n);\n#endif\n    for (std::size_t i = 0; i < n; "
+    "i++)\n        r[i] = a[i] * b[i];\n}\n\n// add_i64 : returns false if any "
+    "element overflowed\ninline bool add_i64(const long long *a, const long "
+    "long *b, long long *r, std::size_t n) {\n#ifdef LISP_X86\n    if "
+    "(has_avx2)\n        return add_i64_avx2(a, b, r, n);\n#endif\n    bool ok "
+    "= true;\n    for (std::size_t i = 0; i < n; i++)\n        ok &= "
+    "!__builtin_add_overflow(a[i], b[i], r + i);\n    return ok;\n}\n\n// "
+    "mul_i64 : returns false if any element overflowed, there is no 64 bit\n// "
+    "vector multiply before avx-512\ninline bool mul_i64(const long long *a, "
+    "const long long *b, long long *r, std::size_t n) {\n    bool ok = true;\n "
+    "   for (std::size_t i = 0; i < n; i++)\n        ok &= "
+    "!__builtin_mul_overflow(a[i], b[i], r + i);\n    return ok;\n}\n\ninline "
+    "double dot_f64(const double *a, const double *b, std::size_t n) {\n#ifdef "
+    "LISP_X86\n    if (has_avx2)\n        return dot_f64_avx2(a, b, "
+    "n);\n#endif\n    double result = 0;\n    for (std::size_t i = 0; i < n; "
+    "i++)\n        result += a[i] * b[i];\n    return result;\n}\n\ninline "
+    "double sum_f64(const double *a, std::size_t n) {\n#ifdef LISP_X86\n    if "
+    "(has_avx2)\n        return sum_f64_avx2(a, n);\n#endif\n    double result "
+    "= 0;\n    for (std::size_t i = 0; i < n; i++)\n        result += a[i];\n  "
+    "  return result;\n}\n\n// sum_i64 : returns false if the sum "
+    "overflowed\ninline bool sum_i64(const long long *a, std::size_t n, long "
+    "long &result) {\n#ifdef LISP_X86\n    if (has_avx2)\n        return "
+    "sum_i64_avx2(a, n, result);\n#endif\n    bool ok = true;\n    result = "
+    "0;\n    for (std::size_t i = 0; i < n; i++)\n        ok &= "
+    "!__builtin_add_overflow(result, a[i], &result);\n    return "
+    "ok;\n}\n\ntemplate <bool Max> double extreme_f64(const double *a, "
+    "std::size_t n) {\n#ifdef LISP_X86\n    if (has_avx2)\n        return "
+    "extreme_f64_avx2<Max>(a, n);\n#endif\n    double result = a[0];\n    for "
+    "(std::size_t i = 1; i < n; i++)\n        result = Max ? std::max(result, "
+    "a[i]) : std::min(result, a[i]);\n    return result;\n}\n\ntemplate <bool "
+    "Max> long long extreme_i64(const long long *a, std::size_t n) {\n#ifdef "
+    "LISP_X86\n    if (has_avx2)\n        return extreme_i64_avx2<Max>(a, "
+    "n);\n#endif\n    long long result = a[0];\n    for (std::size_t i = 1; i "
+    "< n; i++)\n        result = Max ? std::max(result, a[i]) : "
+    "std::min(result, a[i]);\n    return result;\n}\n\n#pragma endregion "
+    "VectorKernels\n\n// lisp value functions\n#pragma region "
+    "ValueFunctions\n\n// symbol : get an interned symbol\nstruct "
+    "SymbolFunction final : public Expression {\n    explicit "
     "SymbolFunction(Args values) = delete;\n    ~SymbolFunction() override = "
-    "default;\n    explicit SymbolFunction(std::string atom)\n        : "
+    "default;\n    explicit SymbolFunction(Variable symbol)\n        : "
     "Expression(std::vector<std::shared_ptr<Expression>>()),\n          "
-    "_atom(std::move(atom)) {}\n    Variable operator()() const override {\n   "
-    "     if (!_values.empty())\n            throw "
-    "std::runtime_error(\"Invalid number of arguments\");\n        return "
-    "std::make_shared<Symbol>(_atom);\n    }\n    std::string _atom;\n};\n\n// "
-    "int : create an integer\nstruct IntFunction final : public Expression {\n "
-    "   explicit IntFunction(Args values) = delete;\n    ~IntFunction() "
-    "override = default;\n    explicit IntFunction(const int atom)\n        : "
-    "Expression(std::vector<std::shared_ptr<Expression>>()), _atom(atom) {}\n  "
-    "  Variable operator()() const override {\n        if (!_values.empty())\n "
-    "           throw std::runtime_error(\"Invalid number of arguments\");\n   "
-    "     return std::make_shared<Int>(_atom);\n    }\n    int "
-    "_atom;\n};\n\n// float : create a float\nstruct FloatFunction final : "
-    "public Expression {\n    explicit FloatFunction(Args values) = delete;\n  "
-    "  ~FloatFunction() override = default;\n    explicit FloatFunction(const "
-    "double atom)\n        : "
-    "Expression(std::vector<std::shared_ptr<Expression>>()), _atom(atom) {}\n  "
-    "  Variable operator()() const override {\n        if (!_values.empty())\n "
-    "           throw std::runtime_error(\"Invalid number of arguments\");\n   "
-    "     return std::make_shared<Float>(_atom);\n    }\n    double "
-    "_atom;\n};\n\n// string : create a string\nstruct StringFunction final : "
-    "public Expression {\n    explicit StringFunction(Args values) = delete;\n "
-    "   ~StringFunction() override = default;\n    explicit "
-    "StringFunction(std::string atom)\n        : "
+    "_symbol(std::move(symbol)) {}\n    Variable operator()() const override "
+    "{\n        return _symbol;\n    }\n    Variable _symbol;\n};\n\n// int : "
+    "an integer literal, created once, values are never modified while\n// "
+    "they are shared\nstruct IntFunction final : public Expression {\n    "
+    "explicit IntFunction(Args values) = delete;\n    ~IntFunction() override "
+    "= default;\n    explicit IntFunction(const long long atom)\n        : "
+    "Expression(std::vector<std::shared_ptr<Expression>>()), _atom(atom),\n    "
+    "      _value(std::make_shared<Int>(atom)) {}\n    Variable operator()() "
+    "const override {\n        return _value;\n    }\n    long long "
+    "as_fixnum() const override { return _atom; }\n    double as_double() "
+    "const override { return static_cast<double>(_atom); }\n    long long "
+    "_atom;\n    Variable _value;\n};\n\n// bigint : an integer literal that "
+    "does not fit in a fixnum, created once\nstruct BigIntFunction final : "
+    "public Expression {\n    explicit BigIntFunction(Args values) = delete;\n "
+    "   ~BigIntFunction() override = default;\n    explicit "
+    "BigIntFunction(const std::string &atom)\n        : "
     "Expression(std::vector<std::shared_ptr<Expression>>()),\n          "
-    "_atom(std::move(atom)) {}\n    Variable operator()() const override {\n   "
-    "     if (!_values.empty())\n            throw "
-    "std::runtime_error(\"Invalid number of arguments\");\n        return "
-    "std::make_shared<String>(_atom);\n    }\n    std::string _atom;\n};\n\n// "
-    "list : create a list\nstruct ListFunction final : public Expression {\n   "
-    " explicit ListFunction(Args values) : Expression(std::move(values)) {}\n  "
-    "  ~ListFunction() override = default;\n    Variable operator()() const "
-    "override {\n        std::vector<std::shared_ptr<Value>> result;\n        "
-    "for (const auto &v : _values)\n            "
-    "result.push_back(v->operator()());\n        return "
+    "_value(make_integer(BigInt::parse(atom))) {}\n    Variable operator()() "
+    "const override {\n        return _value;\n    }\n    Variable "
+    "_value;\n};\n\n// float : a float literal, created once\nstruct "
+    "FloatFunction final : public Expression {\n    explicit "
+    "FloatFunction(Args values) = delete;\n    ~FloatFunction() override = "
+    "default;\n    explicit FloatFunction(const double atom)\n        : "
+    "Expression(std::vector<std::shared_ptr<Expression>>()), _atom(atom),\n    "
+    "      _value(std::make_shared<Float>(atom)) {}\n    Variable operator()() "
+    "const override {\n        return _value;\n    }\n    double as_double() "
+    "const override { return _atom; }\n    double _atom;\n    Variable "
+    "_value;\n};\n\n// string : a string literal, created once\nstruct "
+    "StringFunction final : public Expression {\n    explicit "
+    "StringFunction(Args values) = delete;\n    ~StringFunction() override = "
+    "default;\n    explicit StringFunction(std::string atom)\n        : "
+    "Expression(std::vector<std::shared_ptr<Expression>>()),\n          "
+    "_value(std::make_shared<String>(std::move(atom))) {}\n    Variable "
+    "operator()() const override {\n        return _value;\n    }\n    "
+    "Variable _value;\n};\n\n// list : create a list\nstruct ListFunction "
+    "final : public Expression {\n    explicit ListFunction(Args values) : "
+    "Expression(std::move(values)) {}\n    ~ListFunction() override = "
+    "default;\n    Variable operator()() const override {\n        "
+    "std::vector<std::shared_ptr<Value>> result;\n        for (const auto &v : "
+    "_values)\n            result.push_back(v->operator()());\n        return "
     "std::make_shared<List>(result);\n    }\n};\n\n// quoted : create a quoted "
     "value\nstruct QuotedFunction final : public Expression {\n    explicit "
     "QuotedFunction(Args values) : Expression(std::move(values)) {}\n    "
     "~QuotedFunction() override = default;\n    Variable operator()() const "
-    "override {\n        if (_values.size() != 1)\n            throw "
-    "std::runtime_error(\"Invalid number of arguments\");\n        return "
-    "std::make_shared<Quoted>(_values[0]->operator()());\n    }\n};\n\n// t : "
-    "create a t value\nstruct TFunction final : public Expression {\n    "
-    "explicit TFunction(Args values) = delete;\n    ~TFunction() override = "
-    "default;\n    explicit TFunction()\n        : "
+    "override {\n        return "
+    "std::make_shared<Quoted>(_values[0]->operator()());\n    }\n};\n\n// "
+    "constant : a quoted list or a string hoisted by the generator, built "
+    "once\n// and shared by every use of an equal literal\nstruct Constant "
+    "final : public Expression {\n    explicit Constant(Args values) = "
+    "delete;\n    ~Constant() override = default;\n    explicit "
+    "Constant(Variable value)\n        : "
+    "Expression(std::vector<std::shared_ptr<Expression>>()),\n          "
+    "_value(std::move(value)) {}\n    Variable operator()() const override {\n "
+    "       return _value;\n    }\n    Variable _value;\n};\n\n// t : create a "
+    "t value\nstruct TFunction final : public Expression {\n    explicit "
+    "TFunction(Args values) = delete;\n    ~TFunction() override = default;\n  "
+    "  explicit TFunction()\n        : "
     "Expression(std::vector<std::shared_ptr<Expression>>()) {}\n    Variable "
-    "operator()() const override {\n        if (!_values.empty())\n            "
-    "throw std::runtime_error(\"Invalid number of arguments\");\n        "
-    "return std::make_shared<T>();\n    }\n};\n\n// nil : create a nil "
-    "value\nstruct NilFunction final : public Expression {\n    explicit "
-    "NilFunction(Args values) = delete;\n    ~NilFunction() override = "
-    "default;\n    explicit NilFunction()\n        : "
+    "operator()() const override {\n        return std::make_shared<T>();\n    "
+    "}\n};\n\n// nil : create a nil value\nstruct NilFunction final : public "
+    "Expression {\n    explicit NilFunction(Args values) = delete;\n    "
+    "~NilFunction() override = default;\n    explicit NilFunction()\n        : "
     "Expression(std::vector<std::shared_ptr<Expression>>()) {}\n    Variable "
-    "operator()() const override {\n        if (!_values.empty())\n            "
-    "throw std::runtime_error(\"Invalid number of arguments\");\n        "
-    "return std::make_shared<Nil>();\n    }\n};\n\n#pragma endregion "
-    "ValueFunctions\n\n// lisp numeric operations\n#pragma region "
-    "NumericOperations\n\n// + : add two numbers\nstruct Add final : public "
+    "operator()() const override {\n        return std::make_shared<Nil>();\n  "
+    "  }\n};\n\n#pragma endregion ValueFunctions\n\n// lisp numeric "
+    "operations\n#pragma region NumericOperations\n\n#include "
+    "<type_traits>\n\n// + : add two numbers\nstruct Add final : public "
     "Expression {\n    explicit Add(Args values) : "
     "Expression(std::move(values)) {}\n    ~Add() override = default;\n    "
-    "Variable operator()() const override {\n        if (_values.size() != "
-    "2)\n            throw std::runtime_error(\"Invalid number of "
-    "arguments\");\n        auto a = _values[0]->operator()();\n        auto b "
-    "= _values[1]->operator()();\n        if (a->_type == Type::Int && "
-    "b->_type == Type::Int)\n            return "
-    "std::make_shared<Int>(to_int(a)->_value + to_int(b)->_value);\n        if "
-    "(a->_type == Type::Float && b->_type == Type::Float)\n            return "
-    "std::make_shared<Float>(to_float(a)->_value + to_float(b)->_value);\n     "
-    "   if (a->_type == Type::Int && b->_type == Type::Float)\n            "
-    "return std::make_shared<Float>(to_int(a)->_value + "
-    "to_float(b)->_value);\n        if (a->_type == Type::Float && b->_type == "
-    "Type::Int)\n            return "
-    "std::make_shared<Float>(to_float(a)->_value + to_int(b)->_value);\n       "
-    " throw std::runtime_error(\"Invalid type for addition\");\n    "
+    "Variable operator()() const override {\n        PROFILE(\"+\");\n        "
+    "auto a = _values[0]->operator()();\n        auto b = "
+    "_values[1]->operator()();\n        long long result;\n        if "
+    "(a->_type == Type::Int && b->_type == Type::Int &&\n            "
+    "!__builtin_add_overflow(fixnum(a), fixnum(b), &result))\n            "
+    "return std::make_shared<Int>(result);\n        if (is_integer(a) && "
+    "is_integer(b))\n            return make_integer(to_bigint(a) + "
+    "to_bigint(b));\n        if (CHECKED(is_number(a) && is_number(b)))\n      "
+    "      return std::make_shared<Float>(to_double(a) + to_double(b));\n      "
+    "  throw std::runtime_error(\"Invalid type for addition\");\n    "
     "}\n};\n\n// - : subtract two numbers\nstruct Subtract final : public "
     "Expression {\n    explicit Subtract(Args values) : "
     "Expression(std::move(values)) {}\n    ~Subtract() override = default;\n   "
-    " Variable operator()() const override {\n        if (_values.size() != "
-    "2)\n            throw std::runtime_error(\"Invalid number of "
-    "arguments\");\n        auto a = _values[0]->operator()();\n        auto b "
-    "= _values[1]->operator()();\n        if (a->_type == Type::Int && "
-    "b->_type == Type::Int)\n            return "
-    "std::make_shared<Int>(to_int(a)->_value - to_int(b)->_value);\n        if "
-    "(a->_type == Type::Float && b->_type == Type::Float)\n            return "
-    "std::make_shared<Float>(to_float(a)->_value - to_float(b)->_value);\n     "
-    "   if (a->_type == Type::Int && b->_type == Type::Float)\n            "
-    "return std::make_shared<Float>(to_int(a)->_value - "
-    "to_float(b)->_value);\n        if (a->_type == Type::Float && b->_type == "
-    "Type::Int)\n            return "
-    "std::make_shared<Float>(to_float(a)->_value - to_int(b)->_value);\n       "
-    " throw std::runtime_error(\"Invalid type for subtraction\");\n    "
+    " Variable operator()() const override {\n        PROFILE(\"-\");\n        "
+    "auto a = _values[0]->operator()();\n        auto b = "
+    "_values[1]->operator()();\n        long long result;\n        if "
+    "(a->_type == Type::Int && b->_type == Type::Int &&\n            "
+    "!__builtin_sub_overflow(fixnum(a), fixnum(b), &result))\n            "
+    "return std::make_shared<Int>(result);\n        if (is_integer(a) && "
+    "is_integer(b))\n            return make_integer(to_bigint(a) - "
+    "to_bigint(b));\n        if (CHECKED(is_number(a) && is_number(b)))\n      "
+    "      return std::make_shared<Float>(to_double(a) - to_double(b));\n      "
+    "  throw std::runtime_error(\"Invalid type for subtraction\");\n    "
     "}\n};\n\n// * : multiply two numbers\nstruct Multiply final : public "
     "Expression {\n    explicit Multiply(Args values) : "
     "Expression(std::move(values)) {}\n    ~Multiply() override = default;\n   "
-    " Variable operator()() const override {\n        if (_values.size() != "
-    "2)\n            throw std::runtime_error(\"Invalid number of "
-    "arguments\");\n        auto a = _values[0]->operator()();\n        auto b "
-    "= _values[1]->operator()();\n        if (a->_type == Type::Int && "
-    "b->_type == Type::Int)\n            return "
-    "std::make_shared<Int>(to_int(a)->_value * to_int(b)->_value);\n        if "
-    "(a->_type == Type::Float && b->_type == Type::Float)\n            return "
-    "std::make_shared<Float>(to_float(a)->_value * to_float(b)->_value);\n     "
-    "   if (a->_type == Type::Int && b->_type == Type::Float)\n            "
-    "return std::make_shared<Float>(to_int(a)->_value * "
-    "to_float(b)->_value);\n        if (a->_type == Type::Float && b->_type == "
-    "Type::Int)\n            return "
-    "std::make_shared<Float>(to_float(a)->_value * to_int(b)->_value);\n       "
-    " throw std::runtime_error(\"Invalid type for multiplication\");\n    "
+    " Variable operator()() const override {\n        PROFILE(\"*\");\n        "
+    "auto a = _values[0]->operator()();\n        auto b = "
+    "_values[1]->operator()();\n        long long result;\n        if "
+    "(a->_type == Type::Int && b->_type == Type::Int &&\n            "
+    "!__builtin_mul_overflow(fixnum(a), fixnum(b), &result))\n            "
+    "return std::make_shared<Int>(result);\n        if (is_integer(a) && "
+    "is_integer(b))\n            return make_integer(to_bigint(a) * "
+    "to_bigint(b));\n        if (CHECKED(is_number(a) && is_number(b)))\n      "
+    "      return std::make_shared<Float>(to_double(a) * to_double(b));\n      "
+    "  throw std::runtime_error(\"Invalid type for multiplication\");\n    "
     "}\n};\n\n// / : divide two numbers\nstruct Divide final : public "
     "Expression {\n    explicit Divide(Args values) : "
     "Expression(std::move(values)) {}\n    ~Divide() override = default;\n    "
-    "Variable operator()() const override {\n        if (_values.size() != "
-    "2)\n            throw std::runtime_error(\"Invalid number of "
-    "arguments\");\n        auto a = _values[0]->operator()();\n        auto b "
-    "= _values[1]->operator()();\n        if (a->_type == Type::Int && "
-    "b->_type == Type::Int) {\n            if (to_int(b)->_value == 0)\n       "
-    "         throw std::runtime_error(\"Division by zero\");\n            if "
-    "(to_int(a)->_value % to_int(b)->_value == 0)\n                return "
-    "std::make_shared<Int>(to_int(a)->_value / to_int(b)->_value);\n           "
-    " return std::make_shared<Float>(static_cast<double>(to_int(a)->_value) "
-    "/\n                                           to_int(b)->_value);\n       "
-    " }\n        if (a->_type == Type::Float && b->_type == Type::Float)\n     "
-    "       return std::make_shared<Float>(to_float(a)->_value / "
-    "to_float(b)->_value);\n        if (a->_type == Type::Int && b->_type == "
-    "Type::Float)\n            return "
-    "std::make_shared<Float>(static_cast<double>(to_int(a)->_value) /\n        "
-    "                                   to_float(b)->_value);\n        if "
-    "(a->_type == Type::Float && b->_type == Type::Int)\n            return "
-    "std::make_shared<Float>(to_float(a)->_value / to_int(b)->_value);\n       "
-    " throw std::runtime_error(\"Invalid type for division\");\n    "
-    "}\n};\n\n// < : less than\nstruct Less final : public Expression {\n    "
-    "explicit Less(Args values) : Expression(std::move(values)) {}\n    "
-    "~Less() override = default;\n    Variable operator()() const override {\n "
-    "       if (_values.size() != 2)\n            throw "
-    "std::runtime_error(\"Invalid number of arguments\");\n        auto a = "
-    "_values[0]->operator()();\n        auto b = _values[1]->operator()();\n   "
-    "     if (a->_type == Type::Int && b->_type == Type::Int)\n            "
-    "return to_t_or_nil(to_int(a)->_value < to_int(b)->_value);\n        if "
-    "(a->_type == Type::Float && b->_type == Type::Float)\n            return "
-    "to_t_or_nil(to_float(a)->_value < to_float(b)->_value);\n        if "
-    "(a->_type == Type::Int && b->_type == Type::Float)\n            return "
-    "to_t_or_nil(to_int(a)->_value < to_float(b)->_value);\n        if "
-    "(a->_type == Type::Float && b->_type == Type::Int)\n            return "
-    "to_t_or_nil(to_float(a)->_value < to_int(b)->_value);\n        throw "
+    "Variable operator()() const override {\n        PROFILE(\"/\");\n        "
+    "auto a = _values[0]->operator()();\n        auto b = "
+    "_values[1]->operator()();\n        if (a->_type == Type::Int && b->_type "
+    "== Type::Int &&\n            !(fixnum(a) == LLONG_MIN && fixnum(b) == "
+    "-1)) {\n            if (fixnum(b) == 0)\n                throw "
+    "std::runtime_error(\"Division by zero\");\n            if (fixnum(a) % "
+    "fixnum(b) == 0)\n                return std::make_shared<Int>(fixnum(a) / "
+    "fixnum(b));\n            return "
+    "std::make_shared<Float>(static_cast<double>(fixnum(a)) /\n                "
+    "                           fixnum(b));\n        }\n        if "
+    "(is_integer(a) && is_integer(b)) {\n            BigInt quotient, "
+    "remainder;\n            BigInt::divmod(to_bigint(a), to_bigint(b), "
+    "quotient, remainder);\n            if (remainder.is_zero())\n             "
+    "   return make_integer(std::move(quotient));\n            return "
+    "std::make_shared<Float>(to_double(a) / to_double(b));\n        }\n        "
+    "if (CHECKED(is_number(a) && is_number(b)))\n            return "
+    "std::make_shared<Float>(to_double(a) / to_double(b));\n        throw "
+    "std::runtime_error(\"Invalid type for division\");\n    }\n};\n\n// < : "
+    "less than\nstruct Less final : public Expression {\n    explicit "
+    "Less(Args values) : Expression(std::move(values)) {}\n    ~Less() "
+    "override = default;\n    Variable operator()() const override {\n        "
+    "PROFILE(\"<\");\n        auto a = _values[0]->operator()();\n        auto "
+    "b = _values[1]->operator()();\n        if (a->_type == Type::Int && "
+    "b->_type == Type::Int)\n            return to_t_or_nil(fixnum(a) < "
+    "fixnum(b));\n        if (is_integer(a) && is_integer(b))\n            "
+    "return to_t_or_nil(BigInt::compare(to_bigint(a), to_bigint(b)) < 0);\n    "
+    "    if (CHECKED(is_number(a) && is_number(b)))\n            return "
+    "to_t_or_nil(to_double(a) < to_double(b));\n        throw "
     "std::runtime_error(\"Invalid type for less than\");\n    }\n};\n\n// > : "
     "greater than\nstruct Greater final : public Expression {\n    explicit "
     "Greater(Args values) : Expression(std::move(values)) {}\n    ~Greater() "
     "override = default;\n    Variable operator()() const override {\n        "
-    "if (_values.size() != 2)\n            throw std::runtime_error(\"Invalid "
-    "number of arguments\");\n        auto a = _values[0]->operator()();\n     "
-    "   auto b = _values[1]->operator()();\n        if (a->_type == Type::Int "
-    "&& b->_type == Type::Int)\n            return "
-    "to_t_or_nil(to_int(a)->_value > to_int(b)->_value);\n        if (a->_type "
-    "== Type::Float && b->_type == Type::Float)\n            return "
-    "to_t_or_nil(to_float(a)->_value > to_float(b)->_value);\n        if "
-    "(a->_type == Type::Int && b->_type == Type::Float)\n            return "
-    "to_t_or_nil(to_int(a)->_value > to_float(b)->_value);\n        if "
-    "(a->_type == Type::Float && b->_type == Type::Int)\n            return "
-    "to_t_or_nil(to_float(a)->_value > to_int(b)->_value);\n        throw "
+    "PROFILE(\">\");\n        auto a = _values[0]->operator()();\n        auto "
+    "b = _values[1]->operator()();\n        if (a->_type == Type::Int && "
+    "b->_type == Type::Int)\n            return to_t_or_nil(fixnum(a) > "
+    "fixnum(b));\n        if (is_integer(a) && is_integer(b))\n            "
+    "return to_t_or_nil(BigInt::compare(to_bigint(a), to_bigint(b)) > 0);\n    "
+    "    if (CHECKED(is_number(a) && is_number(b)))\n            return "
+    "to_t_or_nil(to_double(a) > to_double(b));\n        throw "
     "std::runtime_error(\"Invalid type for greater than\");\n    }\n};\n\n// "
     ">= : greater than or equal\nstruct GreaterEqual final : public Expression "
     "{\n    explicit GreaterEqual(Args values) : Expression(std::move(values)) "
     "{}\n    ~GreaterEqual() override = default;\n    Variable operator()() "
-    "const override {\n        if (_values.size() != 2)\n            throw "
-    "std::runtime_error(\"Invalid number of arguments\");\n        auto a = "
+    "const override {\n        PROFILE(\">=\");\n        auto a = "
     "_values[0]->operator()();\n        auto b = _values[1]->operator()();\n   "
     "     if (a->_type == Type::Int && b->_type == Type::Int)\n            "
-    "return to_t_or_nil(to_int(a)->_value >= to_int(b)->_value);\n        if "
-    "(a->_type == Type::Float && b->_type == Type::Float)\n            return "
-    "to_t_or_nil(to_float(a)->_value >= to_float(b)->_value);\n        if "
-    "(a->_type == Type::Int && b->_type == Type::Float)\n            return "
-    "to_t_or_nil(to_int(a)->_value >= to_float(b)->_value);\n        if "
-    "(a->_type == Type::Float && b->_type == Type::Int)\n            return "
-    "to_t_or_nil(to_float(a)->_value >= to_int(b)->_value);\n        throw "
+    "return to_t_or_nil(fixnum(a) >= fixnum(b));\n        if (is_integer(a) && "
+    "is_integer(b))\n            return "
+    "to_t_or_nil(BigInt::compare(to_bigint(a), to_bigint(b)) >= 0);\n        "
+    "if (CHECKED(is_number(a) && is_number(b)))\n            return "
+    "to_t_or_nil(to_double(a) >= to_double(b));\n        throw "
     "std::runtime_error(\"Invalid type for greater than or equal\");\n    "
     "}\n};\n\n// <= : less than or equal\nstruct LessEqual final : public "
     "Expression {\n    explicit LessEqual(Args values) : "
     "Expression(std::move(values)) {}\n    ~LessEqual() override = default;\n  "
-    "  Variable operator()() const override {\n        if (_values.size() != "
-    "2)\n            throw std::runtime_error(\"Invalid number of "
-    "arguments\");\n        auto a = _values[0]->operator()();\n        auto b "
-    "= _values[1]->operator()();\n        if (a->_type == Type::Int && "
-    "b->_type == Type::Int)\n            return to_t_or_nil(to_int(a)->_value "
-    "<= to_int(b)->_value);\n        if (a->_type == Type::Float && b->_type "
-    "== Type::Float)\n            return to_t_or_nil(to_float(a)->_value <= "
-    "to_float(b)->_value);\n        if (a->_type == Type::Int && b->_type == "
-    "Type::Float)\n            return to_t_or_nil(to_int(a)->_value <= "
-    "to_float(b)->_value);\n        if (a->_type == Type::Float && b->_type == "
-    "Type::Int)\n            return to_t_or_nil(to_float(a)->_value <= "
-    "to_int(b)->_value);\n        throw std::runtime_error(\"Invalid type for "
-    "less than or equal\");\n    }\n};\n\n// = : equal\nstruct Equal final : "
-    "public Expression {\n    explicit Equal(Args values) : "
-    "Expression(std::move(values)) {}\n    ~Equal() override = default;\n    "
-    "Variable operator()() const override {\n        if (_values.size() != "
-    "2)\n            throw std::runtime_error(\"Invalid number of "
-    "arguments\");\n        auto a = _values[0]->operator()();\n        auto b "
-    "= _values[1]->operator()();\n        if (a->_type == Type::Int && "
-    "b->_type == Type::Int)\n            return to_t_or_nil(to_int(a)->_value "
-    "== to_int(b)->_value);\n        if (a->_type == Type::Float && b->_type "
-    "== Type::Float)\n            return to_t_or_nil(to_float(a)->_value == "
-    "to_float(b)->_value);\n        if (a->_type == Type::Int && b->_type == "
-    "Type::Float)\n            return to_t_or_nil(to_int(a)->_value == "
-    "to_float(b)->_value);\n        if (a->_type == Type::Float && b->_type == "
-    "Type::Int)\n            return to_t_or_nil(to_float(a)->_value == "
-    "to_int(b)->_value);\n        throw std::runtime_error(\"Invalid type for "
-    "equal\");\n    }\n};\n\n// /= : not equal\nstruct NotEqual final : public "
-    "Expression {\n    explicit NotEqual(Args values) : "
-    "Expression(std::move(values)) {}\n    ~NotEqual() override = default;\n   "
-    " Variable operator()() const override {\n        if (_values.size() != "
-    "2)\n            throw std::runtime_error(\"Invalid number of "
-    "arguments\");\n        auto a = _values[0]->operator()();\n        auto b "
-    "= _values[1]->operator()();\n        if (a->_type == Type::Int && "
-    "b->_type == Type::Int)\n            return to_t_or_nil(to_int(a)->_value "
-    "!= to_int(b)->_value);\n        if (a->_type == Type::Float && b->_type "
-    "== Type::Float)\n            return to_t_or_nil(to_float(a)->_value != "
-    "to_float(b)->_value);\n        if (a->_type == Type::Int && b->_type == "
-    "Type::Float)\n            return to_t_or_nil(to_int(a)->_value != "
-    "to_float(b)->_value);\n        if (a->_type == Type::Float && b->_type == "
-    "Type::Int)\n            return to_t_or_nil(to_float(a)->_value != "
-    "to_int(b)->_value);\n        throw std::runtime_error(\"Invalid type for "
-    "not equal\");\n    }\n};\n\n#pragma endregion NumericOperations\n\n// "
-    "lisp logical operations\n#pragma region LogicalOperations\n\n// null : "
-    "check if a value is nil\nstruct Null final : public Expression {\n    "
-    "explicit Null(Args values) : Expression(std::move(values)) {}\n    "
-    "~Null() override = default;\n    Variable operator()() const override {\n "
-    "       if (_values.size() != 1)\n            throw "
-    "std::runtime_error(\"Invalid number of arguments\");\n        return "
-    "to_t_or_nil(_values[0]->operator()()->_type == Type::Nil);\n    "
-    "}\n};\n\n// not : check if a value is not nil\nstruct Not final : public "
-    "Expression {\n    explicit Not(Args values) : "
-    "Expression(std::move(values)) {}\n    ~Not() override = default;\n    "
-    "Variable operator()() const override {\n        if (_values.size() != "
-    "1)\n            throw std::runtime_error(\"Invalid number of "
-    "arguments\");\n        return to_t_or_nil(_values[0]->operator()()->_type "
-    "== Type::Nil);\n    }\n};\n\n// if : conditional expression\nstruct If "
-    "final : public Expression {\n    explicit If(Args values) : "
-    "Expression(std::move(values)) {}\n    ~If() override = default;\n    "
-    "Variable operator()() const override {\n        if (_values.size() != "
-    "3)\n            throw std::runtime_error(\"Invalid number of "
-    "arguments\");\n        auto condition = _values[0]->operator()();\n       "
-    " if (condition->_type == Type::Nil ||\n            (condition->_type == "
-    "Type::Int && to_int(condition)->_value == 0) ||\n            "
-    "(condition->_type == Type::Float && to_float(condition)->_value == 0))\n  "
-    "          return _values[2]->operator()();\n        return "
-    "_values[1]->operator()();\n    }\n};\n\n#pragma endregion "
+    "  Variable operator()() const override {\n        PROFILE(\"<=\");\n      "
+    "  auto a = _values[0]->operator()();\n        auto b = "
+    "_values[1]->operator()();\n        if (a->_type == Type::Int && b->_type "
+    "== Type::Int)\n            return to_t_or_nil(fixnum(a) <= fixnum(b));\n  "
+    "      if (is_integer(a) && is_integer(b))\n            return "
+    "to_t_or_nil(BigInt::compare(to_bigint(a), to_bigint(b)) <= 0);\n        "
+    "if (CHECKED(is_number(a) && is_number(b)))\n            return "
+    "to_t_or_nil(to_double(a) <= to_double(b));\n        throw "
+    "std::runtime_error(\"Invalid type for less than or equal\");\n    "
+    "}\n};\n\n// = : equal\nstruct Equal final : public Expression {\n    "
+    "explicit Equal(Args values) : Expression(std::move(values)) {}\n    "
+    "~Equal() override = default;\n    Variable operator()() const override "
+    "{\n        PROFILE(\"=\");\n        auto a = _values[0]->operator()();\n  "
+    "      auto b = _values[1]->operator()();\n        if (a->_type == "
+    "Type::Int && b->_type == Type::Int)\n            return "
+    "to_t_or_nil(fixnum(a) == fixnum(b));\n        if (is_integer(a) && "
+    "is_integer(b))\n            return "
+    "to_t_or_nil(BigInt::compare(to_bigint(a), to_bigint(b)) == 0);\n        "
+    "if (CHECKED(is_number(a) && is_number(b)))\n            return "
+    "to_t_or_nil(to_double(a) == to_double(b));\n        throw "
+    "std::runtime_error(\"Invalid type for equal\");\n    }\n};\n\n// /= : not "
+    "equal\nstruct NotEqual final : public Expression {\n    explicit "
+    "NotEqual(Args values) : Expression(std::move(values)) {}\n    ~NotEqual() "
+    "override = default;\n    Variable operator()() const override {\n        "
+    "PROFILE(\"/=\");\n        auto a = _values[0]->operator()();\n        "
+    "auto b = _values[1]->operator()();\n        if (a->_type == Type::Int && "
+    "b->_type == Type::Int)\n            return to_t_or_nil(fixnum(a) != "
+    "fixnum(b));\n        if (is_integer(a) && is_integer(b))\n            "
+    "return to_t_or_nil(BigInt::compare(to_bigint(a), to_bigint(b)) != 0);\n   "
+    "     if (CHECKED(is_number(a) && is_number(b)))\n            return "
+    "to_t_or_nil(to_double(a) != to_double(b));\n        throw "
+    "std::runtime_error(\"Invalid type for not equal\");\n    }\n};\n\n// the "
+    "operations below have operands the generator proved to be fixnums or\n// "
+    "double-floats from the type declarations, so they never box "
+    "them\n\nstruct AddOp {\n    static constexpr const char *name = \"+\";\n  "
+    "  static bool fixnum(long long a, long long b, long long &r) {\n        "
+    "return !__builtin_add_overflow(a, b, &r);\n    }\n    static BigInt "
+    "bignum(const BigInt &a, const BigInt &b) { return a + b; }\n    static "
+    "double real(double a, double b) { return a + b; }\n};\n\nstruct "
+    "SubtractOp {\n    static constexpr const char *name = \"-\";\n    static "
+    "bool fixnum(long long a, long long b, long long &r) {\n        return "
+    "!__builtin_sub_overflow(a, b, &r);\n    }\n    static BigInt bignum(const "
+    "BigInt &a, const BigInt &b) { return a - b; }\n    static double "
+    "real(double a, double b) { return a - b; }\n};\n\nstruct MultiplyOp {\n   "
+    " static constexpr const char *name = \"*\";\n    static bool fixnum(long "
+    "long a, long long b, long long &r) {\n        return "
+    "!__builtin_mul_overflow(a, b, &r);\n    }\n    static BigInt bignum(const "
+    "BigInt &a, const BigInt &b) { return a * b; }\n    static double "
+    "real(double a, double b) { return a * b; }\n};\n\nstruct DivideOp {\n    "
+    "static constexpr const char *name = \"/\";\n    static double real(double "
+    "a, double b) { return a / b; }\n};\n\n// fixnum arithmetic : a boxed "
+    "result grows to a bignum on overflow, an\n// unboxed one must stay a "
+    "fixnum and wraps around when the safety is 0\ntemplate <typename Op> "
+    "struct FixnumArithmetic final : public Expression {\n    explicit "
+    "FixnumArithmetic(Args values) : Expression(std::move(values)) {}\n    "
+    "~FixnumArithmetic() override = default;\n    Variable operator()() const "
+    "override {\n        PROFILE(Op::name);\n        const long long a = "
+    "_values[0]->as_fixnum(), b = _values[1]->as_fixnum();\n        long long "
+    "result;\n        if (Op::fixnum(a, b, result))\n            return "
+    "std::make_shared<Int>(result);\n        return "
+    "make_integer(Op::bignum(BigInt(a), BigInt(b)));\n    }\n    long long "
+    "as_fixnum() const override {\n        PROFILE(Op::name);\n        long "
+    "long result;\n        const bool fits =\n            "
+    "Op::fixnum(_values[0]->as_fixnum(), _values[1]->as_fixnum(), result);\n   "
+    "     if (CHECKED(fits))\n            return result;\n        throw "
+    "std::runtime_error(\"Fixnum overflow\");\n    }\n    double as_double() "
+    "const override {\n        return static_cast<double>(as_fixnum());\n    "
+    "}\n    bool as_bool() const override { return as_fixnum() != 0; "
+    "}\n};\n\n// double arithmetic : arithmetic on double-floats\ntemplate "
+    "<typename Op> struct DoubleArithmetic final : public Expression {\n    "
+    "explicit DoubleArithmetic(Args values) : Expression(std::move(values)) "
+    "{}\n    ~DoubleArithmetic() override = default;\n    Variable "
+    "operator()() const override {\n        return "
+    "std::make_shared<Float>(as_double());\n    }\n    double as_double() "
+    "const override {\n        PROFILE(Op::name);\n        return "
+    "Op::real(_values[0]->as_double(), _values[1]->as_double());\n    }\n    "
+    "bool as_bool() const override { return as_double() != 0; }\n};\n\nusing "
+    "FixnumAdd = FixnumArithmetic<AddOp>;\nusing FixnumSubtract = "
+    "FixnumArithmetic<SubtractOp>;\nusing FixnumMultiply = "
+    "FixnumArithmetic<MultiplyOp>;\nusing DoubleAdd = "
+    "DoubleArithmetic<AddOp>;\nusing DoubleSubtract = "
+    "DoubleArithmetic<SubtractOp>;\nusing DoubleMultiply = "
+    "DoubleArithmetic<MultiplyOp>;\nusing DoubleDivide = "
+    "DoubleArithmetic<DivideOp>;\n\nstruct LessOp {\n    static constexpr "
+    "const char *name = \"<\";\n    template <typename N> static bool test(N "
+    "a, N b) { return a < b; }\n};\n\nstruct GreaterOp {\n    static constexpr "
+    "const char *name = \">\";\n    template <typename N> static bool test(N "
+    "a, N b) { return a > b; }\n};\n\nstruct LessEqualOp {\n    static "
+    "constexpr const char *name = \"<=\";\n    template <typename N> static "
+    "bool test(N a, N b) { return a <= b; }\n};\n\nstruct GreaterEqualOp {\n   "
+    " static constexpr const char *name = \">=\";\n    template <typename N> "
+    "static bool test(N a, N b) { return a >= b; }\n};\n\nstruct EqualOp {\n   "
+    " static constexpr const char *name = \"=\";\n    template <typename N> "
+    "static bool test(N a, N b) { return a == b; }\n};\n\nstruct NotEqualOp "
+    "{\n    static constexpr const char *name = \"/=\";\n    template "
+    "<typename N> static bool test(N a, N b) { return a != b; }\n};\n\n// "
+    "typed comparison : compare two fixnums or two double-floats\ntemplate "
+    "<typename Op, typename N> struct TypedComparison final : public "
+    "Expression {\n    explicit TypedComparison(Args values) : "
+    "Expression(std::move(values)) {}\n    ~TypedComparison() override = "
+    "default;\n    Variable operator()() const override { return "
+    "to_t_or_nil(as_bool()); }\n    bool as_bool() const override {\n        "
+    "PROFILE(Op::name);\n        if constexpr (std::is_same_v<N, double>)\n    "
+    "        return Op::test(_values[0]->as_double(), "
+    "_values[1]->as_double());\n        else\n            return "
+    "Op::test(_values[0]->as_fixnum(), _values[1]->as_fixnum());\n    "
+    "}\n};\n\nusing FixnumLess = TypedComparison<LessOp, long long>;\nusing "
+    "FixnumGreater = TypedComparison<GreaterOp, long long>;\nusing "
+    "FixnumLessEqual = TypedComparison<LessEqualOp, long long>;\nusing "
+    "FixnumGreaterEqual = TypedComparison<GreaterEqualOp, long long>;\nusing "
+    "FixnumEqual = TypedComparison<EqualOp, long long>;\nusing FixnumNotEqual "
+    "= TypedComparison<NotEqualOp, long long>;\nusing DoubleLess = "
+    "TypedComparison<LessOp, double>;\nusing DoubleGreater = "
+    "TypedComparison<GreaterOp, double>;\nusing DoubleLessEqual = "
+    "TypedComparison<LessEqualOp, double>;\nusing DoubleGreaterEqual = "
+    "TypedComparison<GreaterEqualOp, double>;\nusing DoubleEqual = "
+    "TypedComparison<EqualOp, double>;\nusing DoubleNotEqual = "
+    "TypedComparison<NotEqualOp, double>;\n\n// the : check a value against a "
+    "type declaration, the generator only emits\n// the checks that are not "
+    "known to hold\nstruct TheFixnum final : public Expression {\n    explicit "
+    "TheFixnum(Args values) : Expression(std::move(values)) {}\n    "
+    "~TheFixnum() override = default;\n    Variable operator()() const "
+    "override {\n        auto value = _values[0]->operator()();\n        auto "
+    "discard = unbox_fixnum(value);\n        return value;\n    }\n    long "
+    "long as_fixnum() const override { return _values[0]->as_fixnum(); }\n    "
+    "double as_double() const override {\n        return "
+    "static_cast<double>(_values[0]->as_fixnum());\n    }\n};\n\nstruct "
+    "TheDouble final : public Expression {\n    explicit TheDouble(Args "
+    "values) : Expression(std::move(values)) {}\n    ~TheDouble() override = "
+    "default;\n    Variable operator()() const override {\n        auto value "
+    "= _values[0]->operator()();\n        auto discard = "
+    "unbox_double(value);\n        return value;\n    }\n    double "
+    "as_double() const override { return _values[0]->as_double(); "
+    "}\n};\n\n#pragma endregion NumericOperations\n\n// lisp logical "
+    "operations\n#pragma region LogicalOperations\n\n// null : check if a "
+    "value is nil\nstruct Null final : public Expression {\n    explicit "
+    "Null(Args values) : Expression(std::move(values)) {}\n    ~Null() "
+    "override = default;\n    Variable operator()() const override {\n        "
+    "PROFILE(\"null\");\n        return "
+    "to_t_or_nil(_values[0]->operator()()->_type == Type::Nil);\n    }\n    "
+    "bool as_bool() const override {\n        PROFILE(\"null\");\n        "
+    "return _values[0]->operator()()->_type == Type::Nil;\n    }\n};\n\n// not "
+    ": check if a value is not nil\nstruct Not final : public Expression {\n   "
+    " explicit Not(Args values) : Expression(std::move(values)) {}\n    ~Not() "
+    "override = default;\n    Variable operator()() const override {\n        "
+    "PROFILE(\"not\");\n        return "
+    "to_t_or_nil(_values[0]->operator()()->_type == Type::Nil);\n    }\n    "
+    "bool as_bool() const override {\n        PROFILE(\"not\");\n        "
+    "return _values[0]->operator()()->_type == Type::Nil;\n    }\n};\n\n// if "
+    ": conditional expression\nstruct If final : public Expression {\n    "
+    "explicit If(Args values) : Expression(std::move(values)) {}\n    ~If() "
+    "override = default;\n    Variable operator()() const override {\n        "
+    "return branch()->operator()();\n    }\n    long long as_fixnum() const "
+    "override { return branch()->as_fixnum(); }\n    double as_double() const "
+    "override { return branch()->as_double(); }\n    bool as_bool() const "
+    "override { return branch()->as_bool(); }\n    void execute() const "
+    "override { branch()->execute(); }\n    const Function &branch() const {\n "
+    "       return _values[0]->as_bool() ? _values[1] : _values[2];\n    "
+    "}\n};\n\n// eq : check if two values are the same object; fixnums, t and "
+    "nil are\n// compared by value because they are immediate in other "
+    "lisps\nstruct Eq final : public Expression {\n    explicit Eq(Args "
+    "values) : Expression(std::move(values)) {}\n    ~Eq() override = "
+    "default;\n    Variable operator()() const override {\n        "
+    "PROFILE(\"eq\");\n        const auto a = _values[0]->operator()(), b = "
+    "_values[1]->operator()();\n        if (a == b)\n            return "
+    "to_t_or_nil(true);\n        if (a->_type != b->_type)\n            return "
+    "to_t_or_nil(false);\n        switch (a->_type) {\n        case "
+    "Type::Int:\n            return to_t_or_nil(fixnum(a) == fixnum(b));\n     "
+    "   case Type::T:\n        case Type::Nil:\n            return "
+    "to_t_or_nil(true);\n        default:\n            return "
+    "to_t_or_nil(false);\n        }\n    }\n};\n\n#pragma endregion "
     "LogicalOperations\n\n// lisp list operations\n#pragma region "
     "ListOperations\n\n// car : get the first element of a list\nstruct Car "
     "final : public Expression {\n    explicit Car(Args values) : "
     "Expression(std::move(values)) {}\n    ~Car() override = default;\n    "
-    "Variable operator()() const override {\n        if (_values.size() != "
-    "1)\n            throw std::runtime_error(\"Invalid number of "
-    "arguments\");\n        return "
-    "to_list(_values[0]->operator()())->_value[0];\n    }\n};\n\n// cdr : get "
-    "the rest of the elements of a list\nstruct Cdr final : public Expression "
-    "{\n    explicit Cdr(Args values) : Expression(std::move(values)) {}\n    "
-    "~Cdr() override = default;\n    Variable operator()() const override {\n  "
-    "      if (_values.size() != 1)\n            throw "
-    "std::runtime_error(\"Invalid number of arguments\");\n        auto list = "
-    "to_list(_values[0]->operator()());\n        if (list->_value.size() < "
-    "2)\n            return std::make_shared<Nil>();\n        return "
+    "Variable operator()() const override {\n        PROFILE(\"car\");\n       "
+    " return to_list(_values[0]->operator()())->_value[0];\n    }\n};\n\n// "
+    "cdr : get the rest of the elements of a list\nstruct Cdr final : public "
+    "Expression {\n    explicit Cdr(Args values) : "
+    "Expression(std::move(values)) {}\n    ~Cdr() override = default;\n    "
+    "Variable operator()() const override {\n        PROFILE(\"cdr\");\n       "
+    " auto list = to_list(_values[0]->operator()());\n        if "
+    "(list->_value.size() < 2)\n            return std::make_shared<Nil>();\n  "
+    "      return "
     "std::make_shared<List>(std::vector<std::shared_ptr<Value>>(\n            "
     "list->_value.begin() + 1, list->_value.end()));\n    }\n};\n\n// cons : "
     "add an element to the front of a list\nstruct Cons final : public "
     "Expression {\n    explicit Cons(Args values) : "
     "Expression(std::move(values)) {}\n    ~Cons() override = default;\n    "
-    "Variable operator()() const override {\n        if (_values.size() != "
-    "2)\n            throw std::runtime_error(\"Invalid number of "
-    "arguments\");\n        auto value = _values[0]->operator()();\n        "
-    "auto list = to_list(_values[1]->operator()());\n        "
-    "list->_value.insert(list->_value.begin(), value);\n        return list;\n "
-    "   }\n};\n\n// list : create a list\nstruct List_ final : public "
-    "Expression {\n    explicit List_(Args values) : "
-    "Expression(std::move(values)) {}\n    ~List_() override = default;\n    "
-    "Variable operator()() const override {\n        "
-    "std::vector<std::shared_ptr<Value>> result;\n        for (const auto &v : "
-    "_values)\n            result.push_back(v->operator()());\n        return "
-    "std::make_shared<List>(result);\n    }\n};\n\n#pragma endregion "
-    "ListOperations\n\n// lisp runtime environment\n#pragma region "
-    "RuntimeEnvironment\n\n// print : print a value\nstruct Print final : "
-    "public Expression {\n    explicit Print(Args values) : "
-    "Expression(std::move(values)) {}\n    ~Print() override = default;\n    "
-    "Variable operator()() const override {\n        if (_values.size() != "
-    "1)\n            throw std::runtime_error(\"Invalid number of "
-    "arguments\");\n        auto value = _values[0]->operator()();\n        "
-    "std::cout << value->get() << std::endl;\n        return value;\n    "
-    "}\n};\n\n// progn : evaluate multiple expressions\nstruct Progn final : "
-    "public Expression {\n    explicit Progn(Args values) : "
+    "Variable operator()() const override {\n        PROFILE(\"cons\");\n      "
+    "  auto value = _values[0]->operator()();\n        auto list = "
+    "to_list(_values[1]->operator()());\n        "
+    "std::vector<std::shared_ptr<Value>> result;\n        "
+    "result.reserve(list->_value.size() + 1);\n        "
+    "result.push_back(std::move(value));\n        result.insert(result.end(), "
+    "list->_value.begin(), list->_value.end());\n        return "
+    "std::make_shared<List>(std::move(result));\n    }\n};\n\n// list : create "
+    "a list\nstruct List_ final : public Expression {\n    explicit List_(Args "
+    "values) : Expression(std::move(values)) {}\n    ~List_() override = "
+    "default;\n    Variable operator()() const override {\n        "
+    "PROFILE(\"list\");\n        std::vector<std::shared_ptr<Value>> result;\n "
+    "       for (const auto &v : _values)\n            "
+    "result.push_back(v->operator()());\n        return "
+    "std::make_shared<List>(result);\n    }\n};\n\n// mapcar : apply a "
+    "function to the elements of lists, up to the shortest\nstruct Mapcar "
+    "final : public Expression {\n    explicit Mapcar(Args values) : "
+    "Expression(std::move(values)) {}\n    ~Mapcar() override = default;\n    "
+    "Variable operator()() const override {\n        PROFILE(\"mapcar\");\n    "
+    "    auto f = _values[0]->operator()();\n        "
+    "std::vector<std::shared_ptr<List>> lists;\n        std::size_t size = "
+    "SIZE_MAX;\n        for (std::size_t i = 1; i < _values.size(); i++) {\n   "
+    "         lists.push_back(to_list(_values[i]->operator()()));\n            "
+    "size = std::min(size, lists.back()->_value.size());\n        }\n        "
+    "std::vector<Variable> args(lists.size()), result;\n        "
+    "result.reserve(size);\n        for (std::size_t i = 0; i < size; i++) {\n "
+    "           for (std::size_t j = 0; j < lists.size(); j++)\n               "
+    " args[j] = lists[j]->_value[i];\n            result.push_back(call(f, "
+    "args.data(), args.size()));\n        }\n        return "
+    "make_list(std::move(result));\n    }\n};\n\n// reduce : combine the "
+    "elements of a list or a vector with a function\nstruct Reduce final : "
+    "public Expression {\n    explicit Reduce(Args values) : "
+    "Expression(std::move(values)) {}\n    ~Reduce() override = default;\n    "
+    "Variable operator()() const override {\n        PROFILE(\"reduce\");\n    "
+    "    auto f = _values[0]->operator()();\n        auto sequence = "
+    "_values[1]->operator()();\n        std::size_t size;\n        "
+    "std::shared_ptr<List> list;\n        std::shared_ptr<Vector> vector;\n    "
+    "    if (sequence->_type == Type::Vector) {\n            vector = "
+    "to_vector(sequence);\n            size = vector->size();\n        } else "
+    "{\n            list = to_list(sequence);\n            size = "
+    "list->_value.size();\n        }\n        const auto element = "
+    "[&](std::size_t i) {\n            return vector ? vector_element(*vector, "
+    "i) : list->_value[i];\n        };\n        std::size_t i = 0;\n        "
+    "Variable args[2];\n        if (_values.size() == 3) {\n            "
+    "args[0] = _values[2]->operator()();\n        } else if (size == 0) {\n    "
+    "        return call(f, nullptr, 0);\n        } else {\n            "
+    "args[0] = element(i++);\n        }\n        for (; i < size; i++) {\n     "
+    "       args[1] = element(i);\n            args[0] = call(f, args, 2);\n   "
+    "     }\n        return args[0];\n    }\n};\n\n// append : concatenate "
+    "lists\nstruct Append final : public Expression {\n    explicit "
+    "Append(Args values) : Expression(std::move(values)) {}\n    ~Append() "
+    "override = default;\n    Variable operator()() const override {\n        "
+    "PROFILE(\"append\");\n        std::vector<Variable> result;\n        for "
+    "(const auto &v : _values) {\n            auto list = "
+    "to_list(v->operator()());\n            result.insert(result.end(), "
+    "list->_value.begin(),\n                          list->_value.end());\n   "
+    "     }\n        return make_list(std::move(result));\n    }\n};\n\n// "
+    "reverse : reverse a list, a vector or a string\nstruct Reverse final : "
+    "public Expression {\n    explicit Reverse(Args values) : "
+    "Expression(std::move(values)) {}\n    ~Reverse() override = default;\n    "
+    "Variable operator()() const override {\n        PROFILE(\"reverse\");\n   "
+    "     auto sequence = _values[0]->operator()();\n        if "
+    "(sequence->_type == Type::String) {\n            const auto &value = "
+    "to_string(sequence)->_value;\n            return "
+    "std::make_shared<String>(\n                std::string(value.rbegin(), "
+    "value.rend()));\n        }\n        if (sequence->_type == Type::Vector) "
+    "{\n            const auto vector = to_vector(sequence);\n            auto "
+    "result = std::make_shared<Vector>(vector->_element, 0);\n            "
+    "result->_values = vector->_values;\n            result->_fixnums = "
+    "vector->_fixnums;\n            result->_doubles = vector->_doubles;\n     "
+    "       std::reverse(result->_values.begin(), result->_values.end());\n    "
+    "        std::reverse(result->_fixnums.begin(), result->_fixnums.end());\n "
+    "           std::reverse(result->_doubles.begin(), "
+    "result->_doubles.end());\n            return result;\n        }\n        "
+    "const auto &value = to_list(sequence)->_value;\n        return "
+    "make_list(std::vector<Variable>(value.rbegin(), value.rend()));\n    "
+    "}\n};\n\n// nth : get the element of a list at an index, or nil\nstruct "
+    "Nth final : public Expression {\n    explicit Nth(Args values) : "
+    "Expression(std::move(values)) {}\n    ~Nth() override = default;\n    "
+    "Variable operator()() const override {\n        PROFILE(\"nth\");\n       "
+    " auto index = _values[0]->operator()();\n        auto list = "
+    "to_list(_values[1]->operator()());\n        if (index->_type != Type::Int "
+    "|| fixnum(index) < 0)\n            throw std::runtime_error(\"Invalid "
+    "type for index\");\n        if (static_cast<std::size_t>(fixnum(index)) "
+    ">= list->_value.size())\n            return std::make_shared<Nil>();\n    "
+    "    return list->_value[fixnum(index)];\n    }\n};\n\n// member : get the "
+    "tail of a list starting at an eql element, or nil\nstruct Member final : "
+    "public Expression {\n    explicit Member(Args values) : "
+    "Expression(std::move(values)) {}\n    ~Member() override = default;\n    "
+    "Variable operator()() const override {\n        PROFILE(\"member\");\n    "
+    "    auto item = _values[0]->operator()();\n        auto list = "
+    "to_list(_values[1]->operator()());\n        for (auto it = "
+    "list->_value.begin(); it != list->_value.end(); ++it)\n            if "
+    "(eql(item, *it))\n                return std::make_shared<List>(\n        "
+    "            std::vector<Variable>(it, list->_value.end()));\n        "
+    "return std::make_shared<Nil>();\n    }\n};\n\n// assoc : get the first "
+    "pair of an association list with an eql key, or nil\nstruct Assoc final : "
+    "public Expression {\n    explicit Assoc(Args values) : "
+    "Expression(std::move(values)) {}\n    ~Assoc() override = default;\n    "
+    "Variable operator()() const override {\n        PROFILE(\"assoc\");\n     "
+    "   auto key = _values[0]->operator()();\n        auto list = "
+    "to_list(_values[1]->operator()());\n        for (const auto &pair : "
+    "list->_value) {\n            if (pair->_type == Type::Nil)\n              "
+    "  continue;\n            if (const auto &entry = to_list(pair)->_value;\n "
+    "               !entry.empty() && eql(key, entry[0]))\n                "
+    "return pair;\n        }\n        return std::make_shared<Nil>();\n    "
+    "}\n};\n\n#pragma endregion ListOperations\n\n// lisp vector "
+    "operations\n#pragma region VectorOperations\n\n// to_doubles : the "
+    "elements of a fixnum or double-float vector as doubles\n[[nodiscard]] "
+    "inline std::vector<double> to_doubles(const Vector &v) {\n    if "
+    "(v._element == Vector::Element::Double)\n        return v._doubles;\n    "
+    "if (v._element == Vector::Element::Fixnum)\n        return "
+    "{v._fixnums.begin(), v._fixnums.end()};\n    throw "
+    "std::runtime_error(\"Invalid type for vector operation\");\n}\n\n// "
+    "vector_operands : evaluate two vectors of the same length\n[[nodiscard]] "
+    "inline std::pair<std::shared_ptr<Vector>, "
+    "std::shared_ptr<Vector>>\nvector_operands(const Args &values) {\n    auto "
+    "a = to_vector(values[0]->operator()());\n    auto b = "
+    "to_vector(values[1]->operator()());\n    if (a->size() != b->size())\n    "
+    "    throw std::runtime_error(\"Invalid vector length\");\n    return {a, "
+    "b};\n}\n\n// vector_index : check an index against the length of a "
+    "vector\n[[nodiscard]] inline std::size_t vector_index(const Vector &v, "
+    "const Variable &index) {\n    if (index->_type != Type::Int)\n        "
+    "throw std::runtime_error(\"Invalid type for index\");\n    if "
+    "(fixnum(index) < 0 || static_cast<std::size_t>(fixnum(index)) >= "
+    "v.size())\n        throw std::runtime_error(\"Index out of bounds\");\n   "
+    " return static_cast<std::size_t>(fixnum(index));\n}\n\n// make-array : "
+    "create a vector, the element type is resolved at compile time\nstruct "
+    "MakeArray final : public Expression {\n    explicit MakeArray(Args "
+    "values) = delete;\n    ~MakeArray() override = default;\n    explicit "
+    "MakeArray(Vector::Element element, Args values)\n        : "
+    "Expression(std::move(values)), _element(element) {}\n    Variable "
+    "operator()() const override {\n        PROFILE(\"make-array\");\n        "
+    "auto size = _values[0]->operator()();\n        if (size->_type != "
+    "Type::Int || fixnum(size) < 0)\n            throw "
+    "std::runtime_error(\"Invalid array size\");\n        auto init = "
+    "_values[1]->operator()();\n        auto result = "
+    "std::make_shared<Vector>(\n            _element, "
+    "static_cast<std::size_t>(fixnum(size)));\n        if (_element == "
+    "Vector::Element::Fixnum) {\n            if (init->_type != Type::Int)\n   "
+    "             throw std::runtime_error(\"Invalid type for fixnum "
+    "array\");\n            std::fill(result->_fixnums.begin(), "
+    "result->_fixnums.end(),\n                      fixnum(init));\n        } "
+    "else if (_element == Vector::Element::Double) {\n            "
+    "std::fill(result->_doubles.begin(), result->_doubles.end(),\n             "
+    "         to_double(init));\n        } else {\n            "
+    "std::fill(result->_values.begin(), result->_values.end(), init);\n        "
+    "}\n        return result;\n    }\n    Vector::Element _element;\n};\n\n// "
+    "aref : get an element of a vector\nstruct Aref final : public Expression "
+    "{\n    explicit Aref(Args values) : Expression(std::move(values)) {}\n    "
+    "~Aref() override = default;\n    Variable operator()() const override {\n "
+    "       PROFILE(\"aref\");\n        auto vector = "
+    "to_vector(_values[0]->operator()());\n        return "
+    "vector_element(*vector,\n                              "
+    "vector_index(*vector, _values[1]->operator()()));\n    }\n};\n\n// setf "
+    "aref : set an element of a vector\nstruct SetAref final : public "
+    "Expression {\n    explicit SetAref(Args values) : "
+    "Expression(std::move(values)) {}\n    ~SetAref() override = default;\n    "
+    "Variable operator()() const override {\n        PROFILE(\"setf aref\");\n "
+    "       auto vector = to_vector(_values[0]->operator()());\n        auto i "
+    "= vector_index(*vector, _values[1]->operator()());\n        auto value = "
+    "_values[2]->operator()();\n        if (vector->_element == "
+    "Vector::Element::Fixnum) {\n            if (value->_type != Type::Int)\n  "
+    "              throw std::runtime_error(\"Invalid type for fixnum "
+    "array\");\n            vector->_fixnums[i] = fixnum(value);\n        } "
+    "else if (vector->_element == Vector::Element::Double) {\n            "
+    "vector->_doubles[i] = to_double(value);\n        } else {\n            "
+    "vector->_values[i] = value;\n        }\n        return value;\n    "
+    "}\n};\n\n// length : get the length of a vector, a list or a "
+    "string\nstruct Length final : public Expression {\n    explicit "
+    "Length(Args values) : Expression(std::move(values)) {}\n    ~Length() "
+    "override = default;\n    Variable operator()() const override {\n        "
+    "PROFILE(\"length\");\n        auto value = _values[0]->operator()();\n    "
+    "    switch (value->_type) {\n        case Type::Vector:\n            "
+    "return std::make_shared<Int>(\n                static_cast<long "
+    "long>(to_vector(value)->size()));\n        case Type::String:\n           "
+    " return std::make_shared<Int>(\n                static_cast<long "
+    "long>(to_string(value)->_value.size()));\n        case Type::List:\n      "
+    "  case Type::Nil:\n            return std::make_shared<Int>(\n            "
+    "    static_cast<long long>(to_list(value)->_value.size()));\n        "
+    "default:\n            throw std::runtime_error(\"Invalid type for "
+    "length\");\n        }\n    }\n};\n\n// vector-add : element-wise addition "
+    "of two vectors\nstruct VectorAdd final : public Expression {\n    "
+    "explicit VectorAdd(Args values) : Expression(std::move(values)) {}\n    "
+    "~VectorAdd() override = default;\n    Variable operator()() const "
+    "override {\n        PROFILE(\"vector-add\");\n        auto [a, b] = "
+    "vector_operands(_values);\n        const auto n = a->size();\n        if "
+    "(a->_element == Vector::Element::Fixnum &&\n            b->_element == "
+    "Vector::Element::Fixnum) {\n            auto result = "
+    "std::make_shared<Vector>(Vector::Element::Fixnum, n);\n            if "
+    "(!add_i64(a->_fixnums.data(), b->_fixnums.data(),\n                       "
+    "  result->_fixnums.data(), n))\n                throw "
+    "std::runtime_error(\"Fixnum overflow in vector-add\");\n            "
+    "return result;\n        }\n        const auto x = to_doubles(*a), y = "
+    "to_doubles(*b);\n        auto result = "
+    "std::make_shared<Vector>(Vector::Element::Double, n);\n        "
+    "add_f64(x.data(), y.data(), result->_doubles.data(), n);\n        return "
+    "result;\n    }\n};\n\n// vector-mul : element-wise multiplication of two "
+    "vectors\nstruct VectorMul final : public Expression {\n    explicit "
+    "VectorMul(Args values) : Expression(std::move(values)) {}\n    "
+    "~VectorMul() override = default;\n    Variable operator()() const "
+    "override {\n        PROFILE(\"vector-mul\");\n        auto [a, b] = "
+    "vector_operands(_values);\n        const auto n = a->size();\n        if "
+    "(a->_element == Vector::Element::Fixnum &&\n            b->_element == "
+    "Vector::Element::Fixnum) {\n            auto result = "
+    "std::make_shared<Vector>(Vector::Element::Fixnum, n);\n            if "
+    "(!mul_i64(a->_fixnums.data(), b->_fixnums.data(),\n                       "
+    "  result->_fixnums.data(), n))\n                throw "
+    "std::runtime_error(\"Fixnum overflow in vector-mul\");\n            "
+    "return result;\n        }\n        const auto x = to_doubles(*a), y = "
+    "to_doubles(*b);\n        auto result = "
+    "std::make_shared<Vector>(Vector::Element::Double, n);\n        "
+    "mul_f64(x.data(), y.data(), result->_doubles.data(), n);\n        return "
+    "result;\n    }\n};\n\n// vector-dot : dot product of two vectors\nstruct "
+    "VectorDot final : public Expression {\n    explicit VectorDot(Args "
+    "values) : Expression(std::move(values)) {}\n    ~VectorDot() override = "
+    "default;\n    Variable operator()() const override {\n        "
+    "PROFILE(\"vector-dot\");\n        auto [a, b] = "
+    "vector_operands(_values);\n        const auto n = a->size();\n        if "
+    "(a->_element == Vector::Element::Fixnum &&\n            b->_element == "
+    "Vector::Element::Fixnum) {\n            long long result = 0, product;\n  "
+    "          std::size_t i = 0;\n            for (; i < n; i++)\n            "
+    "    if (__builtin_mul_overflow(a->_fixnums[i], b->_fixnums[i],\n          "
+    "                                 &product) ||\n                    "
+    "__builtin_add_overflow(result, product, &result))\n                    "
+    "break;\n            if (i == n)\n                return "
+    "std::make_shared<Int>(result);\n            // overflow, redo the whole "
+    "sum with bignums\n            BigInt sum;\n            for (i = 0; i < n; "
+    "i++)\n                sum = sum + BigInt(a->_fixnums[i]) * "
+    "BigInt(b->_fixnums[i]);\n            return "
+    "make_integer(std::move(sum));\n        }\n        const auto x = "
+    "to_doubles(*a), y = to_doubles(*b);\n        return "
+    "std::make_shared<Float>(dot_f64(x.data(), y.data(), n));\n    }\n};\n\n// "
+    "vector-sum : sum of the elements of a vector\nstruct VectorSum final : "
+    "public Expression {\n    explicit VectorSum(Args values) : "
+    "Expression(std::move(values)) {}\n    ~VectorSum() override = default;\n  "
+    "  Variable operator()() const override {\n        "
+    "PROFILE(\"vector-sum\");\n        auto a = "
+    "to_vector(_values[0]->operator()());\n        if (a->_element == "
+    "Vector::Element::Fixnum) {\n            long long result;\n            if "
+    "(sum_i64(a->_fixnums.data(), a->size(), result))\n                return "
+    "std::make_shared<Int>(result);\n            BigInt sum;\n            for "
+    "(const auto v : a->_fixnums)\n                sum = sum + BigInt(v);\n    "
+    "        return make_integer(std::move(sum));\n        }\n        const "
+    "auto x = to_doubles(*a);\n        return "
+    "std::make_shared<Float>(sum_f64(x.data(), x.size()));\n    }\n};\n\n// "
+    "vector-min, vector-max : smallest or largest element of a "
+    "vector\ntemplate <bool Max> struct VectorExtreme final : public "
+    "Expression {\n    explicit VectorExtreme(Args values) : "
+    "Expression(std::move(values)) {}\n    ~VectorExtreme() override = "
+    "default;\n    Variable operator()() const override {\n        PROFILE(Max "
+    "? \"vector-max\" : \"vector-min\");\n        auto a = "
+    "to_vector(_values[0]->operator()());\n        if (a->size() == 0)\n       "
+    "     throw std::runtime_error(\"Empty vector\");\n        if (a->_element "
+    "== Vector::Element::Fixnum)\n            return std::make_shared<Int>(\n  "
+    "              extreme_i64<Max>(a->_fixnums.data(), a->size()));\n        "
+    "const auto x = to_doubles(*a);\n        return "
+    "std::make_shared<Float>(extreme_f64<Max>(x.data(), x.size()));\n    "
+    "}\n};\n\nusing VectorMin = VectorExtreme<false>;\nusing VectorMax = "
+    "VectorExtreme<true>;\n\n#pragma endregion VectorOperations\n\n// lisp "
+    "hash table operations\n#pragma region HashTableOperations\n\n// "
+    "make-hash-table : create a hash table, the test is resolved at compile "
+    "time\nstruct MakeHashTable final : public Expression {\n    explicit "
+    "MakeHashTable(Args values) = delete;\n    ~MakeHashTable() override = "
+    "default;\n    explicit MakeHashTable(bool structural)\n        : "
+    "Expression(std::vector<std::shared_ptr<Expression>>()),\n          "
+    "_structural(structural) {}\n    Variable operator()() const override {\n  "
+    "      PROFILE(\"make-hash-table\");\n        return "
+    "std::make_shared<HashTable>(_structural);\n    }\n    bool "
+    "_structural;\n};\n\n// gethash : get the value of a key, or the default "
+    "(nil)\nstruct Gethash final : public Expression {\n    explicit "
+    "Gethash(Args values) : Expression(std::move(values)) {}\n    ~Gethash() "
+    "override = default;\n    Variable operator()() const override {\n        "
+    "PROFILE(\"gethash\");\n        auto key = _values[0]->operator()();\n     "
+    "   auto table = to_hash_table(_values[1]->operator()());\n        if "
+    "(const auto slot = table->find(key))\n            return slot->_value;\n  "
+    "      if (_values.size() == 3)\n            return "
+    "_values[2]->operator()();\n        return std::make_shared<Nil>();\n    "
+    "}\n};\n\n// setf gethash : set the value of a key\nstruct SetGethash "
+    "final : public Expression {\n    explicit SetGethash(Args values) : "
+    "Expression(std::move(values)) {}\n    ~SetGethash() override = default;\n "
+    "   Variable operator()() const override {\n        PROFILE(\"setf "
+    "gethash\");\n        auto key = _values[0]->operator()();\n        auto "
+    "table = to_hash_table(_values[1]->operator()());\n        auto value = "
+    "_values[2]->operator()();\n        table->insert(std::move(key), "
+    "value);\n        return value;\n    }\n};\n\n// remhash : remove a key, t "
+    "if it was present\nstruct Remhash final : public Expression {\n    "
+    "explicit Remhash(Args values) : Expression(std::move(values)) {}\n    "
+    "~Remhash() override = default;\n    Variable operator()() const override "
+    "{\n        PROFILE(\"remhash\");\n        auto key = "
+    "_values[0]->operator()();\n        return "
+    "to_t_or_nil(to_hash_table(_values[1]->operator()())->erase(key));\n    "
+    "}\n};\n\n// hash-table-count : number of entries of a hash table\nstruct "
+    "HashTableCount final : public Expression {\n    explicit "
+    "HashTableCount(Args values) : Expression(std::move(values)) {}\n    "
+    "~HashTableCount() override = default;\n    Variable operator()() const "
+    "override {\n        PROFILE(\"hash-table-count\");\n        return "
+    "std::make_shared<Int>(static_cast<long long>(\n            "
+    "to_hash_table(_values[0]->operator()())->_count));\n    }\n};\n\n#pragma "
+    "endregion HashTableOperations\n\n// lisp runtime environment\n#pragma "
+    "region RuntimeEnvironment\n\n// unboxed : a slot of a variable declared "
+    "fixnum or double-float\nunion Unboxed {\n    long long fixnum;\n    "
+    "double real;\n};\n\n// frame : the local variable slots of the running "
+    "function\ninline thread_local Variable *frame = nullptr;\n// environment "
+    ": the values captured by the running closure\ninline thread_local const "
+    "Variable *environment = nullptr;\n// natives : the unboxed slots of the "
+    "running function\ninline thread_local Unboxed *natives = nullptr;\n\n// "
+    "sets the running frame and environment for the lifetime of the "
+    "object\nstruct FrameScope {\n    explicit FrameScope(Variable *slots, "
+    "const Variable *captured = nullptr,\n                        Unboxed "
+    "*unboxed = nullptr)\n        : _outer(frame), "
+    "_outer_environment(environment),\n          _outer_natives(natives) {\n   "
+    "     frame = slots;\n        environment = captured;\n        natives = "
+    "unboxed;\n    }\n    ~FrameScope() {\n        frame = _outer;\n        "
+    "environment = _outer_environment;\n        natives = _outer_natives;\n    "
+    "}\n    FrameScope(const FrameScope &) = delete;\n    FrameScope "
+    "&operator=(const FrameScope &) = delete;\n    Variable *_outer;\n    "
+    "const Variable *_outer_environment;\n    Unboxed "
+    "*_outer_natives;\n};\n\n// local : read a local variable slot of the "
+    "running function\nstruct LocalFunction final : public Expression {\n    "
+    "explicit LocalFunction(Args values) = delete;\n    ~LocalFunction() "
+    "override = default;\n    explicit LocalFunction(const std::size_t "
+    "index)\n        : "
+    "Expression(std::vector<std::shared_ptr<Expression>>()),\n          "
+    "_index(index) {}\n    Variable operator()() const override { return "
+    "frame[_index]; }\n    long long as_fixnum() const override { return "
+    "unbox_fixnum(frame[_index]); }\n    double as_double() const override { "
+    "return unbox_double(frame[_index]); }\n    std::size_t _index;\n};\n\n// "
+    "fixnum slot : read a local variable declared fixnum\nstruct FixnumSlot "
+    "final : public Expression {\n    explicit FixnumSlot(Args values) = "
+    "delete;\n    ~FixnumSlot() override = default;\n    explicit "
+    "FixnumSlot(const std::size_t index)\n        : "
+    "Expression(std::vector<std::shared_ptr<Expression>>()),\n          "
+    "_index(index) {}\n    Variable operator()() const override {\n        "
+    "return std::make_shared<Int>(natives[_index].fixnum);\n    }\n    long "
+    "long as_fixnum() const override { return natives[_index].fixnum; }\n    "
+    "double as_double() const override {\n        return "
+    "static_cast<double>(natives[_index].fixnum);\n    }\n    bool as_bool() "
+    "const override { return natives[_index].fixnum != 0; }\n    std::size_t "
+    "_index;\n};\n\n// double slot : read a local variable declared "
+    "double-float\nstruct DoubleSlot final : public Expression {\n    explicit "
+    "DoubleSlot(Args values) = delete;\n    ~DoubleSlot() override = "
+    "default;\n    explicit DoubleSlot(const std::size_t index)\n        : "
+    "Expression(std::vector<std::shared_ptr<Expression>>()),\n          "
+    "_index(index) {}\n    Variable operator()() const override {\n        "
+    "return std::make_shared<Float>(natives[_index].real);\n    }\n    double "
+    "as_double() const override { return natives[_index].real; }\n    bool "
+    "as_bool() const override { return natives[_index].real != 0; }\n    "
+    "std::size_t _index;\n};\n\n// captured : read a value captured by the "
+    "running closure\nstruct CapturedFunction final : public Expression {\n    "
+    "explicit CapturedFunction(Args values) = delete;\n    ~CapturedFunction() "
+    "override = default;\n    explicit CapturedFunction(const std::size_t "
+    "index)\n        : "
+    "Expression(std::vector<std::shared_ptr<Expression>>()),\n          "
+    "_index(index) {}\n    Variable operator()() const override { return "
+    "environment[_index]; }\n    std::size_t _index;\n};\n\n// function : a "
+    "function value referring to a definition\nstruct FunctionRef final : "
+    "public Expression {\n    explicit FunctionRef(Args values) = delete;\n    "
+    "~FunctionRef() override = default;\n    explicit "
+    "FunctionRef(Procedure::Native native, std::size_t arity,\n                "
+    "         const char *name)\n        : "
+    "Expression(std::vector<std::shared_ptr<Expression>>()),\n          "
+    "_procedure(std::make_shared<Procedure>(native, arity, name)) {}\n    "
+    "Variable operator()() const override { return _procedure; }\n    Variable "
+    "_procedure;\n};\n\n// closure : a function value capturing the current "
+    "values of the variables\n// its lambda refers to, a closure that captures "
+    "nothing is created once\nstruct Closure final : public Expression {\n    "
+    "explicit Closure(Args values) = delete;\n    ~Closure() override = "
+    "default;\n    explicit Closure(Procedure::Native native, std::size_t "
+    "arity, Args values)\n        : Expression(std::move(values)), "
+    "_native(native), _arity(arity) {\n        if (_values.empty())\n          "
+    "  _procedure = std::make_shared<Procedure>(native, arity, \"lambda\");\n  "
+    "  }\n    Variable operator()() const override {\n        if "
+    "(_procedure)\n            return _procedure;\n        "
+    "PROFILE(\"closure\");\n        std::vector<Variable> captured;\n        "
+    "captured.reserve(_values.size());\n        for (const auto &v : "
+    "_values)\n            captured.push_back(v->operator()());\n        "
+    "return std::make_shared<Procedure>(_native, _arity, \"lambda\",\n         "
+    "                                  std::move(captured));\n    }\n    "
+    "Procedure::Native _native;\n    std::size_t _arity;\n    Variable "
+    "_procedure;\n};\n\n// funcall : call a function value\nstruct Funcall "
+    "final : public Expression {\n    explicit Funcall(Args values) : "
+    "Expression(std::move(values)) {}\n    ~Funcall() override = default;\n    "
+    "Variable operator()() const override {\n        PROFILE(\"funcall\");\n   "
+    "     auto f = _values[0]->operator()();\n        std::vector<Variable> "
+    "args(_values.size() - 1);\n        for (std::size_t i = 1; i < "
+    "_values.size(); i++)\n            args[i - 1] = "
+    "_values[i]->operator()();\n        return call(f, args.data(), "
+    "args.size());\n    }\n};\n\n// let : bind values to consecutive local "
+    "variable slots and evaluate the body\nstruct Let final : public "
+    "Expression {\n    explicit Let(Args values) = delete;\n    ~Let() "
+    "override = default;\n    explicit Let(const std::size_t first, Args "
+    "values)\n        : Expression(std::move(values)), _first(first) {}\n    "
+    "Variable operator()() const override {\n        for (std::size_t i = 0; i "
+    "+ 1 < _values.size(); i++)\n            frame[_first + i] = "
+    "_values[i]->operator()();\n        return _values.back()->operator()();\n "
+    "   }\n    std::size_t _first;\n};\n\n// setq : assign a local variable "
+    "slot\nstruct Setq final : public Expression {\n    explicit Setq(Args "
+    "values) = delete;\n    ~Setq() override = default;\n    explicit "
+    "Setq(const std::size_t index, Args values)\n        : "
+    "Expression(std::move(values)), _index(index) {}\n    Variable "
+    "operator()() const override {\n        return frame[_index] = "
+    "_values[0]->operator()();\n    }\n    std::size_t _index;\n};\n\n// set "
+    "fixnum : assign a local variable declared fixnum\nstruct SetFixnum final "
+    ": public Expression {\n    explicit SetFixnum(Args values) = delete;\n    "
+    "~SetFixnum() override = default;\n    explicit SetFixnum(const "
+    "std::size_t index, Args values)\n        : Expression(std::move(values)), "
+    "_index(index) {}\n    Variable operator()() const override {\n        "
+    "return std::make_shared<Int>(as_fixnum());\n    }\n    long long "
+    "as_fixnum() const override {\n        return natives[_index].fixnum = "
+    "_values[0]->as_fixnum();\n    }\n    void execute() const override { auto "
+    "discard = as_fixnum(); }\n    std::size_t _index;\n};\n\n// set double : "
+    "assign a local variable declared double-float\nstruct SetDouble final : "
+    "public Expression {\n    explicit SetDouble(Args values) = delete;\n    "
+    "~SetDouble() override = default;\n    explicit SetDouble(const "
+    "std::size_t index, Args values)\n        : Expression(std::move(values)), "
+    "_index(index) {}\n    Variable operator()() const override {\n        "
+    "return std::make_shared<Float>(as_double());\n    }\n    double "
+    "as_double() const override {\n        return natives[_index].real = "
+    "_values[0]->as_double();\n    }\n    void execute() const override { auto "
+    "discard = as_double(); }\n    std::size_t _index;\n};\n\n// dotimes : run "
+    "the body with a slot counting up from 0 to a fixnum, then\n// evaluate "
+    "the result with the slot set to the count\nstruct Dotimes final : public "
+    "Expression {\n    explicit Dotimes(Args values) = delete;\n    ~Dotimes() "
+    "override = default;\n    explicit Dotimes(const std::size_t index, Args "
+    "values)\n        : Expression(std::move(values)), _index(index) {}\n    "
+    "Variable operator()() const override {\n        PROFILE(\"dotimes\");\n   "
+    "     const auto count = _values[0]->operator()();\n        if "
+    "(count->_type != Type::Int)\n            throw "
+    "std::runtime_error(\"Invalid type conversion\");\n        const long long "
+    "n = fixnum(count);\n        for (long long i = 0; i < n; i++) {\n         "
+    "   // reuse the counter when the body did not keep it\n            if "
+    "(auto &slot = frame[_index]; slot && slot.use_count() == 1 &&\n           "
+    "                                 slot->_type == Type::Int)\n              "
+    "  static_cast<Int &>(*slot)._value = i;\n            else\n               "
+    " slot = std::make_shared<Int>(i);\n            for (std::size_t j = 2; j "
+    "< _values.size(); j++)\n                _values[j]->execute();\n        "
+    "}\n        frame[_index] = std::make_shared<Int>(std::max(n, 0LL));\n     "
+    "   return _values[1]->operator()();\n    }\n    std::size_t "
+    "_index;\n};\n\n// dolist : run the body with a slot set to each element "
+    "of a list, then\n// evaluate the result with the slot set to nil\nstruct "
+    "Dolist final : public Expression {\n    explicit Dolist(Args values) = "
+    "delete;\n    ~Dolist() override = default;\n    explicit Dolist(const "
+    "std::size_t index, Args values)\n        : Expression(std::move(values)), "
+    "_index(index) {}\n    Variable operator()() const override {\n        "
+    "PROFILE(\"dolist\");\n        const auto list = "
+    "to_list(_values[0]->operator()());\n        for (const auto &item : "
+    "list->_value) {\n            frame[_index] = item;\n            for "
+    "(std::size_t j = 2; j < _values.size(); j++)\n                "
+    "_values[j]->execute();\n        }\n        frame[_index] = "
+    "std::make_shared<Nil>();\n        return _values[1]->operator()();\n    "
+    "}\n    std::size_t _index;\n};\n\n// loop : run the body while (or until) "
+    "a condition holds, returns nil\nstruct Loop final : public Expression {\n "
+    "   explicit Loop(Args values) = delete;\n    ~Loop() override = "
+    "default;\n    explicit Loop(const bool until, Args values)\n        : "
+    "Expression(std::move(values)), _until(until) {}\n    Variable "
+    "operator()() const override {\n        PROFILE(\"loop\");\n        while "
+    "(_values[0]->as_bool() != _until)\n            for (std::size_t j = 1; j "
+    "< _values.size(); j++)\n                _values[j]->execute();\n        "
+    "return std::make_shared<Nil>();\n    }\n    bool _until;\n};\n\n// print "
+    ": print a value\nstruct Print final : public Expression {\n    explicit "
+    "Print(Args values) : Expression(std::move(values)) {}\n    ~Print() "
+    "override = default;\n    Variable operator()() const override {\n        "
+    "PROFILE(\"print\");\n        auto value = _values[0]->operator()();\n     "
+    "   value->write(output);\n        output.put('\\n');\n        return "
+    "value;\n    }\n};\n\n// progn : evaluate multiple expressions\nstruct "
+    "Progn final : public Expression {\n    explicit Progn(Args values) : "
     "Expression(std::move(values)) {}\n    ~Progn() override = default;\n    "
-    "Variable operator()() const override {\n        Variable result = "
-    "std::make_shared<Nil>();\n        for (const auto &v : _values)\n         "
-    "   result = v->operator()();\n        return result;\n    "
-    "}\n};\n\n#pragma endregion RuntimeEnvironment\n\n// definitions\n#pragma "
-    "region Definitions\n\n// clang-format off\n\n#define SYMBOL(value) "
-    "std::make_shared<SymbolFunction>(value)\n#define INT(value) "
-    "std::make_shared<IntFunction>(value)\n#define FLOAT(value) "
-    "std::make_shared<FloatFunction>(value)\n#define STRING(value) "
-    "std::make_shared<StringFunction>(value)\n#define LIST(...) "
-    "std::make_shared<ListFunction>(Args({__VA_ARGS__}))\n#define "
-    "QUOTED(value) std::make_shared<QuotedFunction>(Args({value}))\n#define "
-    "T() std::make_shared<TFunction>()\n#define NIL() "
-    "std::make_shared<NilFunction>()\n#define FUNC(name, ...) "
-    "std::make_shared<name>(Args({__VA_ARGS__}))\n#define ARG(number) "
-    "_values[number]\n#define DEF(name, args_count, ...)\\\nstruct name final "
-    ": public Expression {\\\n    explicit name(Args values) : "
-    "Expression(std::move(values)) {\\\n        if (_values.size() != "
-    "args_count)\\\n            throw std::runtime_error(\"Invalid number of "
-    "arguments\");\\\n    }\\\n    ~name() override = default;\\\n    Variable "
-    "operator()() const override {\\\n        return "
-    "__VA_ARGS__->operator()();\\\n    }\\\n};\n// clang-format on\n\n#pragma "
-    "endregion Definitions\n\n\n$1\n\n\nint main() {\n    try {\n        const "
-    "auto program = std::make_shared<Progn>(Args({\n\n            // start of "
-    "the program\n\n            $2\n\n            // end of the program\n\n    "
-    "    }));\n\n        auto discard = program->operator()();\n\n    } catch "
-    "(const std::exception &e) {\n        std::cerr << \"Runtime Error: \" << "
-    "e.what() << std::endl;\n        return 1;\n    }\n\n    return 0;\n}";
+    "Variable operator()() const override {\n        if (_values.empty())\n    "
+    "        return std::make_shared<Nil>();\n        return "
+    "last()->operator()();\n    }\n    long long as_fixnum() const override { "
+    "return last()->as_fixnum(); }\n    double as_double() const override { "
+    "return last()->as_double(); }\n    bool as_bool() const override { return "
+    "last()->as_bool(); }\n    void execute() const override {\n        for "
+    "(const auto &v : _values)\n            v->execute();\n    }\n    // run "
+    "every form but the last one, which is returned\n    const Function "
+    "&last() const {\n        for (std::size_t i = 0; i + 1 < _values.size(); "
+    "i++)\n            _values[i]->execute();\n        return "
+    "_values.back();\n    }\n};\n\n#pragma endregion RuntimeEnvironment\n\n// "
+    "lisp call stack\n#pragma region Stack\n\n#include <pthread.h>\n#include "
+    "<sys/mman.h>\n\n// the lisp functions recurse on the C++ stack, every "
+    "call checks that the\n// stack has room left, so that a deep recursion "
+    "raises an error instead of\n// crashing the program\n\n// stack_margin : "
+    "the stack left for the code between two calls, the runtime\n// functions "
+    "and the unwinding of the error\ninline constexpr std::size_t stack_margin "
+    "= 256 * 1024;\n\n// stack_limit : the lowest address a call may start at "
+    "on this thread, 0\n// until set_stack_limit is called\ninline "
+    "thread_local std::uintptr_t stack_limit = 0;\n\n// set_stack_limit : keep "
+    "stack_margin bytes at the end of this thread's stack\ninline void "
+    "set_stack_limit() {\n    pthread_attr_t attr;\n    if "
+    "(pthread_getattr_np(pthread_self(), &attr) != 0)\n        return;\n    "
+    "void *base = nullptr;\n    std::size_t size = 0;\n    "
+    "pthread_attr_getstack(&attr, &base, &size);\n    "
+    "pthread_attr_destroy(&attr);\n    stack_limit = "
+    "reinterpret_cast<std::uintptr_t>(base) +\n                  "
+    "std::min(stack_margin, size / 4);\n}\n\ninline void check_stack() {\n    "
+    "if (reinterpret_cast<std::uintptr_t>(__builtin_frame_address(0)) <\n      "
+    "  stack_limit) [[unlikely]]\n        throw std::runtime_error(\"Stack "
+    "exhausted\");\n}\n\n// stack_size : LISP_STACK_SIZE MiB or 1 GiB, only "
+    "reserved, the pages are\n// committed by the system as the recursion "
+    "reaches them\ninline std::size_t stack_size() {\n    const char *env = "
+    "std::getenv(\"LISP_STACK_SIZE\");\n    const char *end = env ? env + "
+    "std::strlen(env) : nullptr;\n    std::size_t mib = 0;\n    // the default "
+    "when it is not a number, at most what fits in bytes\n    const auto [ptr, "
+    "error] = env ? std::from_chars(env, end, mib)\n                           "
+    "       : std::from_chars_result{nullptr, {}};\n    if (error == "
+    "std::errc::result_out_of_range)\n        mib = SIZE_MAX;\n    else if "
+    "(!env || ptr != end || !mib)\n        mib = 1024;\n    return "
+    "std::min<std::size_t>(mib, SIZE_MAX >> 20) << 20;\n}\n\n// run_on_stack : "
+    "run f on a thread with a stack of stack_size bytes, or on\n// this thread "
+    "if the stack cannot be reserved\ntemplate <typename F> int run_on_stack(F "
+    "f) {\n    struct Call {\n        F &f;\n        int result;\n    } "
+    "call{f, 1};\n    const auto start = [](void *data) -> void * {\n        "
+    "auto &call = *static_cast<Call *>(data);\n        set_stack_limit();\n    "
+    "    call.result = call.f();\n        return nullptr;\n    };\n\n    const "
+    "std::size_t size = stack_size();\n    void *stack = mmap(nullptr, size, "
+    "PROT_READ | PROT_WRITE,\n                       MAP_PRIVATE | "
+    "MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK,\n                       -1, "
+    "0);\n    if (stack == MAP_FAILED) {\n        set_stack_limit();\n        "
+    "return f();\n    }\n    // a guard page turns an overflow of the margin "
+    "into a crash, not a write\n    // to the memory below\n    "
+    "mprotect(stack, 4096, PROT_NONE);\n    pthread_attr_t attr;\n    "
+    "pthread_t thread;\n    pthread_attr_init(&attr);\n    const bool started "
+    "= pthread_attr_setstack(&attr, stack, size) == 0 &&\n                     "
+    "    pthread_create(&thread, &attr, start, &call) == 0;\n    "
+    "pthread_attr_destroy(&attr);\n    if (started)\n        "
+    "pthread_join(thread, nullptr);\n    munmap(stack, size);\n    if "
+    "(!started) {\n        set_stack_limit();\n        return f();\n    }\n    "
+    "return call.result;\n}\n\n#pragma endregion Stack\n\n// lisp parallel "
+    "evaluation\n#pragma region Parallel\n\n#include <atomic>\n#include "
+    "<condition_variable>\n#include <deque>\n#include <exception>\n#include "
+    "<functional>\n#include <thread>\n\n// ThreadPool : work stealing pool, "
+    "every thread owns a deque of tasks, pops\n// its own tasks from the back "
+    "and steals from the front of the others\nstruct ThreadPool {\n    using "
+    "Task = std::function<void()>;\n    struct Queue {\n        std::mutex "
+    "_mutex;\n        std::deque<Task> _tasks;\n    };\n\n    // the last "
+    "queue belongs to the threads outside of the pool, which run\n    // tasks "
+    "while they wait for them\n    explicit ThreadPool(std::size_t threads) : "
+    "_queues(threads) {\n        for (auto &queue : _queues)\n            "
+    "queue = std::make_unique<Queue>();\n        for (std::size_t i = 0; i + 1 "
+    "< threads; i++)\n            _workers.emplace_back([this, i] { work(i); "
+    "});\n    }\n    ~ThreadPool() {\n        {\n            "
+    "std::lock_guard<std::mutex> lock(_sleep_mutex);\n            _stop = "
+    "true;\n        }\n        _wake.notify_all();\n        for (auto &worker "
+    ": _workers)\n            worker.join();\n    }\n    ThreadPool(const "
+    "ThreadPool &) = delete;\n    ThreadPool &operator=(const ThreadPool &) = "
+    "delete;\n\n    [[nodiscard]] std::size_t size() const { return "
+    "_queues.size(); }\n\n    void submit(Task task) {\n        auto &queue = "
+    "*_queues[self()];\n        {\n            std::lock_guard<std::mutex> "
+    "lock(queue._mutex);\n            "
+    "queue._tasks.push_back(std::move(task));\n        }\n        "
+    "_pending.fetch_add(1);\n        { std::lock_guard<std::mutex> "
+    "lock(_sleep_mutex); }\n        _wake.notify_one();\n    }\n\n    // "
+    "run_one : run a task of this thread or steal one, false if there is "
+    "none\n    bool run_one() {\n        const std::size_t self = "
+    "this->self();\n        Task task;\n        bool found = "
+    "pop(*_queues[self], task, true);\n        for (std::size_t i = 1; !found "
+    "&& i < _queues.size(); i++)\n            found = pop(*_queues[(self + i) "
+    "% _queues.size()], task, false);\n        if (!found)\n            return "
+    "false;\n        _pending.fetch_sub(1);\n        task();\n        return "
+    "true;\n    }\n\n    static bool pop(Queue &queue, Task &task, bool back) "
+    "{\n        std::lock_guard<std::mutex> lock(queue._mutex);\n        if "
+    "(queue._tasks.empty())\n            return false;\n        if (back) {\n  "
+    "          task = std::move(queue._tasks.back());\n            "
+    "queue._tasks.pop_back();\n        } else {\n            task = "
+    "std::move(queue._tasks.front());\n            queue._tasks.pop_front();\n "
+    "       }\n        return true;\n    }\n\n    void work(std::size_t index) "
+    "{\n        _index = index;\n        worker_thread = true;\n        "
+    "set_stack_limit();\n        while (true) {\n            if (run_one())\n  "
+    "              continue;\n            std::unique_lock<std::mutex> "
+    "lock(_sleep_mutex);\n            _wake.wait(lock, [this] { return _stop "
+    "|| _pending.load() > 0; });\n            if (_stop)\n                "
+    "return;\n        }\n    }\n\n    [[nodiscard]] std::size_t self() const "
+    "{\n        return _index == SIZE_MAX ? _queues.size() - 1 : _index;\n    "
+    "}\n\n    static inline thread_local std::size_t _index = SIZE_MAX;\n    "
+    "std::vector<std::unique_ptr<Queue>> _queues;\n    "
+    "std::vector<std::thread> _workers;\n    std::atomic<std::size_t> "
+    "_pending{0};\n    std::mutex _sleep_mutex;\n    std::condition_variable "
+    "_wake;\n    bool _stop = false;\n};\n\n// pool : the thread pool, "
+    "LISP_THREADS threads or one per core\ninline ThreadPool &pool() {\n    "
+    "static ThreadPool instance([] {\n        const char *env = "
+    "std::getenv(\"LISP_THREADS\");\n        const std::size_t threads = env "
+    "&& *env\n                                        ? std::strtoull(env, "
+    "nullptr, 10)\n                                        : "
+    "std::thread::hardware_concurrency();\n        return "
+    "std::max<std::size_t>(threads, 1);\n    }());\n    return "
+    "instance;\n}\n\n// TaskGroup : tasks run on the pool, wait rethrows the "
+    "first error\nstruct TaskGroup {\n    TaskGroup() = default;\n    "
+    "~TaskGroup() { join(); }\n    TaskGroup(const TaskGroup &) = delete;\n    "
+    "TaskGroup &operator=(const TaskGroup &) = delete;\n\n    void "
+    "run(ThreadPool::Task task) {\n        _remaining.fetch_add(1);\n        "
+    "pool().submit([this, task = std::move(task)] {\n            try {\n       "
+    "         task();\n            } catch (...) {\n                "
+    "std::lock_guard<std::mutex> lock(_mutex);\n                if (!_error)\n "
+    "                   _error = std::current_exception();\n            }\n    "
+    "        _remaining.fetch_sub(1);\n        });\n    }\n    // join : help "
+    "running tasks until all the tasks of the group are done\n    void join() "
+    "{\n        while (_remaining.load() > 0)\n            if "
+    "(!pool().run_one())\n                std::this_thread::yield();\n    }\n  "
+    "  void wait() {\n        join();\n        if (_error)\n            "
+    "std::rethrow_exception(_error);\n    }\n\n    std::atomic<std::size_t> "
+    "_remaining{0};\n    std::mutex _mutex;\n    std::exception_ptr "
+    "_error;\n};\n\n// pcall : evaluate the arguments concurrently, then call "
+    "the function\nstruct Pcall final : public Expression {\n    explicit "
+    "Pcall(Args values) : Expression(std::move(values)) {}\n    ~Pcall() "
+    "override = default;\n    Variable operator()() const override {\n        "
+    "PROFILE(\"pcall\");\n        auto f = _values[0]->operator()();\n        "
+    "std::vector<Variable> args(_values.size() - 1);\n        // the arguments "
+    "read the caller's frame, the generator gives each\n        // of them its "
+    "own let slots\n        Variable *caller = frame;\n        const Variable "
+    "*captured = environment;\n        Unboxed *unboxed = natives;\n        "
+    "TaskGroup group;\n        for (std::size_t i = 1; i < _values.size(); "
+    "i++)\n            group.run([this, &args, caller, captured, unboxed, i] "
+    "{\n                FrameScope scope(caller, captured, unboxed);\n         "
+    "       args[i - 1] = _values[i]->operator()();\n            });\n        "
+    "group.wait();\n        return call(f, args.data(), args.size());\n    "
+    "}\n};\n\n// pmapcar : mapcar with the calls spread over the thread "
+    "pool\nstruct Pmapcar final : public Expression {\n    explicit "
+    "Pmapcar(Args values) : Expression(std::move(values)) {}\n    ~Pmapcar() "
+    "override = default;\n    Variable operator()() const override {\n        "
+    "PROFILE(\"pmapcar\");\n        auto f = _values[0]->operator()();\n       "
+    " std::vector<std::shared_ptr<List>> lists;\n        std::size_t size = "
+    "SIZE_MAX;\n        for (std::size_t i = 1; i < _values.size(); i++) {\n   "
+    "         lists.push_back(to_list(_values[i]->operator()()));\n            "
+    "size = std::min(size, lists.back()->_value.size());\n        }\n        "
+    "std::vector<Variable> result(size);\n        // a few chunks per thread, "
+    "so that stealing can balance uneven calls\n        const std::size_t "
+    "chunk =\n            std::max<std::size_t>(1, size / (pool().size() * "
+    "4));\n        TaskGroup group;\n        for (std::size_t begin = 0; begin "
+    "< size; begin += chunk)\n            group.run([&, begin] {\n             "
+    "   std::vector<Variable> args(lists.size());\n                for "
+    "(std::size_t i = begin; i < std::min(begin + chunk, size);\n              "
+    "       i++) {\n                    for (std::size_t j = 0; j < "
+    "lists.size(); j++)\n                        args[j] = "
+    "lists[j]->_value[i];\n                    result[i] = call(f, "
+    "args.data(), args.size());\n                }\n            });\n        "
+    "group.wait();\n        return make_list(std::move(result));\n    "
+    "}\n};\n\n#pragma endregion Parallel\n\n// lisp memoization\n#pragma "
+    "region Memoization\n\n// MemoCache : the results of a memoized function, "
+    "keyed on its arguments\n// compared with equal, never freed so that "
+    "print_stats can report it\nstruct MemoCache {\n    struct Hash {\n        "
+    "std::size_t operator()(const std::vector<Variable> &key) const {\n        "
+    "    std::size_t hash = key.size();\n            for (const auto &v : "
+    "key)\n                hash = hash_combine(hash, hash_value(v, true));\n   "
+    "         return hash;\n        }\n    };\n    struct Equal {\n        "
+    "bool operator()(const std::vector<Variable> &a,\n                        "
+    "const std::vector<Variable> &b) const {\n            for (std::size_t i = "
+    "0; i < a.size(); i++)\n                if (!equal(a[i], b[i]))\n          "
+    "          return false;\n            return true;\n        }\n    };\n\n  "
+    "  const char *_name;\n    std::size_t _capacity;\n    std::mutex "
+    "_mutex;\n    std::unordered_map<std::vector<Variable>, Variable, Hash, "
+    "Equal> _entries;\n    // the keys in insertion order, a ring once the "
+    "cache is full\n    std::vector<const std::vector<Variable> *> _order;\n   "
+    " std::size_t _oldest = 0;\n    std::atomic<std::uint64_t> _hits{0};\n    "
+    "std::atomic<std::uint64_t> _misses{0};\n    MemoCache *_next = "
+    "nullptr;\n};\n\ninline std::atomic<MemoCache *> "
+    "memo_caches{nullptr};\n\n// memo_size : entries kept by a memoized "
+    "function, LISP_MEMO_SIZE or 1M\n[[nodiscard]] inline std::size_t "
+    "memo_size() {\n    static const std::size_t size = [] {\n        const "
+    "char *env = std::getenv(\"LISP_MEMO_SIZE\");\n        return env && *env "
+    "? std::strtoull(env, nullptr, 10) : 1 << 20;\n    }();\n    return "
+    "size;\n}\n\n// memo : evaluate the body of a function once for each set "
+    "of arguments,\n// the oldest entry is evicted when the cache is "
+    "full\nstruct Memo final : public Expression {\n    explicit Memo(Args "
+    "values) = delete;\n    ~Memo() override = default;\n    explicit "
+    "Memo(const char *name, std::size_t args_count, std::size_t size,\n        "
+    "          Args values)\n        : Expression(std::move(values)), "
+    "_args_count(args_count),\n          _cache(new MemoCache{name, size ? "
+    "size : memo_size()}) {\n        _cache->_next = memo_caches.load();\n     "
+    "   while (!memo_caches.compare_exchange_weak(_cache->_next, _cache)) {\n  "
+    "      }\n    }\n    Variable operator()() const override {\n        "
+    "std::vector<Variable> key(frame, frame + _args_count);\n        {\n       "
+    "     std::lock_guard<std::mutex> lock(_cache->_mutex);\n            if "
+    "(const auto it = _cache->_entries.find(key);\n                it != "
+    "_cache->_entries.end()) {\n                _cache->_hits.fetch_add(1, "
+    "std::memory_order_relaxed);\n                return it->second;\n         "
+    "   }\n        }\n        _cache->_misses.fetch_add(1, "
+    "std::memory_order_relaxed);\n        auto result = "
+    "_values[0]->operator()();\n        std::lock_guard<std::mutex> "
+    "lock(_cache->_mutex);\n        if (!_cache->_capacity || "
+    "_cache->_entries.count(key))\n            return result;\n        auto "
+    "&order = _cache->_order;\n        if (order.size() == "
+    "_cache->_capacity)\n            "
+    "_cache->_entries.erase(_cache->_entries.find(*order[_cache->_oldest]));\n "
+    "       const auto it = _cache->_entries.emplace(std::move(key), "
+    "result).first;\n        if (order.size() < _cache->_capacity) {\n         "
+    "   order.push_back(&it->first);\n        } else {\n            "
+    "order[_cache->_oldest] = &it->first;\n            _cache->_oldest = "
+    "(_cache->_oldest + 1) % _cache->_capacity;\n        }\n        return "
+    "result;\n    }\n    std::size_t _args_count;\n    MemoCache "
+    "*_cache;\n};\n\n// print_memo_stats : hit and miss counters of the "
+    "memoized functions\ninline void print_memo_stats() {\n    if "
+    "(!memo_caches.load())\n        return;\n    fprintf(stderr, \"\\n%-20s "
+    "%14s %14s %14s\\n\", \"memoized function\", \"hits\",\n            "
+    "\"misses\", \"entries\");\n    for (auto c = memo_caches.load(); c; c = "
+    "c->_next)\n        fprintf(stderr, \"%-20s %14llu %14llu %14zu\\n\", "
+    "c->_name,\n                static_cast<unsigned long long>(c->_hits),\n   "
+    "             static_cast<unsigned long long>(c->_misses),\n               "
+    " c->_entries.size());\n}\n\n#pragma endregion Memoization\n\n// "
+    "definitions\n#pragma region Definitions\n\n// clang-format off\n\n/* "
+    "symbols are looked up by name once, when the expression is built, so "
+    "the\n   code of a function does not depend on the symbols of other "
+    "functions */\n#define SYMBOL(name) "
+    "make_expression<SymbolFunction>(\"SymbolFunction\", "
+    "intern(name))\n#define INT(value) "
+    "make_expression<IntFunction>(\"IntFunction\", value)\n#define "
+    "BIGINT(value) make_expression<BigIntFunction>(\"BigIntFunction\", "
+    "value)\n#define FLOAT(value) "
+    "make_expression<FloatFunction>(\"FloatFunction\", value)\n#define "
+    "STRING(value) make_expression<StringFunction>(\"StringFunction\", "
+    "value)\n#define LIST(...) make_expression<ListFunction>(\"ListFunction\", "
+    "Args({__VA_ARGS__}))\n#define QUOTED(value) "
+    "make_expression<QuotedFunction>(\"QuotedFunction\", "
+    "Args({value}))\n#define CONSTANT(name) "
+    "make_expression<Constant>(\"Constant\", name())\n/* a constant of the "
+    "program, declared with the functions so that every file\n   of a split "
+    "program shares it */\n#define DEFCONSTANT(name, ...)\\\ninline const "
+    "Variable &name() {\\\n    static const Variable value = "
+    "(__VA_ARGS__)->operator()();\\\n    return value;\\\n}\n#define T() "
+    "make_expression<TFunction>(\"TFunction\")\n#define NIL() "
+    "make_expression<NilFunction>(\"NilFunction\")\n#define FUNC(name, ...) "
+    "make_expression<name>(#name, Args({__VA_ARGS__}))\n#define LOCAL(index) "
+    "make_expression<LocalFunction>(\"LocalFunction\", index)\n#define "
+    "LET(first, ...) make_expression<Let>(\"Let\", first, "
+    "Args({__VA_ARGS__}))\n#define SETQ(index, value) "
+    "make_expression<Setq>(\"Setq\", index, Args({value}))\n#define "
+    "FIXNUM_SLOT(index) make_expression<FixnumSlot>(\"FixnumSlot\", "
+    "index)\n#define DOUBLE_SLOT(index) "
+    "make_expression<DoubleSlot>(\"DoubleSlot\", index)\n#define "
+    "SET_FIXNUM(index, value) make_expression<SetFixnum>(\"SetFixnum\", index, "
+    "Args({value}))\n#define SET_DOUBLE(index, value) "
+    "make_expression<SetDouble>(\"SetDouble\", index, Args({value}))\n#define "
+    "DOTIMES(index, ...) make_expression<Dotimes>(\"Dotimes\", index, "
+    "Args({__VA_ARGS__}))\n#define DOLIST(index, ...) "
+    "make_expression<Dolist>(\"Dolist\", index, Args({__VA_ARGS__}))\n#define "
+    "LOOP(until, ...) make_expression<Loop>(\"Loop\", until, "
+    "Args({__VA_ARGS__}))\n#define MAKE_ARRAY(element, ...) "
+    "make_expression<MakeArray>(\"MakeArray\", Vector::Element::element, "
+    "Args({__VA_ARGS__}))\n#define MEMO(lisp_name, args_count, size, body) "
+    "make_expression<Memo>(\"Memo\", lisp_name, args_count, size, "
+    "Args({body}))\n#define MAKE_HASH_TABLE(structural) "
+    "make_expression<MakeHashTable>(\"MakeHashTable\", structural)\n#define "
+    "CAPTURED(index) make_expression<CapturedFunction>(\"CapturedFunction\", "
+    "index)\n#define FUNCTION(name) "
+    "make_expression<FunctionRef>(\"FunctionRef\", &name::apply, name::arity, "
+    "name::lisp)\n#define CLOSURE(name, ...) "
+    "make_expression<Closure>(\"Closure\", &name::apply, name::arity, "
+    "Args({__VA_ARGS__}))\n#define LAMBDA(name, args_count)\\\nstruct name "
+    "{\\\n    static constexpr std::size_t arity = args_count;\\\n    static "
+    "Variable apply(const Variable *args, const Variable "
+    "*captured);\\\n};\n#define LAMBDA_BODY(name, locals_count, natives_count, "
+    "...)\\\nVariable name::apply(const Variable *args, const Variable "
+    "*captured) {\\\n    PROFILE(\"lambda\");\\\n    check_stack();\\\n    "
+    "std::array<Variable, locals_count> locals;\\\n    std::array<Unboxed, "
+    "natives_count> natives;\\\n    std::copy(args, args + arity, "
+    "locals.begin());\\\n    FrameScope scope(locals.data(), captured, "
+    "natives.data());\\\n    static const Function body = __VA_ARGS__;\\\n    "
+    "return body->operator()();\\\n}\n/* kinds has a letter per argument: b "
+    "for boxed, f for fixnum and d for\n   double-float, the typed arguments "
+    "go to the unboxed slot of their index */\n/* a function of another "
+    "module, called through its exported apply */\n#define IMPORT(name, "
+    "symbol, lisp_name, args_count)\\\nstruct name final : public Expression "
+    "{\\\n    static constexpr std::size_t arity = args_count;\\\n    static "
+    "constexpr const char *lisp = lisp_name;\\\n    explicit name(Args values) "
+    ": Expression(std::move(values)) {}\\\n    ~name() override = default;\\\n "
+    "   static Variable apply(const Variable *args, const Variable *captured) "
+    "{\\\n        return symbol(args, captured);\\\n    }\\\n    Variable "
+    "operator()() const override {\\\n        std::array<Variable, args_count> "
+    "args;\\\n        for (std::size_t i = 0; i < args_count; i++)\\\n         "
+    "   args[i] = _values[i]->operator()();\\\n        return "
+    "symbol(args.data(), nullptr);\\\n    }\\\n};\n#define "
+    "IMPORT_FUNCTION(symbol) Variable symbol(const Variable *args, const "
+    "Variable *captured);\n#define IMPORT_MODULE(init) void init();\n#define "
+    "EXPORT(name, symbol) Variable symbol(const Variable *args, const Variable "
+    "*captured) { return name::apply(args, captured); }\n#define "
+    "MODULE_INIT(init) void init() { run_program(); }\n#define INITIALIZE(...) "
+    "void initialize() { __VA_ARGS__ }\n/* DEF declares a function and "
+    "DEF_BODY defines its body, every DEF comes\n   before the bodies so that "
+    "functions can call the ones defined after them */\n#define DEF(name, "
+    "lisp_name, args_count, locals_count, natives_count, kinds)\\\nstruct name "
+    "final : public Expression {\\\n    static constexpr std::size_t arity = "
+    "args_count;\\\n    static constexpr const char *lisp = lisp_name;\\\n    "
+    "static constexpr const char *types = kinds;\\\n    using Locals = "
+    "std::array<Variable, locals_count>;\\\n    using Natives = "
+    "std::array<Unboxed, natives_count>;\\\n    explicit name(Args values) : "
+    "Expression(std::move(values)) {}\\\n    ~name() override = default;\\\n   "
+    " static const Function &body();\\\n    template <typename R> static R "
+    "run(Locals &locals, Natives &natives, R (Expression::*eval)() const) "
+    "{\\\n        PROFILE(lisp_name);\\\n        check_stack();\\\n        "
+    "FrameScope scope(locals.data(), nullptr, natives.data());\\\n        "
+    "return (*body().*eval)();\\\n    }\\\n    static Variable apply(const "
+    "Variable *args, const Variable *) {\\\n        Locals locals;\\\n        "
+    "Natives natives;\\\n        for (std::size_t i = 0; i < args_count; "
+    "i++)\\\n            if (types[i] == 'f')\\\n                "
+    "natives[i].fixnum = unbox_fixnum(args[i]);\\\n            else if "
+    "(types[i] == 'd')\\\n                natives[i].real = "
+    "unbox_double(args[i]);\\\n            else\\\n                locals[i] = "
+    "args[i];\\\n        return run(locals, natives, "
+    "&Expression::operator());\\\n    }\\\n    template <typename R> R call(R "
+    "(Expression::*eval)() const) const {\\\n        Locals locals;\\\n        "
+    "Natives natives;\\\n        for (std::size_t i = 0; i < args_count; "
+    "i++)\\\n            if (types[i] == 'f')\\\n                "
+    "natives[i].fixnum = _values[i]->as_fixnum();\\\n            else if "
+    "(types[i] == 'd')\\\n                natives[i].real = "
+    "_values[i]->as_double();\\\n            else\\\n                locals[i] "
+    "= _values[i]->operator()();\\\n        return run(locals, natives, "
+    "eval);\\\n    }\\\n    Variable operator()() const override { return "
+    "call(&Expression::operator()); }\\\n    long long as_fixnum() const "
+    "override { return call(&Expression::as_fixnum); }\\\n    double "
+    "as_double() const override { return call(&Expression::as_double); }\\\n   "
+    " bool as_bool() const override { return call(&Expression::as_bool); "
+    "}\\\n};\n#define DEF_BODY(name, ...)\\\nconst Function &name::body() "
+    "{\\\n    static const Function body = __VA_ARGS__;\\\n    return "
+    "body;\\\n}\n// clang-format on\n\n#pragma endregion Definitions\n\n// the "
+    "code of the program, a program split in several files shares the\n// code "
+    "above as a header\n#pragma region Program\n\n// the definitions of a "
+    "program split in several files are in a named\n// namespace shared by its "
+    "files, inline so that the entry points see them\n#ifndef "
+    "LISP_NAMESPACE\n#define LISP_NAMESPACE\n#endif\n\n// the functions and "
+    "initializers of the imported modules\n$5\n\n// the definitions of a "
+    "module do not clash with the ones of other modules\ninline namespace "
+    "LISP_NAMESPACE {\n\n$1\n\n// run the top-level forms in order\nvoid "
+    "run_program() {\n    std::array<Variable, $3> locals;\n    "
+    "std::array<Unboxed, $4> unboxed;\n    FrameScope scope(locals.data(), "
+    "nullptr, unboxed.data());\n    const auto program = "
+    "std::make_shared<Progn>(Args({\n\n        // start of the program\n\n     "
+    "   $2\n\n        // end of the program\n\n    }));\n\n    "
+    "program->execute();\n}\n\n} // namespace\n\n// the exported functions, "
+    "with the module initializer or the program entry\n$6\n\n#ifndef "
+    "LISP_MODULE\n\nint main() {\n    return run_on_stack([] {\n        try "
+    "{\n            initialize();\n            run_program();\n\n        } "
+    "catch (const std::exception &e) {\n            output.flush();\n          "
+    "  std::cerr << \"Runtime Error: \" << e.what() << std::endl;\n            "
+    "return 1;\n        }\n\n        return 0;\n    "
+    "});\n}\n\n#endif\n\n#pragma endregion Program\n";
 
 }; // namespace generator
 
@@ -1,5 +1,6 @@
 #ifndef TOKEN_H
 #define TOKEN_H
+#include <cstddef>
 #include <optional>
 #include <string>
 
@@ -19,6 +20,7 @@ enum class TokenType {
   LParen,
   RParen,
   Quote,
+  FunctionQuote,
   Null, // keywords
   Not,
   If,
@@ -32,6 +34,41 @@ enum class TokenType {
   List,
   Progn,
   Print,
+  MakeArray,
+  Aref,
+  Setf,
+  Length,
+  VectorAdd,
+  VectorMul,
+  VectorDot,
+  VectorSum,
+  VectorMin,
+  VectorMax,
+  Mapcar,
+  Reduce,
+  Append,
+  Reverse,
+  Nth,
+  Member,
+  Assoc,
+  Function,
+  Pcall,
+  Pmapcar,
+  DefineMemoFunction,
+  Declare,
+  MakeHashTable,
+  Gethash,
+  Remhash,
+  HashTableCount,
+  Eq,
+  Setq,
+  Dotimes,
+  Dolist,
+  Loop,
+  Lambda,
+  Funcall,
+  Declaim,
+  The,
   Identifier, // atoms
   Integer,
   Floating,
@@ -42,15 +79,21 @@ enum class TokenType {
 class Token {
 public:
   explicit Token(const TokenType type,
-                 const std::optional<std::string> &value = std::nullopt)
-      : _type(type), _value(value) {}
+                 const std::optional<std::string> &value = std::nullopt,
+                 const std::size_t line = 0, const std::size_t column = 0)
+      : _type(type), _value(value), _line(line), _column(column) {}
 
   [[nodiscard]] TokenType getType() const { return _type; }
   [[nodiscard]] std::optional<std::string> getValue() const { return _value; }
+  // where the token starts in the source, from 1, 0 for the end of tokens
+  [[nodiscard]] std::size_t getLine() const { return _line; }
+  [[nodiscard]] std::size_t getColumn() const { return _column; }
 
 private:
   TokenType _type;
   std::optional<std::string> _value;
+  std::size_t _line;
+  std::size_t _column;
 };
 
 } // namespace lexer::token
@@ -9,10 +9,11 @@ COMMON_LISP_COMPILER="sbcl --script"
 total_tests=0
 passed_tests=0
 
-# Run tests in a folder
+# Run tests in a folder, the arguments after the type are compiler options
 run_tests() {
     local folder="$1"
     local test_type="$2"
+    local options=("${@:3}")
 
     for file in "$folder"/*.lisp "$folder"/*.lsp; do
         [[ -f "$file" ]] || continue
@@ -23,7 +24,7 @@ run_tests() {
 
         case "$test_type" in
             "compile")
-                "$COMPILER" "$file" &>/dev/null
+                "$COMPILER" "${options[@]}" "$file" &>/dev/null
                 if [[ $? -eq 0 ]]; then
                     echo "[PASS] Successfully compiled: $file"
                     ((passed_tests++))
@@ -33,17 +34,21 @@ run_tests() {
                 ;;
 
             "compile-error")
-                "$COMPILER" "$file" &>/dev/null
-                if [[ $? -ne 0 ]]; then
+                # a "; error: " comment gives text the message must contain
+                expected="$(sed -n 's/^; error: //p' "$file")"
+                errors="$("$COMPILER" "${options[@]}" "$file" 2>&1 >/dev/null)"
+                if [[ $? -eq 0 ]]; then
+                    echo "[FAIL] Compilation unexpectedly succeeded: $file"
+                elif [[ "$errors" != *"$expected"* ]]; then
+                    echo "[FAIL] Expected error \"$expected\", got: $errors"
+                else
                     echo "[PASS] Correctly failed to compile: $file"
                     ((passed_tests++))
-                else
-                    echo "[FAIL] Compilation unexpectedly succeeded: $file"
                 fi
                 ;;
 
             "exec")
-                "$COMPILER" "$file" &>/dev/null
+                "$COMPILER" "${options[@]}" "$file" &>/dev/null
                 if [[ $? -eq 0 ]]; then
                     # Run the output file
                     "$output_file" >"$output_file.actual" 2>/dev/null
@@ -68,7 +73,7 @@ run_tests() {
                 ;;
 
             "runtime-error")
-                "$COMPILER" "$file" &>"$output_file"
+                "$COMPILER" "${options[@]}" "$file" &>"$output_file"
                 if [[ $? -eq 0 ]]; then
                     # Run the output file and check for runtime errors
                     "$output_file" &>/dev/null
@@ -86,11 +91,110 @@ run_tests() {
     done
 }
 
+# Run the module tests, each directory is a program: main.lisp is linked with
+# the other files compiled as modules in order, each importing the previous
+# ones, and its output must match the files run one after the other
+run_module_tests() {
+    for dir in "$TEST_DIR"/module/*/; do
+        [[ -f "${dir}main.lisp" ]] || continue
+        ((total_tests++))
+
+        local imports=() sources=() failed=0
+        for file in "$dir"*.lisp; do
+            [[ "$file" == "${dir}main.lisp" ]] && continue
+            "$COMPILER" --module "${imports[@]}" "$file" &>/dev/null || failed=1
+            imports+=("--import=${file%.lisp}.lispi")
+            sources+=("$file")
+        done
+        "$COMPILER" "${imports[@]}" "${dir}main.lisp" &>/dev/null || failed=1
+
+        if [[ $failed -eq 0 ]]; then
+            local combined
+            combined="$(mktemp -d)/$(basename "$dir").lisp"
+            cat "${sources[@]}" "${dir}main.lisp" >"$combined"
+            "${dir}main.lisp.out" >"${dir}main.actual" 2>/dev/null
+            $COMMON_LISP_COMPILER "$combined" >"${dir}main.expected" 2>/dev/null
+            if diff -wB "${dir}main.expected" "${dir}main.actual" &>/dev/null; then
+                echo "[PASS] Output matches: $dir"
+                ((passed_tests++))
+            else
+                echo "[FAIL] Output mismatch: $dir"
+                echo "[INFO] Expected:\n$(cat "${dir}main.expected")"
+                echo "[INFO] Got:\n$(cat "${dir}main.actual")"
+            fi
+            rm -rf "$(dirname "$combined")"
+        else
+            echo "[FAIL] Module compilation failed: $dir"
+        fi
+
+        # Clean up
+        rm -f "$dir"*.o "$dir"*.lispi "${dir}main.expected" "${dir}main.actual"
+    done
+}
+
+run_incremental_tests() {
+    for dir in "$TEST_DIR"/incremental/*/; do
+        [[ -f "${dir}1.lisp" ]] || continue
+        ((total_tests++))
+
+        # every version is compiled in turn over the cache of the previous
+        # one, its first line lists the units it must recompile
+        local work failed=0
+        work="$(mktemp -d)"
+        for file in $(ls "$dir"*.lisp | sort -V); do
+            cp "$file" "$work/program.lisp"
+            local expected actual
+            expected="$(head -n 1 "$file" | sed 's/^; //')"
+            actual="$("$COMPILER" --incremental "$work/program.lisp" 2>/dev/null | grep '^Recompiled')"
+            if [[ "$actual" != "$expected" ]]; then
+                echo "[FAIL] Incremental build mismatch: $file"
+                echo "[INFO] Expected: $expected"
+                echo "[INFO] Got: $actual"
+                failed=1
+                break
+            fi
+            "$work/program.lisp.out" >"$work/actual" 2>/dev/null
+            $COMMON_LISP_COMPILER "$file" >"$work/expected" 2>/dev/null
+            if ! diff -wB "$work/expected" "$work/actual" &>/dev/null; then
+                echo "[FAIL] Output mismatch: $file"
+                echo "[INFO] Expected:\n$(cat "$work/expected")"
+                echo "[INFO] Got:\n$(cat "$work/actual")"
+                failed=1
+                break
+            fi
+        done
+        if [[ $failed -eq 0 ]]; then
+            echo "[PASS] Incremental builds match: $dir"
+            ((passed_tests++))
+        fi
+
+        # Clean up
+        rm -rf "$work"
+    done
+}
+
+# Check that the compiler scales linearly with the size of the program, on
+# the generated programs of bench/scaling.sh
+run_scaling_tests() {
+    local line
+    while read -r line; do
+        ((total_tests++))
+        echo "$line"
+        [[ "$line" == "[PASS]"* ]] && ((passed_tests++))
+    done < <(bench/scaling.sh 10000)
+}
+
 # Run all test cases
 run_tests "$TEST_DIR/compile" "compile"
 run_tests "$TEST_DIR/compile-fail" "compile-error"
 run_tests "$TEST_DIR/exec" "exec"
 run_tests "$TEST_DIR/exec-fail" "runtime-error"
+run_tests "$TEST_DIR/parallel" "exec" --jobs=4
+run_tests "$TEST_DIR/release" "exec" --release --pgo
+run_tests "$TEST_DIR/debug" "exec" -g
+run_module_tests
+run_incremental_tests
+run_scaling_tests
 
 # Summary
 echo "Total tests: $total_tests"
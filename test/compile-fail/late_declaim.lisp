@@ -0,0 +1,5 @@
+; the safety applies to the whole program, code before it is already checked
+; error: late_declaim.lisp:5: Declamation after the first form
+(defun f (x) (car x))
+(print (f 5))
+(declaim (optimize (safety 0)))
@@ -0,0 +1,3 @@
+; print may not run in parallel
+(defun show (x) (print x))
+(print (pmapcar #'show '(1 2 3)))
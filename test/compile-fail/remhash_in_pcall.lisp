@@ -0,0 +1,5 @@
+; a function changing a hash table may not be called in parallel
+(defun forget (table k) (remhash k table))
+(defun pair (a b) (list a b))
+(let ((table (make-hash-table)))
+  (print (pcall #'pair (forget table 1) (forget table 2))))
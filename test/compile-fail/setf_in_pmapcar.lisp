@@ -0,0 +1,4 @@
+; the hash tables and vectors are not locked, so they may not be changed in
+; parallel
+(let ((table (make-hash-table)))
+  (print (pmapcar (lambda (k) (setf (gethash k table) k)) '(1 2 3))))
@@ -0,0 +1,5 @@
+; wrong number of arguments
+; error: wrong_arity.lisp:5: Invalid number of arguments to add: expected 2, got 3
+(defun add (x y) (+ x y))
+(print 1)
+(print (add 1 2 3))
@@ -0,0 +1,9 @@
+; unused functions and pure top-level forms are removed before emission
+(defun double (x) (* x 2))
+(defun unused (x) (double x))
+(defun increment (x) (+ x 1))
+(defun apply-twice (x) (increment (increment x)))
+(list 1 2 3)
+'discarded
+(let ((a 1)) (cons a nil))
+(print (apply-twice 5))
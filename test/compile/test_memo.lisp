@@ -0,0 +1,15 @@
+; test memoization
+(defun-memo fib (n)
+  (if (< n 2)
+      n
+      (+ (fib (- n 1)) (fib (- n 2)))))
+(print (fib 90))
+
+(defun paths (r c)
+  (declare (memoize 10000))
+  (if (= r 0)
+      1
+      (if (= c 0)
+          1
+          (+ (paths (- r 1) c) (paths r (- c 1))))))
+(print (paths 16 16))
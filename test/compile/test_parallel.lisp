@@ -0,0 +1,6 @@
+; test parallel
+(defun square (x) (* x x))
+(defun sum3 (a b c) (+ a (+ b c)))
+(print (pcall #'sum3 (square 2) (let ((x 3)) (square x)) (square 4)))
+(print (pmapcar #'square '(1 2 3 4 5)))
+(print (pmapcar #'+ '(1 2 3) '(10 20 30)))
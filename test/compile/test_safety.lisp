@@ -0,0 +1,5 @@
+; compile without the dynamic type checks
+(declaim (optimize (speed 3) (safety 0)))
+(defun sum-list (items acc)
+  (if (null items) acc (sum-list (cdr items) (+ acc (car items)))))
+(print (sum-list (list 1 2 3 4) 0))
@@ -0,0 +1,14 @@
+; fixnum and double-float declarations keep the variables unboxed
+(defun norm2 (x y)
+  (declare (type double-float x y))
+  (+ (* x x) (* y y)))
+(print (norm2 3.0 4.0))
+(defun average (total count)
+  (declare (double-float total) (fixnum count))
+  (/ total count))
+(print (average 10.0 4))
+(let ((sum 0.0) (n 10))
+  (declare (double-float sum) (fixnum n))
+  (dotimes (i n)
+    (setq sum (+ sum (* i 0.5))))
+  (print (the double-float sum)))
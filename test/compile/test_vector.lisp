@@ -0,0 +1,11 @@
+; test vector
+(let ((a (make-array 10 :element-type 'fixnum :initial-element 3))
+      (b (make-array 10 :element-type 'double-float :initial-element 0.5)))
+  (progn
+    (print (vector-add a a))
+    (print (vector-mul a b))
+    (print (vector-dot b b))
+    (print (vector-sum a))
+    (print (vector-min b))
+    (print (vector-max a))))
+(print (make-array 3 :initial-element "x"))
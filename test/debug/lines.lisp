@@ -0,0 +1,13 @@
+; compiled with -g, the functions and forms are mapped to these lines
+#| comments keep
+   the lines of the forms after them |#
+(defun add-all (items)
+  (reduce #'+ items))
+
+(defun scale (items factor)
+  (mapcar (lambda (x) (* x factor))
+          items))
+
+(print (add-all (scale '(1 2 3) 10)))
+(print "()") ; () in a string is not nil
+(print ())
@@ -0,0 +1 @@
+(aref (make-array 3 :element-type 'fixnum) 3)
@@ -0,0 +1,2 @@
+; dead code elimination keeps a form that may fail at run time
+(cons 1 2)
@@ -0,0 +1,16 @@
+; fixnum overflow promotes to bignum
+(defun factorial (n)
+  (if (<= n 1)
+      1
+      (* n (factorial (- n 1)))))
+
+(print (factorial 13))
+(print (factorial 25))
+(print (+ 9223372036854775807 1))
+(print (- -9223372036854775808 1))
+(print (* 123456789012345678901234567890 -987654321098765432109876543210))
+(print (/ (factorial 30) (factorial 28)))
+(print (- (factorial 30) (factorial 30)))
+(print (< (factorial 20) (factorial 21)))
+(print (= (factorial 22) (* 22 (factorial 21))))
+(print (/ (factorial 300) (factorial 290)))
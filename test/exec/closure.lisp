@@ -0,0 +1,37 @@
+(defun make-adder (n)
+  (lambda (x) (+ x n)))
+
+(defun compose (f g)
+  (lambda (x) (funcall f (funcall g x))))
+
+(defun map-tree (f items)
+  (if (null items)
+      nil
+      (cons (funcall f (car items)) (map-tree f (cdr items)))))
+
+(defun scale (items factor)
+  (map-tree (lambda (x) (* x factor)) items))
+
+(defun countdown (n)
+  (if (= n 0)
+      0
+      (funcall (lambda (m) (+ 1 (countdown m))) (- n 1))))
+
+(print (funcall (make-adder 3) 4))
+(print (mapcar (make-adder 10) (list 1 2 3)))
+(print (funcall (compose (make-adder 1) (lambda (x) (* x 2))) 5))
+(print ((lambda (a b) (+ a b)) 1 2))
+(print (funcall #'(lambda (x) (* x x)) 7))
+(print (funcall #'+ 1 2))
+(print (reduce #'(lambda (a b) (+ a b)) (list 1 2 3 4)))
+(print (scale (list 1 2 3) 3))
+(print (countdown 5))
+(let ((k 5))
+  (print (mapcar (lambda (x)
+                   (let ((y (* x k)))
+                     (funcall (lambda () (+ y k)))))
+                 (list 1 2))))
+(defun shadowed (x)
+  (let ((g (lambda () x)))
+    (progn (let ((x 1)) (setq x 2)) (funcall g))))
+(print (shadowed 5))
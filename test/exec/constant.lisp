@@ -0,0 +1,16 @@
+; quoted lists and strings are built once and shared
+(defun table () '(1 2 (3 "x") sym))
+(defun greet () "hello")
+(defun lookup (i) (nth i '(10 20 30 40 50)))
+
+(defun sum-lookups (n)
+  (let ((sum 0))
+    (dotimes (i n sum)
+      (setq sum (+ sum (lookup 2))))))
+
+(print (table))
+(print (eq (table) (table)))
+(print (greet))
+(print (sum-lookups 1000))
+(print (cons 0 (table)))
+(print (table))
@@ -0,0 +1,8 @@
+; recursion deeper than the default 8 MiB stack of a thread
+(defun sum-to (n)
+  (if (= n 0)
+      0
+      (+ n (sum-to (- n 1)))))
+
+(print (sum-to 10))
+(print (sum-to 50000))
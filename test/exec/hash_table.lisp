@@ -0,0 +1,38 @@
+(defun fill-table (table i n)
+  (if (= i n)
+      table
+      (progn (setf (gethash i table) (* i i))
+             (fill-table table (+ i 1) n))))
+
+(defun remove-even (table i n)
+  (if (>= i n)
+      table
+      (progn (remhash i table)
+             (remove-even table (+ i 2) n))))
+
+(defun sum-table (table i n)
+  (if (= i n)
+      0
+      (+ (gethash i table 0) (sum-table table (+ i 1) n))))
+
+(let ((table (remove-even (fill-table (make-hash-table) 0 1000) 0 1000)))
+  (progn
+    (print (hash-table-count table))
+    (print (gethash 7 table))
+    (print (gethash 8 table))
+    (print (gethash 8 table 'missing))
+    (print (sum-table table 0 1000))))
+
+(let ((table (make-hash-table :test #'equal)))
+  (progn
+    (setf (gethash (list 1 2) table) 'pair)
+    (setf (gethash "key" table) 'string)
+    (setf (gethash 'symbol table) 'symbol)
+    (setf (gethash (list 1 2) table) 'updated)
+    (print (gethash (list 1 2) table))
+    (print (gethash "key" table))
+    (print (gethash 'symbol table))
+    (print (hash-table-count table))
+    (print (remhash "key" table))
+    (print (remhash "key" table))
+    (print (hash-table-count table))))
@@ -0,0 +1,37 @@
+(defun sum-below (n)
+  (let ((total 0))
+    (progn
+      (dotimes (i n)
+        (setq total (+ total i)))
+      total)))
+
+(defun count-down (n)
+  (let ((steps 0))
+    (progn
+      (loop while (> n 0)
+            do (setq n (- n 1))
+               (setq steps (+ steps 1)))
+      steps)))
+
+(defun reverse-list (items)
+  (let ((result nil))
+    (dolist (item items result)
+      (setq result (cons item result)))))
+
+(print (sum-below 1000000))
+(print (count-down 100000))
+(print (reverse-list (list 1 2 3 4)))
+(print (dotimes (i 5 i)))
+(print (dolist (x (list 1 2 3))))
+(let ((k 0))
+  (progn
+    (loop until (>= k 10) do (setq k (+ k 3)))
+    (print k)))
+(let ((a 1) (b 2))
+  (progn
+    (setq a b b 5)
+    (print (list a b))))
+(let ((kept nil))
+  (progn
+    (dotimes (i 3) (setq kept (cons i kept)))
+    (print kept)))
@@ -0,0 +1,18 @@
+; sequence functions
+(defun square (x) (* x x))
+
+(print (mapcar #'square '(1 2 3 4)))
+(print (mapcar #'+ '(1 2 3) '(10 20 30 40)))
+(print (reduce #'+ '(1 2 3 4 5)))
+(print (reduce #'+ '(1 2 3) :initial-value 100))
+(print (append '(1 2) nil '(3) '(4 5)))
+(print (reverse '(1 2 3)))
+(print (nth 1 '(a b c)))
+(print (nth 5 '(a b c)))
+(print (member 2 '(1 2 3)))
+(print (member 'b '(a b c)))
+(print (assoc 'b '((a 1) (b 2))))
+(print (assoc 'z '((a 1))))
+(print (length (mapcar #'square '(1 2 3))))
+(print (member -0.0 (list 0.0)))
+(print (assoc -0.0 (list (list 0.0 1))))
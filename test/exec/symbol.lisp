@@ -0,0 +1,17 @@
+(defun shape-sides (shape)
+  (if (eq shape 'triangle)
+      3
+      (if (eq shape 'Square)
+          4
+          0)))
+
+(print (shape-sides 'triangle))
+(print (shape-sides 'SQUARE))
+(print (shape-sides 'circle))
+(print (eq 'apple 'Apple))
+(print (eq 'apple 'banana))
+(print (eq (list 1 2) (list 1 2)))
+(print (eq nil nil))
+(print (assoc 'green (list (list 'red 1) (list 'green 2) (list 'blue 3))))
+(print (member 'c (list 'a 'b 'c 'd)))
+(print 'mixed-Case-symbol)
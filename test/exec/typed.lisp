@@ -0,0 +1,29 @@
+(defun fib (n)
+  (declare (type fixnum n))
+  (if (< n 2) n (+ (fib (- n 1)) (fib (- n 2)))))
+
+(defun sum-below (n)
+  (declare (fixnum n))
+  (let ((total 0))
+    (declare (type fixnum total))
+    (dotimes (i n total)
+      (setq total (+ total i)))))
+
+(defun count-down (n)
+  (declare (type fixnum n))
+  (let ((steps 0))
+    (declare (type fixnum steps))
+    (progn
+      (loop while (> n 0)
+            do (setq n (- n 3))
+               (setq steps (+ steps 1)))
+      steps)))
+
+(print (fib 20))
+(print (sum-below 100000))
+(print (count-down 1000))
+(print (the fixnum (+ 40 2)))
+(print (mapcar #'fib (list 1 2 3 4 5 6)))
+(let ((x 12) (y 5))
+  (declare (fixnum x y))
+  (print (list (+ x y) (- x y) (* x y) (< x y) (>= x y) (/= x y))))
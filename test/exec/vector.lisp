@@ -0,0 +1,16 @@
+; vector
+(defun fill-vector (v i n)
+  (if (= i n)
+      v
+      (progn
+        (setf (aref v i) (* i i))
+        (fill-vector v (+ i 1) n))))
+
+(let ((v (fill-vector (make-array 6 :element-type 'fixnum) 0 6)))
+  (progn
+    (print (aref v 5))
+    (print (length v))
+    (print (setf (aref v 0) 7))
+    (print (aref v 0))))
+(print (length (list 1 2 3)))
+(print (length nil))
@@ -0,0 +1,7 @@
+; Recompiled 4 unit(s): L_adder L_square L_sum_squares program
+(defun square (x) (* x x))
+(defun sum-squares (lst) (reduce #'+ (mapcar #'square lst)))
+(defun adder (k) (lambda (x) (+ x k)))
+(print (square 12))
+(print (sum-squares (list 1 2 3)))
+(print (funcall (adder 5) 10))
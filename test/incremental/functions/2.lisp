@@ -0,0 +1,7 @@
+; Recompiled 1 unit(s): L_square
+(defun square (x) (* x (+ x 0)))
+(defun sum-squares (lst) (reduce #'+ (mapcar #'square lst)))
+(defun adder (k) (lambda (x) (+ x k)))
+(print (square 12))
+(print (sum-squares (list 1 2 3)))
+(print (funcall (adder 5) 10))
@@ -0,0 +1,9 @@
+; Recompiled 4 unit(s): L_cube L_square L_sum_squares program
+(defun square (x) (let ((y x)) (* x y)))
+(defun sum-squares (lst) (reduce #'+ (mapcar #'square lst)))
+(defun adder (k) (lambda (x) (+ x k)))
+(defun cube (x) (* x (square x)))
+(print (square 12))
+(print (sum-squares (list 1 2 3)))
+(print (funcall (adder 5) 10))
+(print (cube 3))
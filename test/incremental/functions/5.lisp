@@ -0,0 +1,15 @@
+; Recompiled 1 unit(s): L_a
+(defun square (x) (let ((y x)) (* x y)))
+(defun sum-squares (lst) (reduce #'+ (mapcar #'square lst)))
+(defun adder (k) (lambda (x) (+ x k)))
+(defun cube (x) (* x (square x)))
+(print (square 12))
+(print (sum-squares (list 1 2 3)))
+(print (funcall (adder 5) 10))
+(print (cube 3))
+(defun a () (list "w" "x"))
+(defun b () '(1 2))
+(defun c () "z")
+(print (a))
+(print (b))
+(print (c))
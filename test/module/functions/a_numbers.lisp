@@ -0,0 +1,13 @@
+(defun square (x) (* x x))
+
+(defun sum-squares (n)
+  (declare (type fixnum n))
+  (let ((total 0))
+    (declare (type fixnum total))
+    (dotimes (i n total)
+      (setq total (+ total (square i))))))
+
+(defun kind (x)
+  (if (< x 0) 'negative 'positive))
+
+(print 'numbers-loaded)
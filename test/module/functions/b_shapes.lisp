@@ -0,0 +1,6 @@
+(defun cube (x) (* x (square x)))
+
+(defun volumes (sides)
+  (mapcar #'cube sides))
+
+(print (cube 2))
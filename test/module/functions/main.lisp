@@ -0,0 +1,6 @@
+(print (square 12))
+(print (sum-squares 10))
+(print (volumes (list 1 2 3)))
+(print (reduce #'+ (mapcar #'square (list 1 2 3))))
+(print (eq (kind -5) 'negative))
+(print (kind 5))
@@ -0,0 +1,25 @@
+; compiled with --jobs=4, the functions are spread over several files
+(defun square (x) (* x x))
+(defun cube (x) (* x (square x)))
+(defun sum-list (lst) (reduce #'+ lst))
+(defun squares (lst) (mapcar #'square lst))
+(defun firsts (lsts) (mapcar #'car lsts))
+(defun adder (k) (lambda (x) (+ x k)))
+(defun count-to (n)
+  (declare (fixnum n))
+  (let ((total 0))
+    (declare (fixnum total))
+    (dotimes (i n) (setq total (+ total i)))
+    total))
+(defun fib (n)
+  (declare (memoize))
+  (if (< n 2) n (+ (fib (- n 1)) (fib (- n 2)))))
+(defun classify (n) (if (< n 0) 'negative 'positive))
+(print (cube 3))
+(print (sum-list (squares (list 1 2 3 4))))
+(print (firsts (list (list 1 2) (list 3 4))))
+(print (funcall (adder 10) 5))
+(print (count-to 100))
+(print (fib 25))
+(print (eq (classify 5) 'positive))
+(print (classify -1))
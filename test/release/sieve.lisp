@@ -0,0 +1,20 @@
+; compiled with --release --pgo, the executable is trained on itself
+(defun cross-out (composite i n)
+  (let ((j (* i i)))
+    (loop while (< j n)
+          do (setf (aref composite j) 1)
+             (setq j (+ j i)))))
+
+(defun sieve (n)
+  (let ((composite (make-array n :element-type 'fixnum))
+        (count 0))
+    (dotimes (k (- n 2) count)
+      (let ((i (+ k 2)))
+        (if (= (aref composite i) 0)
+            (progn
+              (setq count (+ count 1))
+              (cross-out composite i n))
+            nil)))))
+
+(print (sieve 100))
+(print (sieve 100000))